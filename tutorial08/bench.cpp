@@ -0,0 +1,194 @@
+// 性能测试, 直接包含 tinyjson.cpp 以便测量其中的 static 函数
+#include "tinyjson.cpp"
+#include <chrono>
+#include <stdio.h>
+
+// 字符串化未优化版本, 只作为性能测试的对照
+static void tiny_stringify_string(tiny_context* c, const char* s, size_t len, bool) {
+    size_t i;
+    assert(s != nullptr);
+    PUTC(c, '"');
+    for (i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        switch (ch) {
+            case '\"': PUTS(c, "\\\"", 2); break;
+            case '\\': PUTS(c, "\\\\", 2); break;
+            case '\b': PUTS(c, "\\b",  2); break;
+            case '\f': PUTS(c, "\\f",  2); break;
+            case '\n': PUTS(c, "\\n",  2); break;
+            case '\r': PUTS(c, "\\r",  2); break;
+            case '\t': PUTS(c, "\\t",  2); break;
+            default:
+                if (ch < 0x20) {
+                    char buffer[7];
+                    sprintf(buffer, "\\u%04x", ch);
+                    PUTS(c, buffer, 6);
+                }
+                else PUTC(c, s[i]);
+        }
+    }
+    PUTC(c, '"');
+}
+
+/// @brief 按字节处理但提前开辟足够空间的版本, 只作为性能测试的对照
+/// @param c tiny_context
+/// @param s json 值中的字符串
+/// @param len 字符串长度
+static void tiny_stringify_string_reserved(tiny_context* c, const char* s, size_t len) {
+    static const char hex_digits[] = { '0', '1', '2', '3', '4', '5', '6', 
+        '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+    size_t i, size;
+    char *head, *p;
+    assert(s != nullptr);
+    // 开辟足够大的空间 "\u00xx..."
+    p = head = (char*)tiny_context_push(c, size = len * 6 + 2);
+    *p++ = '"';
+    for (i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        switch (ch) {
+            case '\"': *p++ = '\\'; *p++ = '\"'; break;
+            case '\\': *p++ = '\\'; *p++ = '\\'; break;
+            case '\b': *p++ = '\\'; *p++ = 'b';  break;
+            case '\f': *p++ = '\\'; *p++ = 'f';  break;
+            case '\n': *p++ = '\\'; *p++ = 'n';  break;
+            case '\r': *p++ = '\\'; *p++ = 'r';  break;
+            case '\t': *p++ = '\\'; *p++ = 't';  break;
+            default:
+                if (ch < 0x20) {
+                    *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
+                    *p++ = hex_digits[ch >> 4];  // 写入十位
+                    *p++ = hex_digits[ch & 15];  // 写入个位
+                }
+                else *p++ = s[i];
+        }
+    }
+    *p++ = '"';
+    c->top -= size - (p - head);  // 按实际输出量调整堆栈指针
+}
+
+typedef void (*string_kernel)(tiny_context*, const char*, size_t);
+
+static void naive_kernel(tiny_context* c, const char* s, size_t len) { tiny_stringify_string(c, s, len, true); }
+
+/// @brief 对同一组字符串重复执行 kernel, 返回吞吐量 (MB/s)
+static double bench_string(string_kernel kernel, const string* strs, size_t n, int rounds) {
+    tiny_context c;
+    size_t bytes = 0;
+    c.stack = nullptr;
+    c.size = c.top = 0;
+    c.sink = nullptr;
+    c.gather = nullptr;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            c.top = 0;
+            kernel(&c, strs[i].data(), strs[i].size());
+            bytes += strs[i].size();
+        }
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    tiny_dealloc(c.stack, c.size);
+    return bytes / sec / 1e6;
+}
+
+static void bench_strings(const char* name, const string* strs, size_t n, int rounds) {
+    printf("%-28s naive %8.1f MB/s   reserved %8.1f MB/s   scan %8.1f MB/s\n", name,
+        bench_string(naive_kernel, strs, n, rounds),
+        bench_string(tiny_stringify_string_reserved, strs, n, rounds),
+        bench_string(tiny_stringify_string, strs, n, rounds));
+}
+
+/// @brief 同一 JSONPath 查询反复执行: 预先编译一次 vs 每次重新解析表达式, 返回每次查询的纳秒数
+static void bench_path(const char* name, const char* expr, size_t items, int rounds) {
+    tiny_node doc;
+    tiny_path path;
+    tiny_path_result r = { nullptr, 0, 0 };
+    string json = "{\"items\":[";
+    size_t len = strlen(expr), matched = 0;
+    for (size_t i = 0; i < items; i++)
+        json += (i ? ",{\"id\":" : "{\"id\":") + to_string(i) + ",\"price\":" + to_string(i % 20) + ",\"tag\":\"t\"}";
+    json += "]}";
+    tiny_init(&doc);
+    tiny_parse(&doc, json.c_str());
+    tiny_path_compile(&path, expr, len);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) matched += tiny_path_eval(&path, &doc, &r);
+    double compiled = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        tiny_path_query(&doc, expr, len, &r);
+        matched -= r.size;
+    }
+    double naive = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%-28s compiled %8.1f ns   re-parsed %8.1f ns%s\n", name,
+        compiled / rounds * 1e9, naive / rounds * 1e9, matched == 0 ? "" : "   (mismatch)");
+    tiny_path_result_free(&r);
+    tiny_path_free(&path);
+    tiny_free(&doc);
+}
+
+/// @brief 同一文档每次重新解析与复用上一次的树解析的吞吐量 (MB/s)
+static void bench_reuse(const char* name, const string& json, int rounds) {
+    tiny_node node;
+    int ok = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        tiny_init(&node);
+        ok += tiny_parse(&node, json.c_str()) == TINY_PARSE_OK;
+        tiny_free(&node);
+    }
+    double parse = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    tiny_init(&node);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) ok -= tiny_parse_reuse(&node, json.c_str(), json.size()) == TINY_PARSE_OK;
+    double reuse = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    tiny_free(&node);
+    printf("%-28s parse %8.1f MB/s   reuse %8.1f MB/s%s\n", name, json.size() * rounds / parse / 1e6,
+        json.size() * rounds / reuse / 1e6, ok == 0 ? "" : "   (mismatch)");
+}
+
+/// @brief 同一文档反复解析与只做校验的吞吐量 (MB/s)
+static void bench_validate(const char* name, const string& json, int rounds, unsigned flags) {
+    tiny_node node;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, flags };
+    int ok = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        tiny_init(&node);
+        ok += tiny_parse_ex(&node, json.c_str(), &options) == TINY_PARSE_OK;
+        tiny_free(&node);
+    }
+    double parse = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) ok -= tiny_validate_ex(json.c_str(), json.size(), nullptr, &options) == TINY_PARSE_OK;
+    double validate = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%-28s parse %8.1f MB/s   validate %8.1f MB/s%s\n", name, json.size() * rounds / parse / 1e6,
+        json.size() * rounds / validate / 1e6, ok == 0 ? "" : "   (mismatch)");
+}
+
+int main() {
+    string strs[64];
+    for (int i = 0; i < 64; i++) strs[i] = string(1 << 16, 'a' + i % 26);
+    bench_strings("clean 64 KiB", strs, 64, 200);
+    for (int i = 0; i < 64; i++) for (size_t j = 0; j < strs[i].size(); j += 64) strs[i][j] = (j & 64) ? '"' : '\n';
+    bench_strings("1/64 escaped 64 KiB", strs, 64, 200);
+    for (int i = 0; i < 64; i++) strs[i] = string(16 + i % 8, 'k');
+    bench_strings("clean 16-23 B", strs, 64, 200000);
+    for (int i = 0; i < 64; i++) for (size_t j = 0; j < strs[i].size(); j++) strs[i][j] = (char)(j % 32);
+    bench_strings("control chars 16-23 B", strs, 64, 100000);
+    string doc = "[";
+    for (int i = 0; i < 20000; i++)
+        doc += (i ? ",{\"id\":" : "{\"id\":") + to_string(i) + ",\"name\":\"user name number " + to_string(i) + "\",\"score\":" + to_string(i * 0.25) + ",\"ok\":true}";
+    doc += "]";
+    bench_validate("validate, 20000 objects", doc, 20, 0);
+    bench_validate("strict UTF-8, 20000 objects", doc, 20, TINY_PARSE_STRICT_UTF8);
+    bench_validate("trusted, 20000 objects", doc, 20, TINY_PARSE_TRUSTED);
+    bench_validate("lazy numbers, 20000 objects", doc, 20, TINY_PARSE_LAZY_NUMBER);
+    bench_validate("decimal, 20000 objects", doc, 20, TINY_PARSE_DECIMAL);
+    bench_validate("borrowed strings, 20000 obj", doc, 20, TINY_PARSE_BORROW_STRINGS);
+    bench_reuse("reuse tree, 20000 objects", doc, 20);
+    bench_path("path filter, 4 items", "$.items[?(@.price > 10 && @.tag == 't')].id", 4, 200000);
+    bench_path("path filter, 1000 items", "$.items[?(@.price > 10 && @.tag == 't')].id", 1000, 2000);
+    bench_path("path descendant, 1000 items", "$..id", 1000, 2000);
+    return 0;
+}
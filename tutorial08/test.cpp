@@ -1,6 +1,9 @@
 #include<iostream>
 #include<cstdio>
 #include<cstring>
+#include<cerrno>
+#include<climits>
+#include<cmath>
 #include "tinyjson.h"
 using namespace std;
 
@@ -51,6 +54,7 @@ static int test_pass = 0;  // 通过的个数
         EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, json));\
         EXPECT_EQ_INT(TINY_NUMBER, tiny_get_type(&node));\
         EXPECT_EQ_DOUBLE(expect, tiny_get_number(&node));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_validate(json, strlen(json), nullptr));\
     } while(0)
 
 // 测试错误情况的宏
@@ -60,6 +64,7 @@ static int test_pass = 0;  // 通过的个数
         node.type = TINY_FALSE;\
         EXPECT_EQ_INT(error, tiny_parse(&node, json));\
         EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));\
+        EXPECT_EQ_INT(error, tiny_validate(json, strlen(json), nullptr));\
     } while(0)
 
 // TODO: 重构 null、true、false的测试函数
@@ -346,6 +351,42 @@ static void test_parse_invalid_unicode_surrogate() {
 #endif
 }
 
+// 严格 UTF-8 模式下的错误, 默认模式下同样的输入可以解析
+#define TEST_STRICT_ERROR(error, json)\
+    do{\
+        tiny_node node;\
+        tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_STRICT_UTF8 };\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(error, tiny_parse_ex(&node, json, &options));\
+        EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));\
+        EXPECT_EQ_INT(error, tiny_validate_ex(json, strlen(json), nullptr, &options));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, json));\
+        tiny_free(&node);\
+    } while(0)
+
+static void test_parse_invalid_utf8() {
+    tiny_node node;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_STRICT_UTF8 };
+    const char* valid = "[\"a\xC2\xA9\xE4\xB8\xAD\xEF\xBF\xBF\xF0\x9D\x84\x9E\xF4\x8F\xBF\xBF\xED\x9F\xBF\xEE\x80\x80\\uD834\\uDD1E\"]";
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, valid, &options));
+    EXPECT_EQ_STRING("a\xC2\xA9\xE4\xB8\xAD\xEF\xBF\xBF\xF0\x9D\x84\x9E\xF4\x8F\xBF\xBF\xED\x9F\xBF\xEE\x80\x80\xF0\x9D\x84\x9E",
+        tiny_get_string(tiny_get_array_element(&node, 0)), tiny_get_string_length(tiny_get_array_element(&node, 0)));
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_validate_ex(valid, strlen(valid), nullptr, &options));
+
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\x80\"");              /* 单独的续字节 */
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xC0\xAF\"");          /* 超长编码 */
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xE0\x80\xAF\"");
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xF0\x80\x80\xAF\"");
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xED\xA0\x80\"");      /* 代理项 U+D800 */
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xF4\x90\x80\x80\"");  /* 超过 U+10FFFF */
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xF5\x80\x80\x80\"");
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "\"\xE4\xB8\"");          /* 截断的序列 */
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UTF8, "{\"a\":1,\"0123456789\xFF\":2}");
+    TEST_STRICT_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uDC00\"");  /* 单独的低代理项 */
+}
+
 static void test_parse_miss_comma_or_square_bracket() {
 #if 1
     TEST_ERROR(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1");
@@ -379,6 +420,470 @@ static void test_parse_miss_comma_or_curly_bracket() {
 }
 
 /// @brief 进行所有测试
+/* 合法输入在可信模式下结果相同 */
+#define TEST_PROJECTED(expect, json, proj)\
+    do {\
+        tiny_node node;\
+        tiny_parse_options trusted = { nullptr, TINY_PACKED_NONE, TINY_PARSE_TRUSTED };\
+        char* s;\
+        size_t length;\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_projected(&node, json, strlen(json), proj));\
+        s = tiny_stringify(&node, &length);\
+        EXPECT_EQ_STRING(expect, s, length);\
+        free(s);\
+        tiny_free(&node);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_projected_ex(&node, json, strlen(json), proj, &trusted));\
+        s = tiny_stringify(&node, &length);\
+        EXPECT_EQ_STRING(expect, s, length);\
+        free(s);\
+        tiny_free(&node);\
+    } while(0)
+
+#define TEST_PROJECTED_ERROR_EX(error, json, proj, options)\
+    do {\
+        tiny_node node;\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(error, tiny_parse_projected_ex(&node, json, strlen(json), proj, options));\
+        EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));\
+    } while(0)
+
+#define TEST_PROJECTED_ERROR(error, json, proj) TEST_PROJECTED_ERROR_EX(error, json, proj, nullptr)
+
+static void test_parse_projected() {
+    static const char* paths[] = { "/id", "/user/name", "/items/1", "/items/0/id", "/a~1b", "/user/name/x" };
+    static const char* all[] = { "/id", "" };
+    static const char* bad[] = { "/a~2" };
+    tiny_projection proj, whole;
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_projection_compile(&proj, paths, sizeof(paths) / sizeof(paths[0])));
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_projection_compile(&whole, all, 2));
+
+    TEST_PROJECTED("{\"id\":1,\"user\":{\"name\":{\"x\":[1]}}}",
+        "{\"x\":[1,{\"y\":\"\\u00e9\\\"]\"}], \"id\" : 1, \"user\":{\"age\":3,\"name\":{\"x\":[1]}}}", &proj);
+    TEST_PROJECTED("{\"items\":[{\"id\":1},[2]],\"a/b\":true}",
+        "{\"items\":[{\"id\":1,\"n\":0},[2],3],\"a\\/b\":true}", &proj);
+    TEST_PROJECTED("{\"user\":{}}", "{\"user\":{\"x\":null},\"items\":7}", &proj);  // 路径经过的标量被丢弃
+    TEST_PROJECTED("{\"id\":[1,{\"a\":2}]}", " {\"id\":[1,{\"a\":2}]} ", &proj);
+    TEST_PROJECTED("[]", "[1,2]", &proj);
+    TEST_PROJECTED("null", "3", &proj);
+    TEST_PROJECTED("{}", "{}", &proj);
+    TEST_PROJECTED("{\"x\":[1,{\"a\":2}]}", "{\"x\":[1,{\"a\":2}]}", &whole);
+    TEST_PROJECTED("{}", "{\"x\":[1e308,-0.1e309,1e-400]}", &proj);
+
+    /* 跳过的部分同样检查语法 */
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_VALUE, "{\"x\":[1,]}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_VALUE, "{\"x\":nul}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"x\":01}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_EXPECT_VALUE, "{\"x\":", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_QUOTATION_MARK, "{\"x\":\"abc}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_STRING_ESCAPE, "{\"x\":\"\\v\"}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_STRING_CHAR, "{\"x\":\"\x01\"}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_UNICODE_HEX, "{\"x\":\"\\u12G4\"}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE, "{\"x\":\"\\uD800\\uE000\"}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "{\"x\":[1 2]}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_KEY, "{\"x\":{1:2}}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_COLON, "{\"x\":{\"a\" 2}}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"x\":{\"a\":2]}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"id\":1,\"user\":{\"name\":2}]", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_NUMBER_TOO_BIG, "{\"id\":1e400}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_NUMBER_TOO_BIG, "{\"x\":[-2e308]}", &proj);
+    TEST_PROJECTED_ERROR(TINY_PARSE_ROOT_NOT_SINGULAR, "{\"id\":1} x", &proj);
+
+    /* 可信模式下跳过的子树不检查语法, 但截断的输入仍然报错且不越过结尾 */
+    {
+        static const char json[] = "{\"x\":[1,,{\"a\":\"\\v]\"}],\"id\":2}";
+        tiny_parse_options trusted = { nullptr, TINY_PACKED_NONE, TINY_PARSE_TRUSTED };
+        tiny_node node;
+        char* s;
+        size_t length;
+        tiny_init(&node);
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_projected_ex(&node, json, sizeof(json) - 1, &proj, &trusted));
+        s = tiny_stringify(&node, &length);
+        EXPECT_EQ_STRING("{\"id\":2}", s, length);
+        free(s);
+        tiny_free(&node);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "{\"x\":[1,{\"a\":2}", &proj, &trusted);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"x\":{\"a\":[]", &proj, &trusted);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_MISS_QUOTATION_MARK, "{\"x\":\"ab", &proj, &trusted);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_MISS_QUOTATION_MARK, "{\"x\":\"a\\", &proj, &trusted);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_EXPECT_VALUE, "{\"x\":", &proj, &trusted);
+        TEST_PROJECTED_ERROR_EX(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"x\":1", &proj, &trusted);
+    }
+
+    tiny_projection_free(&proj);
+    tiny_projection_free(&whole);
+    EXPECT_EQ_INT(TINY_PATCH_INVALID_POINTER, tiny_projection_compile(&proj, bad, 1));
+}
+
+#define TEST_VALIDATE(error, offset, json)\
+    do {\
+        size_t off = 0;\
+        EXPECT_EQ_INT(error, tiny_validate(json, sizeof(json) - 1, &off));\
+        EXPECT_EQ_SIZE_T(offset, off);\
+    } while(0)
+
+/* 只把 json 的前 len 个字节复制到恰好这么大的堆内存中校验, 越界读取会被 AddressSanitizer 发现 */
+#define TEST_VALIDATE_PREFIX(error, offset, json, len)\
+    do {\
+        char* buffer = (char*)malloc(len);\
+        size_t off = 0;\
+        memcpy(buffer, json, len);\
+        EXPECT_EQ_INT(error, tiny_validate(buffer, len, &off));\
+        EXPECT_EQ_SIZE_T(offset, off);\
+        free(buffer);\
+    } while(0)
+
+/// @brief 只检查语法, 出错时给出出错位置
+static void test_validate() {
+    TEST_VALIDATE(TINY_PARSE_OK, 48, " {\"a\":[1,-2.5e10,\"x\\u00e9\\uD834\\uDD1E\"],\"b\":{}} ");
+    TEST_VALIDATE(TINY_PARSE_OK, 42, "\"a long string without any escapes at all\"");
+    TEST_VALIDATE(TINY_PARSE_EXPECT_VALUE, 3, "  [");
+    TEST_VALIDATE(TINY_PARSE_INVALID_VALUE, 4, "[1, tru]");
+    TEST_VALIDATE(TINY_PARSE_ROOT_NOT_SINGULAR, 3, "{} [] x");
+    TEST_VALIDATE(TINY_PARSE_NUMBER_TOO_BIG, 5, "{\"a\":1e309}");
+    TEST_VALIDATE(TINY_PARSE_MISS_QUOTATION_MARK, 12, "[\"abcdefghij");
+    TEST_VALIDATE(TINY_PARSE_INVALID_STRING_ESCAPE, 13, "[\"abcdefghijk\\x\"]");
+    TEST_VALIDATE(TINY_PARSE_INVALID_STRING_CHAR, 12, "[\"abcdefghij\n\"]");
+    TEST_VALIDATE(TINY_PARSE_INVALID_UNICODE_SURROGATE, 2, "[\"\\uD800\\u0041\"]");
+    TEST_VALIDATE(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, 11, "{\"a\":{\"b\":1]");
+    TEST_VALIDATE(TINY_PARSE_ROOT_NOT_SINGULAR, 1, "1\0" "2");  // len 之前的 '\0'
+
+    /* 输入不以 '\0' 结尾时不读取 len 之后的内容, 截断处按输入结束处理 */
+    TEST_VALIDATE_PREFIX(TINY_PARSE_OK, 5, "[1,2]x", 5);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_OK, 3, "1234", 3);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_OK, 4, "true", 4);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_INVALID_VALUE, 0, "true", 3);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_INVALID_VALUE, 0, "1e5", 2);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_NUMBER_TOO_BIG, 0, "1e4000", 5);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_OK, 4, "1e30", 4);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_EXPECT_VALUE, 3, "[1,2]", 3);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, 2, "[1]", 2);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_MISS_QUOTATION_MARK, 12, "[\"abcdefghijk\"]", 12);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_INVALID_STRING_ESCAPE, 2, "[\"\\n\"]", 3);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_INVALID_UNICODE_HEX, 1, "\"\\u0041\"", 5);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_INVALID_UNICODE_SURROGATE, 1, "\"\\uD834\\uDD1E\"", 10);
+    TEST_VALIDATE_PREFIX(TINY_PARSE_MISS_COLON, 4, "{\"a\":1}", 4);
+    {
+        tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_STRICT_UTF8 };
+        char* buffer = (char*)malloc(2);
+        size_t off = 0;
+        memcpy(buffer, "\"\xE4", 2);  // 多字节序列在结尾处被截断
+        EXPECT_EQ_INT(TINY_PARSE_INVALID_UTF8, tiny_validate_ex(buffer, 2, &off, &options));
+        EXPECT_EQ_SIZE_T(1, off);
+        free(buffer);
+    }
+}
+
+#define TEST_TRUSTED_ERROR(error, json)\
+    do {\
+        tiny_node node;\
+        tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_TRUSTED };\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(error, tiny_parse_ex(&node, json, &options));\
+        EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));\
+    } while(0)
+
+/// @brief 可信模式与普通模式对合法输入的结果相同, 对截断的输入不越过结尾
+static void test_parse_trusted() {
+    tiny_node node, trusted;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_TRUSTED };
+    const char* json = " { \"n\" : null , \"t\":true,\"f\":false,\"a\":[ 0, -1.5e10, 1E-3 ,\"\"],"
+        "\"s\":\"abcdefghijklmnopqrstuvwxyz\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\u4E2D\\uD834\\uDD1E\",\"o\":{}} ";
+    tiny_init(&node);
+    tiny_init(&trusted);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, json));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&trusted, json, &options));
+    EXPECT_TRUE(tiny_is_equal(&node, &trusted));
+    tiny_free(&trusted);
+
+    /* 不检查分隔符 */
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&trusted, "{\"n\"=null;\"t\"=true;\"f\"=false;\"a\"=[0;-1.5e10|1E-3/\"\"]"
+        "+\"s\"=\"abcdefghijklmnopqrstuvwxyz\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\u4E2D\\uD834\\uDD1E\"#\"o\"={}}", &options));
+    EXPECT_TRUE(tiny_is_equal(&node, &trusted));
+    tiny_free(&trusted);
+    tiny_free(&node);
+
+    TEST_TRUSTED_ERROR(TINY_PARSE_EXPECT_VALUE, "");
+    TEST_TRUSTED_ERROR(TINY_PARSE_EXPECT_VALUE, "[1,");
+    TEST_TRUSTED_ERROR(TINY_PARSE_INVALID_VALUE, "nul");
+    TEST_TRUSTED_ERROR(TINY_PARSE_INVALID_VALUE, "[-]");
+    TEST_TRUSTED_ERROR(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1");
+    TEST_TRUSTED_ERROR(TINY_PARSE_MISS_COLON, "{\"a\"");
+    TEST_TRUSTED_ERROR(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1");
+    TEST_TRUSTED_ERROR(TINY_PARSE_MISS_QUOTATION_MARK, "\"abc");
+    TEST_TRUSTED_ERROR(TINY_PARSE_INVALID_STRING_ESCAPE, "[\"a\\");
+    TEST_TRUSTED_ERROR(TINY_PARSE_INVALID_UNICODE_HEX, "\"\\u12");
+    TEST_TRUSTED_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\u");
+    TEST_TRUSTED_ERROR(TINY_PARSE_ROOT_NOT_SINGULAR, "1 2");
+}
+
+/// @brief 延迟转换的数字按原文输出, 首次读取时才转换
+static void test_parse_lazy_number() {
+    tiny_node node, eager, copy;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_LAZY_NUMBER };
+    static const char json[] = "[1.50,-0,1E+2,1e400,-123456789012345678901234567890,{\"a\":0.1e-400}]";
+    char* json2;
+    size_t length;
+    tiny_init(&node);
+    tiny_init(&eager);
+    tiny_init(&copy);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, json, &options));
+    EXPECT_EQ_SIZE_T(strlen(json), tiny_stringify_length(&node));
+    json2 = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING(json, json2, length);  // 原样输出, 包括超出 double 范围的数
+    free(json2);
+    EXPECT_EQ_DOUBLE(1.5, tiny_get_number(tiny_get_array_element(&node, 0)));
+    EXPECT_EQ_DOUBLE(100.0, tiny_get_number(tiny_get_array_element(&node, 2)));
+    EXPECT_TRUE(tiny_get_number(tiny_get_array_element(&node, 3)) > 1e308);  // 超出范围时转换为无穷大
+    EXPECT_EQ_DOUBLE(0.0, tiny_get_number(tiny_get_object_value(tiny_get_array_element(&node, 5), 0)));
+
+    /* 读取后仍按原文输出, 修改后按新值输出 */
+    tiny_copy(&copy, &node);
+    tiny_set_number(tiny_get_array_element(&copy, 2), 2.5);
+    json2 = tiny_stringify(&copy, &length);
+    EXPECT_EQ_STRING("[1.50,-0,2.5,1e400,-123456789012345678901234567890,{\"a\":0.1e-400}]", json2, length);
+    free(json2);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&eager, "[1.5,0,100,1e308,-1.2345678901234568e29,{\"a\":0}]"));
+    tiny_set_number(tiny_get_array_element(&eager, 3), tiny_get_number(tiny_get_array_element(&node, 3)));
+    EXPECT_TRUE(tiny_is_equal(&node, &eager));
+    EXPECT_TRUE(isnan(tiny_get_array_element(&node, 4)->n));  // 只读的比较在本地转换, 不写回节点
+    EXPECT_FALSE(tiny_is_equal(&copy, &eager));
+    tiny_free(&copy);
+    tiny_free(&eager);
+    tiny_free(&node);
+
+    /* 语法检查不变 */
+    EXPECT_EQ_INT(TINY_PARSE_INVALID_VALUE, tiny_parse_ex(&node, "[1.]", &options));
+    EXPECT_EQ_INT(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tiny_parse_ex(&node, "[01]", &options));
+}
+
+#define TEST_DECIMAL(expect, json)\
+    do {\
+        tiny_node node;\
+        tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_DECIMAL };\
+        char* json2;\
+        size_t length;\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, json, &options));\
+        json2 = tiny_stringify(&node, &length);\
+        EXPECT_EQ_STRING(expect, json2, length);\
+        EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));\
+        tiny_free(&node);\
+        free(json2);\
+    } while(0)
+
+#define TEST_DECIMAL_SCALED(ok, expect, scale, json)\
+    do {\
+        tiny_node node;\
+        tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_DECIMAL };\
+        int64_t i = 0;\
+        tiny_init(&node);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, json, &options));\
+        EXPECT_EQ_INT(ok, tiny_get_decimal_scaled(&node, scale, &i));\
+        EXPECT_TRUE(i == (expect));\
+        tiny_free(&node);\
+    } while(0)
+
+/// @brief 十进制数精确保存所有有效数字, 按规范形式输出
+static void test_parse_decimal() {
+    tiny_node node, number;
+    tiny_decimal d;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_DECIMAL };
+
+    TEST_DECIMAL("1234567890.123456789", "1234567890.123456789");
+    TEST_DECIMAL("0", "0");
+    TEST_DECIMAL("0", "-0.000e5");
+    TEST_DECIMAL("1.5", "1.50");
+    TEST_DECIMAL("100", "1E+2");
+    TEST_DECIMAL("0.00012", "12e-5");
+    TEST_DECIMAL("-1.2e-6", "-12e-7");
+    TEST_DECIMAL("1.23456789012345678901234567890123e+29", "123456789012345678901234567890.1230");
+    TEST_DECIMAL("1e+400", "1e400");
+    TEST_DECIMAL("-1e-1000000", "-0.1e-999999");
+    TEST_DECIMAL("[0.1,{\"a\":-2}]", "[ 0.10 , { \"a\" : -2 } ]");
+
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "-1234567890.123456789000", &options));
+    EXPECT_EQ_INT(TINY_DECIMAL, tiny_get_type(&node));
+    tiny_get_decimal(&node, &d);
+    EXPECT_EQ_STRING("1234567890123456789", d.digits, d.len);
+    EXPECT_EQ_INT(-9, d.exponent);
+    EXPECT_EQ_INT(1, d.negative);
+    EXPECT_EQ_DOUBLE(-1234567890.123456789, tiny_get_number(&node));
+    d.digits = "0012300";
+    d.len = 7;
+    d.exponent = -4;
+    d.negative = 0;
+    EXPECT_EQ_INT(1, tiny_set_decimal(&node, &d));
+    tiny_get_decimal(&node, &d);
+    EXPECT_EQ_STRING("123", d.digits, d.len);
+    EXPECT_EQ_INT(-2, d.exponent);
+    EXPECT_EQ_DOUBLE(1.23, tiny_get_number(&node));
+
+    /* digits 指向节点自身时也可以写回 */
+    d.exponent += 2;
+    EXPECT_EQ_INT(1, tiny_set_decimal(&node, &d));
+    tiny_get_decimal(&node, &d);
+    EXPECT_EQ_STRING("123", d.digits, d.len);
+    EXPECT_EQ_INT(0, d.exponent);
+
+    /* 超出范围时不修改节点 */
+    d.digits = "100";
+    d.len = 3;
+    d.exponent = INT_MAX;
+    EXPECT_EQ_INT(0, tiny_set_decimal(&node, &d));
+    d.digits = "1";
+    d.len = 1;
+    d.exponent = -1000000000;
+    EXPECT_EQ_INT(0, tiny_set_decimal(&node, &d));
+    tiny_get_decimal(&node, &d);
+    EXPECT_EQ_STRING("123", d.digits, d.len);
+    EXPECT_EQ_INT(0, d.exponent);
+    d.exponent = -2;
+    EXPECT_EQ_INT(1, tiny_set_decimal(&node, &d));
+    EXPECT_EQ_DOUBLE(1.23, tiny_get_number(&node));
+
+    /* 与 double 比较时, 只有 double 的最短表示与之相同才相等 */
+    tiny_init(&number);
+    tiny_set_number(&number, 1.23);
+    EXPECT_TRUE(tiny_is_equal(&node, &number));
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "1.2300000000000000001", &options));
+    EXPECT_FALSE(tiny_is_equal(&number, &node));
+    tiny_free(&number);
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&number, "[15e-1,0]", &options));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[1.50,-0.0]", &options));
+    EXPECT_TRUE(tiny_is_equal(&node, &number));
+    tiny_free(&number);
+    tiny_free(&node);
+
+    TEST_DECIMAL_SCALED(1, 123456, 2, "1234.56");
+    TEST_DECIMAL_SCALED(1, 1234560, 3, "1234.56");
+    TEST_DECIMAL_SCALED(0, 0, 1, "1234.56");
+    TEST_DECIMAL_SCALED(1, 1200, 0, "12e2");
+    TEST_DECIMAL_SCALED(1, 0, 5, "0");
+    TEST_DECIMAL_SCALED(1, INT64_MIN, 0, "-9223372036854775808");
+    TEST_DECIMAL_SCALED(0, 0, 0, "9223372036854775808");
+    TEST_DECIMAL_SCALED(0, 0, 1, "1e18");
+    TEST_DECIMAL_SCALED(0, 0, -1, "12345678901234567890123");
+
+    EXPECT_EQ_INT(TINY_PARSE_NUMBER_TOO_BIG, tiny_parse_ex(&node, "1e1000000000", &options));
+    EXPECT_EQ_INT(TINY_PARSE_INVALID_VALUE, tiny_parse_ex(&node, "[1.]", &options));
+}
+
+/// @brief 不含转义的字符串引用输入, 含转义的字符串仍解码到自有的存储中
+static void test_parse_borrow_strings() {
+    static const char json[] = "[\"abc\",\"a\\nb\",{\"k\":\"value\"},\"\"]";
+    tiny_node node, copy;
+    tiny_parse_options options = { nullptr, TINY_PACKED_NONE, TINY_PARSE_BORROW_STRINGS };
+    const char* s;
+    char* json2;
+    size_t len;
+    tiny_init(&node);
+    tiny_init(&copy);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, json, &options));
+    s = tiny_get_string_view(tiny_get_array_element(&node, 0), &len);
+    EXPECT_TRUE(s == json + 2);
+    EXPECT_EQ_SIZE_T(3, len);
+    s = tiny_get_string_view(tiny_get_array_element(&node, 1), &len);
+    EXPECT_EQ_STRING("a\nb", s, len);
+    EXPECT_TRUE(s < json || s >= json + sizeof(json));
+    s = tiny_get_string_view(tiny_get_object_value(tiny_get_array_element(&node, 2), 0), &len);
+    EXPECT_TRUE(s == json + 20);
+    EXPECT_EQ_STRING("value", s, len);
+    s = tiny_get_string_view(tiny_get_array_element(&node, 3), &len);
+    EXPECT_EQ_SIZE_T(0, len);
+    json2 = tiny_stringify(&node, &len);
+    EXPECT_EQ_STRING(json, json2, len);
+    free(json2);
+
+    /* 复制出的节点和 tiny_own_string 都不再引用输入 */
+    tiny_copy(&copy, &node);
+    EXPECT_TRUE(tiny_is_equal(&node, &copy));
+    s = tiny_get_string_view(tiny_get_array_element(&copy, 0), &len);
+    EXPECT_TRUE(s != json + 2);
+    s = tiny_own_string(tiny_get_array_element(&node, 0));
+    EXPECT_TRUE(s != json + 2);
+    EXPECT_EQ_STRING("abc", s, strlen(s));
+    EXPECT_TRUE(s == tiny_get_string(tiny_get_array_element(&node, 0)));
+    EXPECT_TRUE(s == tiny_own_string(tiny_get_array_element(&node, 0)));
+    tiny_set_string_view(tiny_get_array_element(&copy, 0), json + 3, 2);
+    s = tiny_get_string_view(tiny_get_array_element(&copy, 0), &len);
+    EXPECT_TRUE(s == json + 3);
+    EXPECT_EQ_STRING("bc", s, len);
+    tiny_free(&copy);
+    tiny_free(&node);
+
+    /* 严格模式下含非 ASCII 字节的字符串经过检查后复制 */
+    options.flags |= TINY_PARSE_STRICT_UTF8;
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "\"\xE4\xB8\xAD\"", &options));
+    s = tiny_get_string_view(&node, &len);
+    EXPECT_EQ_STRING("\xE4\xB8\xAD", s, len);
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_INVALID_UTF8, tiny_parse_ex(&node, "[\"\xFF\"]", &options));
+    EXPECT_EQ_INT(TINY_PARSE_MISS_QUOTATION_MARK, tiny_parse_ex(&node, "[\"abc", &options));
+}
+
+static void test_parse_reuse() {
+    static const char json1[] = "{\"id\":1,\"name\":\"abc\",\"tags\":[\"x\",\"y\",\"z\"],\"t\\tab\":true}";
+    static const char json2[] = "{\"i\":2,\"name\":\"de\",\"tags\":[\"u\",\"v\"],\"s\\tab\":false}";
+    static const char json3[] = "{\"id\":3,\"name\":\"longer\",\"tags\":[\"a\",\"b\",\"c\",\"d\"],\"extra\":{\"k\":[]}}";
+    tiny_node node, expect;
+    const tiny_node *tags, *name;
+    const tiny_member* m;
+    const char *key, *key0, *s;
+    char* json;
+    size_t len;
+    tiny_init(&node);
+    tiny_init(&expect);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, json1, sizeof(json1) - 1));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&expect, json1));
+    EXPECT_TRUE(tiny_is_equal(&node, &expect));
+    tiny_free(&expect);
+    m = node.o.m;
+    key0 = tiny_get_object_key(&node, 0);
+    key = tiny_get_object_key(&node, 1);
+    name = tiny_get_object_value(&node, 1);
+    s = tiny_get_string(name);
+    tags = tiny_get_array_element(tiny_get_object_value(&node, 2), 0);
+
+    /* 形状相同时成员数组, 缓冲区足够大的 key 和字符串以及元素数组都被复用; 元素变少时只释放多出的部分 */
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, json2, sizeof(json2) - 1));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&expect, json2));
+    EXPECT_TRUE(tiny_is_equal(&node, &expect));
+    tiny_free(&expect);
+    EXPECT_TRUE(node.o.m == m);
+    EXPECT_TRUE(tiny_get_object_key(&node, 0) == key0);
+    EXPECT_EQ_STRING("i", key0, tiny_get_object_key_length(&node, 0));
+    EXPECT_TRUE(tiny_get_object_key(&node, 1) == key);
+    EXPECT_TRUE(tiny_get_string(tiny_get_object_value(&node, 1)) == s);
+    EXPECT_EQ_STRING("de", s, strlen(s));
+    EXPECT_TRUE(tiny_get_array_element(tiny_get_object_value(&node, 2), 0) == tags);
+    EXPECT_EQ_SIZE_T(2, tiny_get_array_size(tiny_get_object_value(&node, 2)));
+    EXPECT_EQ_SIZE_T(3, tiny_get_array_capacity(tiny_get_object_value(&node, 2)));
+    /* 内容不同的等长 key 要重新计算转义缓存 */
+    json = tiny_stringify(&node, &len);
+    EXPECT_EQ_STRING(json2, json, len);
+    free(json);
+
+    /* 缓冲区不够大时重新分配 */
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, json3, sizeof(json3) - 1));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&expect, json3));
+    EXPECT_TRUE(tiny_is_equal(&node, &expect));
+    tiny_free(&expect);
+    EXPECT_EQ_SIZE_T(4, tiny_get_array_size(tiny_get_object_value(&node, 2)));
+
+    /* 形状完全不同和解析失败 */
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, "[1,{\"id\":\"abc\"}]", 16));
+    EXPECT_EQ_INT(TINY_OBJECT, tiny_get_type(tiny_get_array_element(&node, 1)));
+    EXPECT_EQ_INT(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tiny_parse_reuse(&node, "[1,{\"id\":\"abc\"}", 15));
+    EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, "\"abc\"", 5));
+    EXPECT_EQ_INT(TINY_PARSE_ROOT_NOT_SINGULAR, tiny_parse_reuse(&node, "\"abc\" x", 7));
+    EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&node));
+}
+
 static void test_parse(){
     test_parse_null();
     test_parse_true();
@@ -387,6 +892,13 @@ static void test_parse(){
     test_parse_string();
     test_parse_array();
     test_parse_object();
+    test_parse_projected();
+    test_validate();
+    test_parse_trusted();
+    test_parse_lazy_number();
+    test_parse_decimal();
+    test_parse_borrow_strings();
+    test_parse_reuse();
 
     test_parse_expect_value();
     test_parse_invalid_value();
@@ -397,6 +909,7 @@ static void test_parse(){
     test_parse_invalid_string_char();
     test_parse_invalid_unicode_hex();
     test_parse_invalid_unicode_surrogate();
+    test_parse_invalid_utf8();
     test_parse_miss_comma_or_square_bracket();
 
 #if 1
@@ -413,8 +926,10 @@ static void test_parse(){
         size_t length;\
         tiny_init(&node);\
         EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, json));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_validate(json, strlen(json), nullptr));\
         json2 = tiny_stringify(&node, &length);\
         EXPECT_EQ_STRING(json, json2, length);\
+        EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));\
         tiny_free(&node);\
         free(json2);\
     } while(0)
@@ -432,14 +947,26 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1.234e-20");
 
     TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+    /* 最短往返表示 */
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.3");
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1e-5");
+    TEST_ROUNDTRIP("123456.789");
+    TEST_ROUNDTRIP("9007199254740992");
+    TEST_ROUNDTRIP("10000000000000000");
+    TEST_ROUNDTRIP("1e+17");
+    TEST_ROUNDTRIP("1e+23");
+    TEST_ROUNDTRIP("1e-323");
 }
 
 static void test_stringify_string() {
@@ -448,6 +975,10 @@ static void test_stringify_string() {
     TEST_ROUNDTRIP("\"Hello\\nWorld\"");
     TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
     TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    /* 跨越 8 字节边界的转义与连续转义 */
+    TEST_ROUNDTRIP("\"0123456789abcdef\\\"0123456\\\\\\u001F\\n01234567\"");
+    TEST_ROUNDTRIP("\"\\u0001\\u0002\\b\\t\\n\\u000B\\f\\r\\u000E\\u001F\"");
+    TEST_ROUNDTRIP("\"\xE4\xB8\xAD\xE6\x96\x87 \xF0\x9D\x84\x9E 12345678\\\\\"");
 }
 
 static void test_stringify_array() {
@@ -458,6 +989,311 @@ static void test_stringify_array() {
 static void test_stringify_object() {
     TEST_ROUNDTRIP("{}");
     TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+    /* 需要转义的 key */
+    TEST_ROUNDTRIP("{\"a\\\"b\":1,\"\\\\\":{\"\\n\\u0001\":[]},\"c\":2}");
+}
+
+static void test_stringify_object_key() {
+    tiny_node node, copy;
+    size_t length;
+    char* json;
+
+    /* 通过 API 设置、复制和移除需要转义的 key */
+    tiny_init(&node);
+    tiny_init(&copy);
+    tiny_set_object(&node, 0);
+    tiny_set_number(tiny_set_object_key(&node, "a\"b", 3), 1.0);
+    tiny_set_null(tiny_set_object_key(&node, "plain", 5));
+    tiny_set_boolean(tiny_set_object_key(&node, "tab\t", 4), 1);
+    tiny_copy(&copy, &node);
+    tiny_remove_object(&copy, 1);
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("{\"a\\\"b\":1,\"plain\":null,\"tab\\t\":true}", json, length);
+    EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));
+    free(json);
+    json = tiny_stringify(&copy, &length);
+    EXPECT_EQ_STRING("{\"a\\\"b\":1,\"tab\\t\":true}", json, length);
+    free(json);
+    EXPECT_EQ_STRING("a\"b", tiny_get_object_key(&copy, 0), tiny_get_object_key_length(&copy, 0));
+    tiny_free(&node);
+    tiny_free(&copy);
+}
+
+/// @brief 把输出追加到 std::string 的 sink, 同时记录调用次数和最大块大小
+struct sink_state { string out; size_t calls, max_chunk; int fail_at; };
+
+static int string_sink_write(const char* data, size_t len, void* user) {
+    sink_state* st = (sink_state*)user;
+    if (++st->calls == (size_t)st->fail_at) return -1;
+    st->out.append(data, len);
+    if (len > st->max_chunk) st->max_chunk = len;
+    return 0;
+}
+
+static void test_stringify_stream() {
+    tiny_node node;
+    tiny_buffer buffer = { nullptr, 0, 0 };
+    sink_state st = { "", 0, 0, 0 };
+    tiny_sink sink = { string_sink_write, &st };
+    string big(100000, 'x');
+    size_t length;
+    char* json;
+    const char* data;
+
+    /* 大文档分块输出, 与 tiny_stringify 的结果一致 */
+    tiny_init(&node);
+    tiny_set_array(&node, 0);
+    tiny_set_string(tiny_pushback_array_element(&node), big.data(), big.size());
+    for (int i = 0; i < 1000; i++) {
+        tiny_node* o = tiny_pushback_array_element(&node);
+        tiny_set_object(o, 0);
+        tiny_set_number(tiny_set_object_key(o, "id", 2), i * 0.5);
+        tiny_set_string(tiny_set_object_key(o, "s", 1), "a\"b\n", 4);
+    }
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_INT(0, tiny_stringify_to(&node, &sink));
+    EXPECT_TRUE(st.calls > 1);
+    EXPECT_TRUE(st.max_chunk <= 4096);
+    EXPECT_EQ_SIZE_T(length, st.out.size());
+    EXPECT_TRUE(st.out.compare(0, length, json, length) == 0);
+
+    /* sink 出错时返回其错误码 */
+    st.out.clear();
+    st.calls = 0;
+    st.fail_at = 2;
+    EXPECT_EQ_INT(-1, tiny_stringify_to(&node, &sink));
+
+    /* 缓冲区在多次调用之间复用 */
+    tiny_stringify_into(&node, &buffer);
+    EXPECT_EQ_SIZE_T(length, buffer.size);
+    EXPECT_TRUE(memcmp(json, buffer.data, length + 1) == 0);
+    data = buffer.data;
+    tiny_stringify_into(&node, &buffer);
+    EXPECT_TRUE(data == buffer.data);
+    tiny_free(&node);
+    tiny_stringify_into(&node, &buffer);
+    EXPECT_EQ_STRING("null", buffer.data, buffer.size);
+    EXPECT_TRUE(data == buffer.data);
+    tiny_buffer_free(&buffer);
+    free(json);
+}
+
+#ifndef _WIN32
+static void test_stringify_fd() {
+    tiny_node node;
+    string big(100000, 'x'), out;
+    size_t length;
+    char* json;
+    char buf[4096];
+    size_t n;
+    FILE* fp;
+
+    /* 长字符串、长 key、转义和短字符串交替出现, 也要覆盖 iov 用满时的写出 */
+    tiny_init(&node);
+    tiny_set_array(&node, 0);
+    tiny_set_string(tiny_pushback_array_element(&node), big.data(), big.size());
+    for (int i = 0; i < 1000; i++) {
+        tiny_node* o = tiny_pushback_array_element(&node);
+        tiny_set_object(o, 0);
+        tiny_set_number(tiny_set_object_key(o, big.data(), 70), i * 0.5);
+        tiny_set_string(tiny_set_object_key(o, "s\n", 3), "a\"b\n", 4);
+        tiny_set_string(tiny_set_object_key(o, "t", 1), big.data(), 64 + i % 3);
+    }
+    json = tiny_stringify(&node, &length);
+    fp = tmpfile();
+    EXPECT_TRUE(fp != nullptr);
+    EXPECT_EQ_INT(0, tiny_stringify_fd(&node, fileno(fp)));
+    rewind(fp);
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out.append(buf, n);
+    fclose(fp);
+    EXPECT_EQ_SIZE_T(length, out.size());
+    EXPECT_TRUE(out.compare(0, length, json, length) == 0);
+
+    /* 写出失败时返回 errno */
+    EXPECT_EQ_INT(EBADF, tiny_stringify_fd(&node, -1));
+    tiny_free(&node);
+    free(json);
+}
+#endif
+
+#define EXPECT_CACHED(cache, node) \
+    do {\
+        size_t length, clength;\
+        char* json = tiny_stringify(node, &length);\
+        const char* cjson = tiny_stringify_cached(cache, node, &clength);\
+        EXPECT_EQ_SIZE_T(length, clength);\
+        EXPECT_TRUE(memcmp(json, cjson, length + 1) == 0);\
+        free(json);\
+    } while(0)
+
+static void test_stringify_cached() {
+    tiny_node node, temp, *a, *o;
+    tiny_stringify_cache* cache = tiny_stringify_cache_create();
+    tiny_init(&node);
+    tiny_init(&temp);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, 
+        "{\"a\":[1,{\"b\":[true,null]},\"x\"],\"c\":{\"d\":{\"e\":1.5}},\"k\\n\":[[],{}]}"));
+    EXPECT_CACHED(cache, &node);
+    EXPECT_CACHED(cache, &node);
+
+    /* 修改深处的值, 只有到根的路径被重新生成 */
+    o = tiny_find_object_value(tiny_find_object_value(tiny_find_object_value(&node, "c", 1), "d", 1), "e", 1);
+    tiny_set_number(o, 2.5);
+    EXPECT_CACHED(cache, &node);
+
+    /* 扩容后容器的缓冲区改变 */
+    a = tiny_find_object_value(&node, "a", 1);
+    for (int i = 0; i < 20; i++) tiny_set_string(tiny_pushback_array_element(a), "y\"z", 3);
+    EXPECT_CACHED(cache, &node);
+    tiny_shrink_array(a);
+    EXPECT_CACHED(cache, &node);
+    tiny_erase_array_element(a, 2, 10);
+    tiny_set_boolean(tiny_insert_array_element(a, 0), 1);
+    EXPECT_CACHED(cache, &node);
+
+    /* 在文档内移动、交换和删除子树 */
+    tiny_swap(tiny_get_array_element(a, 2), tiny_find_object_value(&node, "c", 1));
+    EXPECT_CACHED(cache, &node);
+    tiny_move(&temp, tiny_get_array_element(a, 2));
+    tiny_move(tiny_set_object_key(&node, "moved", 5), &temp);
+    EXPECT_CACHED(cache, &node);
+    tiny_remove_object(&node, tiny_find_object_index(&node, "k\n", 2));
+    tiny_set_object(tiny_set_object_key(&node, "k\n", 2), 0);
+    EXPECT_CACHED(cache, &node);
+
+    /* 被缓存的容器释放后, 新容器可能复用它的地址 */
+    tiny_set_array(&node, 0);
+    tiny_set_number(tiny_pushback_array_element(&node), 1);
+    EXPECT_CACHED(cache, &node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&temp, "[{\"p\":[1,2]},[3]]"));
+    EXPECT_CACHED(cache, &temp);
+    EXPECT_CACHED(cache, &node);
+
+    tiny_free(&node);
+    tiny_free(&temp);
+    tiny_stringify_cache_free(cache);
+}
+
+static void test_stringify_parallel() {
+    tiny_node node, *results, *o;
+    size_t length, plength;
+    char *json, *pjson;
+    unsigned threads[] = { 0, 1, 2, 3, 8 };
+
+    /* 大数组挂在对象里, 需要沿着大的子容器向下切分 */
+    tiny_init(&node);
+    tiny_set_object(&node, 0);
+    tiny_set_string(tiny_set_object_key(&node, "meta", 4), "x\ny", 3);
+    results = tiny_set_object_key(&node, "res\"ults", 8);
+    tiny_set_array(results, 0);
+    for (int i = 0; i < 30000; i++) {
+        o = tiny_pushback_array_element(results);
+        tiny_set_object(o, 0);
+        tiny_set_number(tiny_set_object_key(o, "v", 1), i * 0.1);
+        tiny_set_string(tiny_set_object_key(o, "s\t", 2), "\"", 1);
+        tiny_set_array(tiny_set_object_key(o, "e", 1), 0);
+    }
+    tiny_set_boolean(tiny_set_object_key(&node, "done", 4), 1);
+    json = tiny_stringify(&node, &length);
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        pjson = tiny_stringify_parallel(&node, &plength, threads[i]);
+        EXPECT_EQ_SIZE_T(length, plength);
+        EXPECT_TRUE(memcmp(json, pjson, length + 1) == 0);
+        free(pjson);
+    }
+    free(json);
+
+    /* 大量小元素之间夹着几个很大的子数组, 大元素单独切分后再按字节数合并 */
+    tiny_free(&node);
+    tiny_set_array(&node, 0);
+    for (int i = 0; i < 10000; i++) {
+        o = tiny_pushback_array_element(&node);
+        if (i != 3 && i != 5000 && i != 9999) tiny_set_number(o, i);
+        else {
+            tiny_set_array(o, 0);
+            for (int j = 0; j < 70000; j++) tiny_set_string(tiny_pushback_array_element(o), "ab", j % 3);
+        }
+    }
+    json = tiny_stringify(&node, &length);
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        pjson = tiny_stringify_parallel(&node, &plength, threads[i]);
+        EXPECT_EQ_SIZE_T(length, plength);
+        EXPECT_TRUE(memcmp(json, pjson, length + 1) == 0);
+        free(pjson);
+    }
+    free(json);
+
+    /* 小文档走串行路径 */
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "[1,{\"a\":[]}]"));
+    pjson = tiny_stringify_parallel(&node, &plength, 4);
+    EXPECT_EQ_STRING("[1,{\"a\":[]}]", pjson, plength);
+    free(pjson);
+    tiny_free(&node);
+}
+
+static void test_writer() {
+    tiny_writer w;
+    tiny_buffer buffer = { nullptr, 0, 0 };
+    sink_state st = { "", 0, 0, 0 };
+    tiny_sink sink = { string_sink_write, &st };
+    tiny_node node;
+    const char* data;
+
+    tiny_writer_init(&w, &buffer);
+    tiny_writer_start_object(&w);
+    tiny_writer_key(&w, "n", 1);
+    tiny_writer_null(&w);
+    tiny_writer_key(&w, "f", 1);
+    tiny_writer_boolean(&w, 0);
+    tiny_writer_key(&w, "t", 1);
+    tiny_writer_boolean(&w, 1);
+    tiny_writer_key(&w, "i", 1);
+    tiny_writer_int(&w, 123);
+    tiny_writer_key(&w, "d", 1);
+    tiny_writer_double(&w, 0.1);
+    tiny_writer_key(&w, "s", 1);
+    tiny_writer_string(&w, "a\"b\n", 4);
+    tiny_writer_key(&w, "a", 1);
+    tiny_writer_start_array(&w);
+    tiny_writer_int(&w, -9223372036854775807LL - 1);
+    tiny_writer_int(&w, 0);
+    tiny_writer_start_array(&w);
+    tiny_writer_end_array(&w);
+    tiny_writer_start_object(&w);
+    tiny_writer_end_object(&w);
+    tiny_writer_end_array(&w);
+    tiny_writer_key(&w, "k\"\n", 3);  /* key 也要转义 */
+    tiny_writer_int(&w, 18446744073709551LL);
+    tiny_writer_end_object(&w);
+    EXPECT_EQ_INT(0, tiny_writer_finish(&w));
+    EXPECT_EQ_STRING("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"d\":0.1,\"s\":\"a\\\"b\\n\","
+        "\"a\":[-9223372036854775808,0,[],{}],\"k\\\"\\n\":18446744073709551}", buffer.data, buffer.size);
+
+    /* 复用缓冲区, 并嵌入已有的节点 */
+    data = buffer.data;
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "{\"x\":[1,2,{\"y\":\"z\"}]}"));
+    tiny_writer_init(&w, &buffer);
+    tiny_writer_start_array(&w);
+    tiny_writer_value(&w, &node);
+    tiny_writer_double(&w, 1e+20);
+    tiny_writer_end_array(&w);
+    EXPECT_EQ_INT(0, tiny_writer_finish(&w));
+    EXPECT_EQ_STRING("[{\"x\":[1,2,{\"y\":\"z\"}]},1e+20]", buffer.data, buffer.size);
+    EXPECT_TRUE(data == buffer.data);
+
+    /* 输出到 sink */
+    tiny_writer_init_sink(&w, &sink);
+    tiny_writer_start_array(&w);
+    for (int i = 0; i < 10000; i++) tiny_writer_value(&w, &node);
+    tiny_writer_end_array(&w);
+    EXPECT_EQ_INT(0, tiny_writer_finish(&w));
+    EXPECT_TRUE(st.calls > 1);
+    EXPECT_EQ_SIZE_T(2 + 10000 * 22 - 1, st.out.size());
+
+    tiny_free(&node);
+    tiny_buffer_free(&buffer);
 }
 
 static void test_stringify() {
@@ -468,6 +1304,14 @@ static void test_stringify() {
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_object_key();
+    test_stringify_stream();
+#ifndef _WIN32
+    test_stringify_fd();
+#endif
+    test_stringify_cached();
+    test_stringify_parallel();
+    test_writer();
 }
 
 static void test_access_null() {
@@ -657,6 +1501,109 @@ static void test_access_object() {
 #endif
 }
 
+static void test_access_number_array() {
+    tiny_node node, copy, *e;
+    tiny_parse_options options = { nullptr, TINY_PACKED_DOUBLE, 0 };
+    const int64_t ints[] = { 1, -2, INT64_MAX, INT64_MIN };
+    const double* d;
+    size_t len, length;
+    char* json;
+
+    /* 全为数字的数组打包, 输出与普通数组一致 */
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[ 1 , 0.5, -3e2 ]", &options));
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(&node));
+    d = tiny_get_number_array(&node, &len);
+    EXPECT_EQ_SIZE_T(3, len);
+    EXPECT_EQ_DOUBLE(0.5, d[1]);
+    EXPECT_EQ_DOUBLE(-300.0, d[2]);
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[1,0.5,-300]", json, length);
+    EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));
+    free(json);
+
+    /* 与内容相同的普通数组相等, 读取元素时不展开, 修改数组时才原地展开 */
+    tiny_init(&copy);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&copy, "[1,0.5,-300]"));
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(&copy));
+    EXPECT_TRUE(tiny_is_equal(&node, &copy));
+    EXPECT_TRUE(tiny_is_equal(&copy, &node));
+    tiny_copy(&copy, &node);
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(&copy));
+    EXPECT_EQ_SIZE_T(3, tiny_get_array_size(&node));
+    e = tiny_get_array_element(&node, 1);
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(&node));
+    EXPECT_EQ_DOUBLE(0.5, tiny_get_number(e));
+    EXPECT_TRUE(e == tiny_get_array_element(&node, 1));
+    tiny_reserve_array(&node, 0);
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(&node));
+    EXPECT_TRUE(e == tiny_get_array_element(&node, 1));
+    EXPECT_TRUE(tiny_is_equal(&node, &copy));
+    tiny_set_string(tiny_pushback_array_element(&copy), "x", 1);
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(&copy));
+    EXPECT_EQ_SIZE_T(4, tiny_get_array_size(&copy));
+
+    /* 含非数字元素、空数组和数字解析错误 */
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[[1,2],[3,\"a\"],[]]", &options));
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(tiny_get_array_element(&node, 0)));
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(tiny_get_array_element(&node, 1)));
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(tiny_get_array_element(&node, 2)));
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_INVALID_VALUE, tiny_parse_ex(&node, "[1,2.]", &options));
+    EXPECT_EQ_INT(TINY_PARSE_NUMBER_TOO_BIG, tiny_parse_ex(&node, "[1,1e309]", &options));
+    EXPECT_EQ_INT(TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tiny_parse_ex(&node, "[1 2]", &options));
+
+    /* int64 保持精度, 遇到非整数时改为 double */
+    options.packed = TINY_PACKED_INT64;
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[1,-2,9223372036854775807,-9223372036854775808]", &options));
+    EXPECT_EQ_INT(TINY_PACKED_INT64, tiny_get_number_array_type(&node));
+    EXPECT_TRUE(memcmp(ints, tiny_get_int64_array(&node, &len), sizeof(ints)) == 0);
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[1,-2,9223372036854775807,-9223372036854775808]", json, length);
+    EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));
+    free(json);
+    tiny_free(&node);
+
+    /* 超过 2^53 的 int64 元素在读取和展开时都不损失精度 */
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[9007199254740993,1]", &options));
+    json = tiny_stringify(tiny_get_array_element(&node, 0), &length);
+    EXPECT_EQ_STRING("9007199254740993", json, length);
+    free(json);
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(&node));
+    EXPECT_TRUE(tiny_get_int64_array(&node, nullptr)[0] == 9007199254740993LL);
+    tiny_pushback_array_element(&node);
+    EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(&node));
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[9007199254740993,1,null]", json, length);
+    free(json);
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[1,2,9223372036854775808]", &options));
+    EXPECT_EQ_INT(TINY_PACKED_DOUBLE, tiny_get_number_array_type(&node));
+    tiny_free(&node);
+
+    /* float 按 float 精度输出最短形式, 超出范围时改为 double */
+    options.packed = TINY_PACKED_FLOAT;
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[0.1,1e-45,3.4028235e38,-0]", &options));
+    EXPECT_EQ_INT(TINY_PACKED_FLOAT, tiny_get_number_array_type(&node));
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[0.1,1e-45,3.4028235e+38,-0]", json, length);
+    EXPECT_EQ_SIZE_T(length, tiny_stringify_length(&node));
+    free(json);
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "[0.1,1e39]", &options));
+    EXPECT_EQ_INT(TINY_PACKED_DOUBLE, tiny_get_number_array_type(&node));
+    EXPECT_EQ_DOUBLE(0.1, tiny_get_number_array(&node, nullptr)[0]);
+
+    /* 直接设置 */
+    tiny_set_int64_array(&node, ints, 2);
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[1,-2]", json, length);
+    free(json);
+    tiny_free(&node);
+    tiny_free(&copy);
+}
+
 static void test_access() {
     test_access_null();
     test_access_boolean();
@@ -664,12 +1611,513 @@ static void test_access() {
     test_access_string();
     test_access_array();
     test_access_object();
+    test_access_number_array();
+}
+
+#define TEST_MERGE_PATCH(expect, target, patch)\
+    do {\
+        tiny_node t, p;\
+        char* json;\
+        size_t length;\
+        tiny_init(&t);\
+        tiny_init(&p);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&t, target));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&p, patch));\
+        tiny_merge_patch(&t, &p);\
+        EXPECT_EQ_INT(TINY_NULL, tiny_get_type(&p));\
+        json = tiny_stringify(&t, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        tiny_free(&t);\
+        free(json);\
+    } while(0)
+
+/// @brief RFC 7386 附录 A 中的用例
+static void test_merge_patch() {
+    TEST_MERGE_PATCH("{\"a\":\"c\"}", "{\"a\":\"b\"}", "{\"a\":\"c\"}");
+    TEST_MERGE_PATCH("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":\"b\"}", "{\"b\":\"c\"}");
+    TEST_MERGE_PATCH("{}", "{\"a\":\"b\"}", "{\"a\":null}");
+    TEST_MERGE_PATCH("{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}");
+    TEST_MERGE_PATCH("{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":\"c\"}");
+    TEST_MERGE_PATCH("{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":[\"b\"]}");
+    TEST_MERGE_PATCH("{\"a\":{\"b\":\"d\"}}", "{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}");
+    TEST_MERGE_PATCH("{\"a\":[1]}", "{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}");
+    TEST_MERGE_PATCH("[\"c\",\"d\"]", "[\"a\",\"b\"]", "[\"c\",\"d\"]");
+    TEST_MERGE_PATCH("[\"c\"]", "{\"a\":\"b\"}", "[\"c\"]");
+    TEST_MERGE_PATCH("null", "{\"a\":\"foo\"}", "null");
+    TEST_MERGE_PATCH("\"bar\"", "{\"a\":\"foo\"}", "\"bar\"");
+    TEST_MERGE_PATCH("{\"e\":null,\"a\":1}", "{\"e\":null}", "{\"a\":1}");
+    TEST_MERGE_PATCH("{\"a\":\"b\"}", "[1,2]", "{\"a\":\"b\",\"c\":null}");
+    TEST_MERGE_PATCH("{\"a\":{\"bb\":{}}}", "{}", "{\"a\":{\"bb\":{\"ccc\":null}}}");
+
+    /* 一次压缩删除多个成员, 且保持剩余成员的顺序 */
+    TEST_MERGE_PATCH("{\"b\":2,\"d\":40,\"e\":5}", "{\"a\":1,\"b\":2,\"c\":3,\"d\":4}", "{\"c\":null,\"a\":null,\"d\":40,\"e\":5}");
+    /* patch 中重复的 key 以最后一个为准 */
+    TEST_MERGE_PATCH("{\"a\":3}", "{\"a\":1}", "{\"a\":2,\"a\":3}");
+}
+
+#define TEST_PATCH(error, expect, doc, patch)\
+    do {\
+        tiny_node d, p;\
+        tiny_patch cp;\
+        char* json;\
+        size_t length;\
+        tiny_init(&d);\
+        tiny_init(&p);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&d, doc));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&p, patch));\
+        EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_compile(&cp, &p));\
+        EXPECT_EQ_INT(error, tiny_patch_apply(&cp, &d));\
+        json = tiny_stringify(&d, &length);\
+        EXPECT_EQ_STRING(expect, json, length);\
+        tiny_patch_free(&cp);\
+        tiny_free(&d);\
+        tiny_free(&p);\
+        free(json);\
+    } while(0)
+
+#define TEST_PATCH_COMPILE_ERROR(error, patch)\
+    do {\
+        tiny_node p;\
+        tiny_patch cp;\
+        tiny_init(&p);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&p, patch));\
+        EXPECT_EQ_INT(error, tiny_patch_compile(&cp, &p));\
+        EXPECT_EQ_SIZE_T(0, cp.size);\
+        tiny_free(&p);\
+    } while(0)
+
+/// @brief RFC 6902 附录 A 中的用例
+static void test_patch_apply() {
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":\"bar\",\"baz\":\"qux\"}",
+        "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":[\"bar\",\"qux\",\"baz\"]}",
+        "{\"foo\":[\"bar\",\"baz\"]}", "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":\"bar\"}",
+        "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"remove\",\"path\":\"/baz\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":[\"bar\",\"baz\"]}",
+        "{\"foo\":[\"bar\",\"qux\",\"baz\"]}", "[{\"op\":\"remove\",\"path\":\"/foo/1\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"baz\":\"boo\",\"foo\":\"bar\"}",
+        "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}",
+        "{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},\"qux\":{\"corge\":\"grault\"}}",
+        "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}",
+        "{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}", "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+        "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+        "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"qux\"},{\"op\":\"test\",\"path\":\"/foo/1\",\"value\":2}]");
+    TEST_PATCH(TINY_PATCH_TEST_FAILED, "{\"baz\":\"qux\"}",
+        "{\"baz\":\"qux\"}", "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"bar\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":\"bar\",\"child\":{\"grandchild\":{}}}",
+        "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/child\",\"value\":{\"grandchild\":{}}}]");
+    TEST_PATCH(TINY_PATCH_PATH_NOT_FOUND, "{\"foo\":\"bar\"}",
+        "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz/bat\",\"value\":\"qux\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"/\":9,\"~1\":10}",
+        "{\"/\":9,\"~1\":10}", "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":10}]");
+    TEST_PATCH(TINY_PATCH_TEST_FAILED, "{\"/\":9,\"~1\":10}",
+        "{\"/\":9,\"~1\":10}", "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":\"10\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}",
+        "{\"foo\":[\"bar\"]}", "[{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]}]");
+
+    /* copy、替换整个文档、object 的比较与成员顺序无关 */
+    TEST_PATCH(TINY_PATCH_OK, "{\"a\":[1,{\"b\":2}],\"c\":{\"b\":2}}",
+        "{\"a\":[1,{\"b\":2}]}", "[{\"op\":\"copy\",\"from\":\"/a/1\",\"path\":\"/c\"}]");
+    TEST_PATCH(TINY_PATCH_OK, "[1]", "{\"a\":1}", "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]");
+    TEST_PATCH(TINY_PATCH_OK, "{\"a\":1,\"b\":2}",
+        "{\"a\":1,\"b\":2}", "[{\"op\":\"test\",\"path\":\"\",\"value\":{\"b\":2,\"a\":1}}]");
+    /* 重复的 key 只能匹配一次, 比较结果与方向无关 */
+    TEST_PATCH(TINY_PATCH_TEST_FAILED, "{\"b\":2,\"a\":1}",
+        "{\"b\":2,\"a\":1}", "[{\"op\":\"test\",\"path\":\"\",\"value\":{\"a\":1,\"a\":1}}]");
+    TEST_PATCH(TINY_PATCH_TEST_FAILED, "{\"a\":1,\"a\":1}",
+        "{\"a\":1,\"a\":1}", "[{\"op\":\"test\",\"path\":\"\",\"value\":{\"b\":2,\"a\":1}}]");
+
+    /* 任一操作失败时回滚之前的全部修改 */
+    TEST_PATCH(TINY_PATCH_TEST_FAILED, "{\"a\":{\"x\":1},\"b\":[1,2,3],\"c\":\"s\"}",
+        "{\"a\":{\"x\":1},\"b\":[1,2,3],\"c\":\"s\"}",
+        "[{\"op\":\"add\",\"path\":\"/d\",\"value\":4},"
+        "{\"op\":\"remove\",\"path\":\"/a\"},"
+        "{\"op\":\"move\",\"from\":\"/b/0\",\"path\":\"/b/-\"},"
+        "{\"op\":\"move\",\"from\":\"/b\",\"path\":\"/c\"},"
+        "{\"op\":\"replace\",\"path\":\"/c/0\",\"value\":0},"
+        "{\"op\":\"add\",\"path\":\"\",\"value\":{}},"
+        "{\"op\":\"test\",\"path\":\"\",\"value\":null}]");
+    TEST_PATCH(TINY_PATCH_PATH_NOT_FOUND, "{\"a\":[1,2]}",
+        "{\"a\":[1,2]}",
+        "[{\"op\":\"remove\",\"path\":\"/a/0\"},{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/b/c\"}]");
+    TEST_PATCH(TINY_PATCH_PATH_NOT_FOUND, "{\"a\":[1,2]}",
+        "{\"a\":[1,2]}", "[{\"op\":\"add\",\"path\":\"/a/3\",\"value\":3}]");
+}
+
+static void test_patch_compile() {
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "{}");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "[1]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "[{\"op\":\"foo\",\"path\":\"/a\"}]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "[{\"op\":\"add\",\"path\":\"/a\"}]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "[{\"op\":\"copy\",\"path\":\"/a\"}]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_OPERATION, "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b\"}]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_POINTER, "[{\"op\":\"remove\",\"path\":\"a\"}]");
+    TEST_PATCH_COMPILE_ERROR(TINY_PATCH_INVALID_POINTER, "[{\"op\":\"remove\",\"path\":\"/a~2\"}]");
+
+    /* 预先切分的 token 与下标 */
+    tiny_node p;
+    tiny_patch cp;
+    tiny_init(&p);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&p, "[{\"op\":\"remove\",\"path\":\"/a~1b/~0/12/-/01/\"}]"));
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_compile(&cp, &p));
+    EXPECT_EQ_SIZE_T(1, cp.size);
+    EXPECT_EQ_SIZE_T(6, cp.ops[0].path.size);
+    EXPECT_EQ_STRING("a/b", cp.ops[0].path.t[0].s, cp.ops[0].path.t[0].len);
+    EXPECT_EQ_STRING("~", cp.ops[0].path.t[1].s, cp.ops[0].path.t[1].len);
+    EXPECT_EQ_SIZE_T(TINY_KEY_NOT_EXIST, cp.ops[0].path.t[1].index);
+    EXPECT_EQ_SIZE_T(12, cp.ops[0].path.t[2].index);
+    EXPECT_EQ_SIZE_T(TINY_POINTER_END, cp.ops[0].path.t[3].index);
+    EXPECT_EQ_SIZE_T(TINY_KEY_NOT_EXIST, cp.ops[0].path.t[4].index);
+    EXPECT_EQ_SIZE_T(0, cp.ops[0].path.t[5].len);
+    tiny_patch_free(&cp);
+    tiny_free(&p);
+}
+
+/// @brief 同一个编译好的 patch 应用于多个文档
+static void test_patch_reuse() {
+    tiny_node p, d;
+    tiny_patch cp;
+    size_t i, length;
+    char* json;
+    tiny_init(&p);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&p, "[{\"op\":\"add\",\"path\":\"/v\",\"value\":[1]},{\"op\":\"copy\",\"from\":\"/v\",\"path\":\"/w\"}]"));
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_compile(&cp, &p));
+    tiny_free(&p);
+    for (i = 0; i < 3; i++) {
+        tiny_init(&d);
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&d, "{\"v\":0}"));
+        EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_apply(&cp, &d));
+        json = tiny_stringify(&d, &length);
+        EXPECT_EQ_STRING("{\"v\":[1],\"w\":[1]}", json, length);
+        free(json);
+        tiny_free(&d);
+    }
+    tiny_patch_free(&cp);
+}
+
+static void test_patch() {
+    test_patch_compile();
+    test_patch_apply();
+    test_patch_reuse();
+}
+
+static void test_pointer() {
+    static const char* paths[] = { "/a/b/1", "/a/c", "", "/a/b/0", "/x/y", "/a/b/5", "/x", "/a/b/1" };
+    const size_t n = sizeof(paths) / sizeof(paths[0]);
+    tiny_pointer ptrs[sizeof(paths) / sizeof(paths[0])], ptr;
+    tiny_node node, *out[sizeof(paths) / sizeof(paths[0])], *v;
+    size_t i, length;
+    char* json;
+
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "{\"a\":{\"b\":[true,\"x\"],\"c\":1},\"x/y\":2}"));
+    for (i = 0; i < n; i++)
+        EXPECT_EQ_INT(TINY_PATCH_OK, tiny_pointer_compile(&ptrs[i], paths[i], strlen(paths[i])));
+
+    /* 单个查找 */
+    EXPECT_TRUE(tiny_pointer_get(&node, &ptrs[2]) == &node);
+    v = tiny_pointer_get(&node, &ptrs[0]);
+    EXPECT_TRUE(v != nullptr);
+    EXPECT_EQ_STRING("x", tiny_get_string(v), tiny_get_string_length(v));
+    EXPECT_TRUE(tiny_pointer_get(&node, &ptrs[4]) == nullptr);
+    EXPECT_TRUE(tiny_pointer_get(&node, &ptrs[5]) == nullptr);
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_pointer_compile(&ptr, "/x~1y", 5));
+    EXPECT_EQ_DOUBLE(2.0, tiny_get_number(tiny_pointer_get(&node, &ptr)));
+    tiny_pointer_free(&ptr);
+    EXPECT_EQ_INT(TINY_PATCH_INVALID_POINTER, tiny_pointer_compile(&ptr, "a", 1));
+
+    /* 批量查找与逐个查找结果一致 */
+    EXPECT_EQ_SIZE_T(5, tiny_pointer_get_batch(&node, ptrs, n, out));
+    for (i = 0; i < n; i++)
+        EXPECT_TRUE(out[i] == tiny_pointer_get(&node, &ptrs[i]));
+
+    /* 设置已有的值、添加 object 成员和数组元素, 父节点不存在时失败 */
+    tiny_set_number(tiny_pointer_set(&node, &ptrs[1]), 3.0);
+    EXPECT_TRUE(tiny_pointer_set(&node, &ptrs[4]) == nullptr);
+    tiny_set_null(tiny_pointer_set(&node, &ptrs[6]));
+    EXPECT_EQ_INT(TINY_PATCH_OK, tiny_pointer_compile(&ptr, "/a/b/-", 6));
+    tiny_set_boolean(tiny_pointer_set(&node, &ptr), 0);
+    tiny_pointer_free(&ptr);
+    EXPECT_TRUE(tiny_pointer_set(&node, &ptrs[5]) == nullptr);
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("{\"a\":{\"b\":[true,\"x\",false],\"c\":3},\"x/y\":2,\"x\":null}", json, length);
+    free(json);
+
+    /* 只读查找不展开紧凑数组, 设置时才展开 */
+    {
+        tiny_parse_options options = { nullptr, TINY_PACKED_DOUBLE, 0 };
+        tiny_node* b;
+        tiny_free(&node);
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "{\"a\":{\"b\":[1,2]}}", &options));
+        b = tiny_find_object_value(tiny_find_object_value(&node, "a", 1), "b", 1);
+        v = tiny_pointer_get(&node, &ptrs[0]);
+        EXPECT_EQ_DOUBLE(2.0, tiny_get_number(v));
+        EXPECT_TRUE(tiny_pointer_get(&node, &ptrs[5]) == nullptr);
+        EXPECT_EQ_SIZE_T(4, tiny_pointer_get_batch(&node, ptrs, n, out));
+        EXPECT_TRUE(out[0] == v && out[7] == v);
+        EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(b));
+        tiny_set_number(tiny_pointer_set(&node, &ptrs[0]), 3.0);
+        EXPECT_EQ_INT(TINY_ARRAY, tiny_get_type(b));
+        EXPECT_EQ_DOUBLE(3.0, tiny_get_number(tiny_get_array_element(b, 1)));
+    }
+
+    for (i = 0; i < n; i++) tiny_pointer_free(&ptrs[i]);
+    tiny_free(&node);
+}
+
+#define TEST_PATH(expect, json, expr)\
+    do {\
+        tiny_node doc, out;\
+        tiny_path_result r = { nullptr, 0, 0 };\
+        char* s;\
+        size_t i, length;\
+        tiny_init(&doc);\
+        tiny_init(&out);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&doc, json));\
+        EXPECT_EQ_INT(TINY_PATH_OK, tiny_path_query(&doc, expr, strlen(expr), &r));\
+        tiny_set_array(&out, r.size);\
+        for (i = 0; i < r.size; i++) tiny_copy(tiny_pushback_array_element(&out), r.nodes[i]);\
+        s = tiny_stringify(&out, &length);\
+        EXPECT_EQ_STRING(expect, s, length);\
+        free(s);\
+        tiny_path_result_free(&r);\
+        tiny_free(&out);\
+        tiny_free(&doc);\
+    } while(0)
+
+#define TEST_PATH_ERROR(expr)\
+    do {\
+        tiny_path path;\
+        EXPECT_EQ_INT(TINY_PATH_INVALID_EXPRESSION, tiny_path_compile(&path, expr, strlen(expr)));\
+    } while(0)
+
+static void test_path() {
+    static const char* store = "{\"items\":[{\"id\":1,\"price\":8,\"tag\":\"a\"},{\"id\":2,\"price\":12},"
+        "{\"id\":3,\"price\":20,\"tag\":\"b\"}],\"limit\":10,\"o'k\":{\"id\":4}}";
+    TEST_PATH("[{\"items\":[1]}]", "{\"items\":[1]}", "$");
+    TEST_PATH("[10]", store, "$.limit");
+    TEST_PATH("[{\"id\":4}]", store, "$['o\\'k']");
+    TEST_PATH("[1,2,3]", store, "$.items[*].id");
+    TEST_PATH("[1,2,3,4]", store, "$..id");
+    TEST_PATH("[3]", store, "$.items[-1].id");
+    TEST_PATH("[]", store, "$.items[3].id");
+    TEST_PATH("[]", store, "$.limit.id");
+
+    /* 切片 */
+    TEST_PATH("[1,2]", "[0,1,2,3]", "$[1:3]");
+    TEST_PATH("[0,2]", "[0,1,2,3]", "$[::2]");
+    TEST_PATH("[3,2,1,0]", "[0,1,2,3]", "$[::-1]");
+    TEST_PATH("[2,3]", "[0,1,2,3]", "$[-2:]");
+    TEST_PATH("[3,1]", "[0,1,2,3]", "$[3:0:-2]");
+    TEST_PATH("[]", "[0,1,2,3]", "$[1:3:0]");
+
+    /* 过滤表达式 */
+    TEST_PATH("[2,3]", store, "$.items[?(@.price > 10)].id");
+    TEST_PATH("[2,3]", store, "$.items[?@.price > $.limit].id");
+    TEST_PATH("[1,3]", store, "$.items[?(@.tag)].id");
+    TEST_PATH("[2]", store, "$.items[?(!@.tag)].id");
+    TEST_PATH("[3]", store, "$.items[?(@.tag == 'b' || @.price < 0)].id");
+    TEST_PATH("[1]", store, "$.items[?(@.price <= 8 && !(@.tag != \"a\"))].id");
+    TEST_PATH("[1,2,3]", store, "$.items[?(@.tag >= @.tag)].id");
+    TEST_PATH("[]", store, "$.items[?(@.tag < 1)].id");
+    TEST_PATH("[[3]]", "[[1],[3],[2,3]]", "$[?(@[0] == 3)]");
+
+    /* 紧凑数组在遍历时不展开, 结果是其元素视图 */
+    tiny_node doc;
+    tiny_parse_options options = { nullptr, TINY_PACKED_DOUBLE, 0 };
+    tiny_path path;
+    tiny_path_result r = { nullptr, 0, 0 };
+    tiny_init(&doc);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&doc, "{\"v\":[1,5,9]}", &options));
+    EXPECT_EQ_INT(TINY_PATH_OK, tiny_path_compile(&path, "$.v[?(@ > 4)]", 13));
+    EXPECT_EQ_SIZE_T(2, tiny_path_eval(&path, &doc, &r));
+    EXPECT_EQ_DOUBLE(9.0, tiny_get_number(r.nodes[1]));
+    EXPECT_TRUE(r.nodes[0] == tiny_get_array_element(tiny_find_object_value(&doc, "v", 1), 1));
+    EXPECT_EQ_INT(TINY_NUMBER_ARRAY, tiny_get_type(tiny_find_object_value(&doc, "v", 1)));
+    EXPECT_EQ_SIZE_T(2, tiny_path_eval(&path, &doc, &r));  // 结果数组可复用
+    tiny_path_result_free(&r);
+    tiny_path_free(&path);
+    tiny_free(&doc);
+
+    TEST_PATH_ERROR("");
+    TEST_PATH_ERROR("a");
+    TEST_PATH_ERROR("$.");
+    TEST_PATH_ERROR("$.1a");
+    TEST_PATH_ERROR("$[");
+    TEST_PATH_ERROR("$['a]");
+    TEST_PATH_ERROR("$[1,2]");
+    TEST_PATH_ERROR("$[?(@.a > )]");
+    TEST_PATH_ERROR("$[?(1)]");
+    TEST_PATH_ERROR("$[?(@.*)]");
+    TEST_PATH_ERROR("$[?(@.a == 1]");
+}
+
+#define TEST_DIFF(expect, a, b)\
+    do {\
+        tiny_node na, nb, patch;\
+        tiny_patch cp;\
+        char* json;\
+        size_t length;\
+        tiny_init(&na);\
+        tiny_init(&nb);\
+        tiny_init(&patch);\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&na, a));\
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&nb, b));\
+        tiny_diff(&na, &nb, &patch);\
+        json = tiny_stringify(&patch, &length);\
+        if (expect[0]) EXPECT_EQ_STRING(expect, json, length);\
+        EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_compile(&cp, &patch));\
+        EXPECT_EQ_INT(TINY_PATCH_OK, tiny_patch_apply(&cp, &na));\
+        EXPECT_TRUE(tiny_is_equal(&na, &nb));\
+        tiny_patch_free(&cp);\
+        tiny_free(&na);\
+        tiny_free(&nb);\
+        tiny_free(&patch);\
+        free(json);\
+    } while(0)
+
+static void test_diff() {
+    TEST_DIFF("[]", "{\"a\":[1,2,{\"b\":null}]}", "{\"a\":[1,2,{\"b\":null}]}");
+    TEST_DIFF("[]", "{\"a\":1,\"b\":2}", "{\"b\":2,\"a\":1}");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]", "{\"a\":1}", "[1]");
+    TEST_DIFF("[{\"op\":\"remove\",\"path\":\"/b\"},{\"op\":\"add\",\"path\":\"/c\",\"value\":3}]",
+        "{\"a\":1,\"b\":2}", "{\"a\":1,\"c\":3}");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/a~1b/c~0d\",\"value\":true}]",
+        "{\"a/b\":{\"c~d\":false}}", "{\"a/b\":{\"c~d\":true}}");
+    TEST_DIFF("[{\"op\":\"add\",\"path\":\"/1\",\"value\":4}]", "[1,2,3]", "[1,4,2,3]");
+    TEST_DIFF("[{\"op\":\"remove\",\"path\":\"/1\"}]", "[1,2,3]", "[1,3]");
+    TEST_DIFF("[{\"op\":\"remove\",\"path\":\"/0\"},{\"op\":\"add\",\"path\":\"/2\",\"value\":1}]", "[1,2,3]", "[2,3,1]");
+    TEST_DIFF("[{\"op\":\"replace\",\"path\":\"/1/x\",\"value\":9}]",
+        "[{\"x\":1},{\"x\":2},{\"x\":3}]", "[{\"x\":1},{\"x\":9},{\"x\":3}]");
+
+    /* 生成的 patch 应用到 a 上后应得到 b */
+    TEST_DIFF("", "[1,2,3,4,5,6,7,8]", "[8,7,6,5,4,3,2,1]");
+    TEST_DIFF("", "[\"a\",\"b\",\"c\",\"d\"]", "[\"x\",\"b\",\"y\",\"z\",\"d\",\"w\"]");
+    TEST_DIFF("", "[[1,2],[3,4],5]", "[[1,3],5,[3,4],[]]");
+    TEST_DIFF("", "{\"a\":{\"b\":[1,{\"c\":\"d\"}],\"e\":null},\"f\":[]}",
+        "{\"f\":[true],\"a\":{\"b\":[{\"c\":\"e\"},1],\"g\":0}}");
+    TEST_DIFF("", "[0,-0]", "[-0,0]");
+}
+
+/// @brief 统计未释放字节数的分配器
+static size_t alloc_bytes = 0, alloc_calls = 0;
+
+static void* count_malloc(size_t size, void*) { alloc_bytes += size; alloc_calls++; return malloc(size); }
+static void* count_realloc(void* p, size_t old_size, size_t new_size, void*) { 
+    alloc_bytes += new_size - old_size; alloc_calls++; return realloc(p, new_size); 
+}
+static void count_free(void* p, size_t size, void*) { alloc_bytes -= size; free(p); }
+
+static const tiny_allocator count_allocator = { count_malloc, count_realloc, count_free, nullptr };
+
+static void test_allocator() {
+    tiny_node node, copy;
+    tiny_parse_options options = { &count_allocator, TINY_PACKED_NONE, 0 };
+    size_t length, calls;
+    char* json;
+
+    /* 按次解析使用的分配器 */
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_ex(&node, "{\"a\":[1,\"abc\",{\"b\":null}],\"c\":\"d\"}", &options));
+    EXPECT_TRUE(alloc_calls > 0);
+    EXPECT_TRUE(alloc_bytes > 0);
+    EXPECT_TRUE(tiny_get_allocator() != &count_allocator);
+    {
+        /* 文档在同一分配器下修改、复制、字符串化和释放 */
+        tiny_allocator_scope scope(&count_allocator);
+        tiny_init(&copy);
+        tiny_copy(&copy, &node);
+        tiny_set_string(tiny_set_object_key(&copy, "e", 1), "f", 1);
+        tiny_remove_object(&copy, 0);
+        json = tiny_stringify(&copy, &length);
+        EXPECT_EQ_STRING("{\"c\":\"d\",\"e\":\"f\"}", json, length);
+        count_free(json, length + 1, nullptr);
+        tiny_free(&copy);
+        tiny_free(&node);
+        EXPECT_EQ_SIZE_T(0, alloc_bytes);
+
+        /* 解析失败时也要归还全部内存 */
+        EXPECT_EQ_INT(TINY_PARSE_ROOT_NOT_SINGULAR, tiny_parse(&node, "[\"abc\",{\"d\":[]}] x"));
+        EXPECT_EQ_INT(TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET, tiny_parse(&node, "{\"a\":[\"abc\"]"));
+        EXPECT_EQ_SIZE_T(0, alloc_bytes);
+
+        /* 同一形状的文档复用旧树解析时只分配解析栈, 字符串变短再变回原长也不重新分配 */
+        static const char doc1[] = "{\"a\":[1,\"abc\",{\"b\":null}],\"c\":\"d\"}";
+        static const char doc2[] = "{\"a\":[2,\"x\",{\"b\":true}],\"c\":\"\"}";
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, doc1, sizeof(doc1) - 1));
+        calls = alloc_calls;
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, doc2, sizeof(doc2) - 1));
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse_reuse(&node, doc1, sizeof(doc1) - 1));
+        EXPECT_EQ_SIZE_T(2, alloc_calls - calls);
+        tiny_free(&node);
+        EXPECT_EQ_SIZE_T(0, alloc_bytes);
+    }
+    EXPECT_TRUE(tiny_get_allocator() != &count_allocator);
+
+#if TINY_HAS_PMR
+    {
+        char buffer[4096];
+        std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        tiny_allocator_scope scope(&resource);
+        EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "[\"Hello\",{\"World\":[1,2,3]}]"));
+        EXPECT_TRUE(tiny_get_string(tiny_get_array_element(&node, 0)) >= buffer);
+        EXPECT_TRUE(tiny_get_string(tiny_get_array_element(&node, 0)) < buffer + sizeof(buffer));
+        tiny_free(&node);
+    }
+#endif
+}
+
+static void test_pool() {
+    tiny_node node;
+    const char *s, *e;
+    size_t length;
+    char* json;
+    tiny_allocator_scope scope(&tiny_pool_allocator);
+
+    /* 释放的缓冲区应被下一次解析复用 */
+    tiny_init(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "[\"abc\",1,2]"));
+    e = (const char*)tiny_get_array_element(&node, 0);
+    s = tiny_get_string(tiny_get_array_element(&node, 0));
+    tiny_free(&node);
+    EXPECT_EQ_INT(TINY_PARSE_OK, tiny_parse(&node, "[\"xyz\",3,4]"));
+    EXPECT_TRUE(e == (const char*)tiny_get_array_element(&node, 0));
+    EXPECT_TRUE(s == tiny_get_string(tiny_get_array_element(&node, 0)));
+    EXPECT_EQ_STRING("xyz", tiny_get_string(tiny_get_array_element(&node, 0)), 3);
+    tiny_free(&node);
+
+    /* 同一 size class 内扩容不需要移动 */
+    tiny_set_array(&node, 5);
+    tiny_set_number(tiny_pushback_array_element(&node), 1.0);
+    e = (const char*)tiny_get_array_element(&node, 0);
+    tiny_reserve_array(&node, 6);
+    EXPECT_TRUE(e == (const char*)tiny_get_array_element(&node, 0));
+    tiny_set_string(tiny_pushback_array_element(&node), "a", 1);
+    tiny_reserve_array(&node, 200);  /* 超过最大 size class 时使用 malloc */
+    json = tiny_stringify(&node, &length);
+    EXPECT_EQ_STRING("[1,\"a\"]", json, length);
+    tiny_pool_allocator.free_fn(json, length + 1, tiny_pool_allocator.user);
+    tiny_shrink_array(&node);
+    EXPECT_EQ_SIZE_T(2, tiny_get_array_capacity(&node));
+    tiny_free(&node);
+    tiny_pool_trim();
 }
 
 int main(){
     test_parse();
     test_stringify();
     test_access();
+    test_merge_patch();
+    test_patch();
+    test_pointer();
+    test_path();
+    test_diff();
+    test_allocator();
+    test_pool();
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
 }
@@ -2,11 +2,23 @@
 #include <assert.h>  // assert()
 #include <errno.h>   /* errno, ERANGE */
 #include <math.h>    /* HUGE_VAL */
+#include <stdint.h>  /* uint64_t */
 #include <stdlib.h>  /* NULL, strtod() */
 #include <cstring>    /* memcpy() */
 #include <cctype>  /* isxdigit() */
 #include <string>  /* stoi() */
 #include <iostream>
+#include <atomic>   /* atomic */
+#include <new>      /* placement new */
+#include <thread>   /* thread */
+#include <vector>
+#include <map>     /* map */
+#include <unordered_map>
+#include <algorithm>  /* sort() */
+#ifndef _WIN32
+#include <sys/uio.h>  /* writev() */
+#include <limits.h>   /* IOV_MAX */
+#endif
 using namespace std;
 
 // 定义缓冲区栈的默认大小
@@ -14,8 +26,37 @@ using namespace std;
 #define TINY_PARSE_STACK_INIT_SIZE 256
 #endif 
 
-#ifndef TINY_PARSE_STRINGIFY_INIT_SIZE
-#define TINY_PARSE_STRINGIFY_INIT_SIZE 256
+// 流式输出时内部缓冲块的大小, 块满后交给 sink
+#ifndef TINY_STRINGIFY_CHUNK_SIZE
+#define TINY_STRINGIFY_CHUNK_SIZE 4096
+#endif
+
+// 并行 stringify 时, 节点数少于此值的文档直接走串行路径
+#ifndef TINY_PARALLEL_MIN_NODES
+#define TINY_PARALLEL_MIN_NODES 65536
+#endif
+
+// 并行 stringify 时每个线程平均分到的写出任务数, 以及每个任务平均由多少个计算长度的小段组成
+#ifndef TINY_PARALLEL_TASKS
+#define TINY_PARALLEL_TASKS 8
+#endif
+#ifndef TINY_PARALLEL_GRAIN
+#define TINY_PARALLEL_GRAIN 16
+#endif
+
+// tiny_stringify_fd 中不短于此长度的字符串和 key 直接引用 DOM 中的内存, 更短的复制到缓冲块中
+#ifndef TINY_GATHER_MIN_LENGTH
+#define TINY_GATHER_MIN_LENGTH 64
+#endif
+
+// tiny_stringify_fd 每次 writev 最多提交的 iovec 个数
+#ifndef TINY_GATHER_IOV_SIZE
+#define TINY_GATHER_IOV_SIZE 256
+#endif
+
+// 内存池中每个线程每个 size class 最多缓存的空闲块数
+#ifndef TINY_POOL_CACHE_LIMIT
+#define TINY_POOL_CACHE_LIMIT 1024
 #endif
 
 #define EXPECT(c, ch)       do { assert(*c->json == (ch)); c->json++; } while(0)
@@ -23,40 +64,280 @@ using namespace std;
 #define ISDIGIT1TO9(ch)     ((ch) >= '1' && (ch) <= '9')
 #define PUTC(c, ch)         do { *(char*)tiny_context_push(c, sizeof(char)) = (ch); } while(0);
 #define PUTS(c, s, len)     memcpy(tiny_context_push(c, len), s, len)
+// 生成 JSON 的函数中按模板参数 Exact 选择是否检查容量, 见 tiny_context_put
+#define PUTC_E(c, ch)       do { *tiny_context_put<Exact>(c, 1) = (ch); } while(0)
+#define PUTS_E(c, s, len)   memcpy(tiny_context_put<Exact>(c, len), s, len)
 #define STRING_ERROR(ret)   do { c->top = head; return ret; } while(0)
 
-typedef struct {
-    const char* json;
-    // 栈的相关结构
-    char* stack;
-    size_t size, top;
-} tiny_context;
+/// @brief 默认分配器, 直接使用 malloc/realloc/free
+static void* tiny_std_malloc(size_t size, void*) { return malloc(size); }
+static void* tiny_std_realloc(void* p, size_t, size_t new_size, void*) { return realloc(p, new_size); }
+static void tiny_std_free(void* p, size_t, void*) { free(p); }
+
+static const tiny_allocator tiny_std_allocator = { tiny_std_malloc, tiny_std_realloc, tiny_std_free, nullptr };
+
+// 当前线程使用的分配器
+static thread_local const tiny_allocator* tiny_current_allocator = &tiny_std_allocator;
+
+// 编译期同时定义 TINY_MALLOC(size)、TINY_REALLOC(p, old_size, new_size) 和 TINY_FREE(p, size) 时,
+// 所有分配直接调用这些宏, 没有间接调用的开销, 运行时设置的分配器不再生效
+#if defined(TINY_MALLOC) && defined(TINY_REALLOC) && defined(TINY_FREE)
+#define TINY_STATIC_ALLOCATOR
+#endif
+
+/// @brief 分配 size 个字节, 所有的内存分配都经过此函数和下面两个函数
+static void* tiny_malloc(size_t size) {
+    if (size == 0) return nullptr;
+#ifdef TINY_STATIC_ALLOCATOR
+    return TINY_MALLOC(size);
+#else
+    return tiny_current_allocator->malloc_fn(size, tiny_current_allocator->user);
+#endif
+}
+
+/// @brief 释放由 tiny_malloc 分配的 size 个字节
+static void tiny_dealloc(void* p, size_t size) {
+    if (p == nullptr) return;
+#ifdef TINY_STATIC_ALLOCATOR
+    TINY_FREE(p, size);
+#else
+    tiny_current_allocator->free_fn(p, size, tiny_current_allocator->user);
+#endif
+}
+
+/// @brief 把 old_size 个字节的内存块调整为 new_size 个字节
+static void* tiny_realloc(void* p, size_t old_size, size_t new_size) {
+    if (new_size == 0) {
+        tiny_dealloc(p, old_size);
+        return nullptr;
+    }
+    if (p == nullptr) return tiny_malloc(new_size);
+#ifdef TINY_STATIC_ALLOCATOR
+    return TINY_REALLOC(p, old_size, new_size);
+#else
+    return tiny_current_allocator->realloc_fn(p, old_size, new_size, tiny_current_allocator->user);
+#endif
+}
+
+const tiny_allocator* tiny_get_allocator() {
+    return tiny_current_allocator;
+}
+
+/// @brief 设置当前线程的分配器
+/// @param allocator 分配器, nullptr 表示恢复为 malloc/realloc/free
+/// @return 之前的分配器
+const tiny_allocator* tiny_set_allocator(const tiny_allocator* allocator) {
+    const tiny_allocator* old = tiny_current_allocator;
+    tiny_current_allocator = allocator != nullptr ? allocator : &tiny_std_allocator;
+    return old;
+}
+
+#if TINY_HAS_PMR
+static void* tiny_pmr_malloc(size_t size, void* user) {
+    return ((std::pmr::memory_resource*)user)->allocate(size);
+}
+
+static void* tiny_pmr_realloc(void* p, size_t old_size, size_t new_size, void* user) {
+    void* q = ((std::pmr::memory_resource*)user)->allocate(new_size);
+    memcpy(q, p, std::min(old_size, new_size));
+    ((std::pmr::memory_resource*)user)->deallocate(p, old_size);
+    return q;
+}
+
+static void tiny_pmr_free(void* p, size_t size, void* user) {
+    ((std::pmr::memory_resource*)user)->deallocate(p, size);
+}
+
+/// @brief 把 std::pmr::memory_resource 包装为分配器
+tiny_allocator tiny_make_allocator(std::pmr::memory_resource* resource) {
+    tiny_allocator a = { tiny_pmr_malloc, tiny_pmr_realloc, tiny_pmr_free, resource };
+    assert(resource != nullptr);
+    return a;
+}
+#endif
+
+// 内存池的 size class, 超过最大 size class 的内存直接使用 malloc/free
+static const size_t tiny_pool_class_size[] = { 16, 32, 48, 64, 80, 96, 112, 128, 
+    192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096 };
+#define TINY_POOL_CLASSES   (sizeof(tiny_pool_class_size) / sizeof(tiny_pool_class_size[0]))
+#define TINY_POOL_MAX_SIZE  4096
+
+/// @brief 每个线程独立的空闲块缓存, 空闲块自身的前 8 个字节用作链表指针, 因此线程之间无需加锁
+struct tiny_pool_cache {
+    void* head[TINY_POOL_CLASSES];
+    size_t count[TINY_POOL_CLASSES];
+    ~tiny_pool_cache() { tiny_pool_trim(); }  // 线程退出时把缓存交还给 malloc
+};
+
+static thread_local tiny_pool_cache tiny_pool;
+
+/// @brief 找到能容纳 size 个字节的最小 size class
+static size_t tiny_pool_class(size_t size) {
+    size_t k;
+    assert(size > 0 && size <= TINY_POOL_MAX_SIZE);
+    if (size <= 128) return (size - 1) >> 4;
+    for (k = 8; tiny_pool_class_size[k] < size; k++);
+    return k;
+}
+
+/// @brief 分配 size 个字节, 优先取当前线程缓存的空闲块
+static void* tiny_pool_malloc(size_t size, void*) {
+    size_t k;
+    if (size > TINY_POOL_MAX_SIZE) return malloc(size);
+    k = tiny_pool_class(size);
+    if (tiny_pool.head[k] != nullptr) {
+        void* p = tiny_pool.head[k];
+        tiny_pool.head[k] = *(void**)p;
+        tiny_pool.count[k]--;
+        return p;
+    }
+    return malloc(tiny_pool_class_size[k]);  // 按 size class 的大小分配, 以便放回对应的空闲链表
+}
+
+/// @brief 释放 size 个字节, 放回当前线程的缓存
+static void tiny_pool_free(void* p, size_t size, void*) {
+    if (size <= TINY_POOL_MAX_SIZE) {
+        size_t k = tiny_pool_class(size);
+        if (tiny_pool.count[k] < TINY_POOL_CACHE_LIMIT) {
+            *(void**)p = tiny_pool.head[k];
+            tiny_pool.head[k] = p;
+            tiny_pool.count[k]++;
+            return;
+        }
+    }
+    free(p);
+}
+
+/// @brief 调整内存块大小, 同一 size class 内不需要移动
+static void* tiny_pool_realloc(void* p, size_t old_size, size_t new_size, void*) {
+    void* q;
+    if (old_size > TINY_POOL_MAX_SIZE && new_size > TINY_POOL_MAX_SIZE) return realloc(p, new_size);
+    if (old_size <= TINY_POOL_MAX_SIZE && new_size <= TINY_POOL_MAX_SIZE && 
+        tiny_pool_class(old_size) == tiny_pool_class(new_size)) return p;
+    q = tiny_pool_malloc(new_size, nullptr);
+    memcpy(q, p, std::min(old_size, new_size));
+    tiny_pool_free(p, old_size, nullptr);
+    return q;
+}
+
+const tiny_allocator tiny_pool_allocator = { tiny_pool_malloc, tiny_pool_realloc, tiny_pool_free, nullptr };
+
+/// @brief 把当前线程缓存的空闲块全部交还给 malloc
+void tiny_pool_trim() {
+    for (size_t k = 0; k < TINY_POOL_CLASSES; k++) {
+        while (tiny_pool.head[k] != nullptr) {
+            void* p = tiny_pool.head[k];
+            tiny_pool.head[k] = *(void**)p;
+            free(p);
+        }
+        tiny_pool.count[k] = 0;
+    }
+}
+
+#ifndef _WIN32
+/// @brief 分散写出 (writev) 时收集的 iovec 列表, 缓冲块中的内容和 DOM 中的长字符串交替出现
+struct tiny_gather {
+    int fd;
+    struct iovec iov[TINY_GATHER_IOV_SIZE];
+    int count;
+    size_t mark;  // 缓冲块中尚未加入 iov 的内容的起点
+};
+
+/// @brief 把缓冲块中 [mark, top) 的内容作为一项加入 iov
+static void tiny_gather_seal(tiny_context* c) {
+    tiny_gather* g = c->gather;
+    if (c->top > g->mark) {
+        g->iov[g->count].iov_base = c->stack + g->mark;
+        g->iov[g->count].iov_len = c->top - g->mark;
+        g->count++;
+        g->mark = c->top;
+    }
+}
+
+/// @brief 用 writev 写出全部 iov, 处理部分写入和 EINTR, 出错时记录 errno
+static void tiny_gather_flush(tiny_context* c) {
+    tiny_gather* g = c->gather;
+    struct iovec* iov = g->iov;
+    int count;
+    tiny_gather_seal(c);
+    count = g->count;
+    while (count > 0 && c->status == 0) {
+        ssize_t n = writev(g->fd, iov, count < IOV_MAX ? count : IOV_MAX);
+        if (n < 0) {
+            if (errno != EINTR) c->status = errno;
+            continue;
+        }
+        for (; count > 0 && (size_t)n >= iov->iov_len; count--) n -= (iov++)->iov_len;
+        if (count > 0) {  // 部分写入
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    g->count = 0;
+    g->mark = 0;
+}
+#endif
+
+/// @brief 把栈中已有内容交给 sink 并清空, 出错后只丢弃数据
+static void tiny_context_flush(tiny_context* c) {
+#ifndef _WIN32
+    if (c->gather != nullptr) {
+        tiny_gather_flush(c);
+        c->top = 0;
+        return;
+    }
+#endif
+    assert(c->sink != nullptr);
+    if (c->top > 0 && c->status == 0)
+        c->status = c->sink->write(c->stack, c->top, c->sink->user);
+    c->top = 0;
+}
+
+/// @brief 扩充 tiny_context 的栈, 使其能再容纳 size 个字节
+static void tiny_context_grow(tiny_context* c, size_t size) {
+    size_t old_size = c->size;
+    if (c->sink != nullptr || c->gather != nullptr) {  // 流式输出时先把已有内容交给 sink
+        tiny_context_flush(c);
+        if (c->top + size <= c->size) return;
+    }
+    // 若没有分配内存则分配默认大小的内存
+    if (c->size == 0){
+        c->size = TINY_PARSE_STACK_INIT_SIZE;
+    }
+    while (c->top + size > c->size){
+        // TODO: 研究扩充倍数与性能的关系
+
+        c->size += c->size >> 1;  // 每次扩充为原来的 1.5 倍
+    }
+    c->stack = (char*)tiny_realloc(c->stack, old_size, c->size);  // 重新分配内存
+}
 
 /// @brief 向 tiny_context 中压入数据，但实际上并没有做任何 push 的事情，只是在 c 中开辟了足够的空间，完成数据拷贝的还是 memcpy
 /// @param c tiny_context
 /// @param size 要压入的数据大小
 /// @return 操作后的 top 指针
-static void* tiny_context_push(tiny_context* c, size_t size){
+static inline void* tiny_context_push(tiny_context* c, size_t size){
     void* ret;  // 通用指针类型，使用时要显式地进行类型转换
     assert(size > 0);
-    // 若目前的大小不够
-    if (c->top + size >= c->size){
-        // 若没有分配内存则分配默认大小的内存
-        if (c->size == 0){
-            c->size = TINY_PARSE_STACK_INIT_SIZE;
-        }
-        while (c->top + size >= c->size){
-            // TODO: 研究扩充倍数与性能的关系
-
-            c->size += c->size >> 1;  // 每次扩充为原来的 1.5 倍
-        }
-        c->stack = (char*)realloc(c->stack, c->size);  // 重新分配内存
-    }    
+    // 若目前的大小不够, 扩容放在单独的函数中, 使这里的快速路径可以内联
+    if (c->top + size > c->size) tiny_context_grow(c, size);
     ret = c->stack + c->top;  // 即为目前可以插入数据的位置
     c->top += size; 
     return ret;
 }
 
+/// @brief 为写出 size 个字节留出空间
+/// @tparam Exact 为 true 时缓冲区已按输出长度 (或其上界) 一次分配好且不是流式输出, 不再检查容量
+template <bool Exact>
+static inline char* tiny_context_put(tiny_context* c, size_t size) {
+    char* ret;
+    if (!Exact) return (char*)tiny_context_push(c, size);
+    ret = c->stack + c->top;
+    c->top += size;
+    assert(c->top <= c->size);
+    return ret;
+}
+
 /// @brief 从 tiny_context 的 stack 中弹出数据, 本身不实现 pop 功能，只完成指针的移动
 /// @param c tiny_context
 /// @param size 要弹出的数据大小
@@ -66,6 +347,35 @@ static void* tiny_context_pop(tiny_context* c, size_t size){
     return c->stack + (c->top -= size);  // 注意这里是 -= ，会更新 top 指针位置
 }
 
+/// @brief 写入一段数据, 流式输出时按块切分, 使缓冲区不会因为长字符串而扩容
+template <bool Exact = false>
+static void tiny_context_write(tiny_context* c, const char* s, size_t len) {
+    if (Exact) {
+        if (len > 0) PUTS_E(c, s, len);
+        return;
+    }
+#ifndef _WIN32
+    if (c->gather != nullptr && len >= TINY_GATHER_MIN_LENGTH) {  // 长字符串直接引用, 不复制
+        if (c->gather->count + 3 > TINY_GATHER_IOV_SIZE) tiny_context_flush(c);  // 留一项给 flush 时的尾部内容
+        tiny_gather_seal(c);
+        c->gather->iov[c->gather->count].iov_base = (void*)s;
+        c->gather->iov[c->gather->count].iov_len = len;
+        c->gather->count++;
+        return;
+    }
+#endif
+    while ((c->sink != nullptr || c->gather != nullptr) && c->top + len > c->size) {
+        size_t n = c->size - c->top;
+        if (n > 0) {
+            memcpy(tiny_context_push(c, n), s, n);
+            s += n;
+            len -= n;
+        }
+        tiny_context_flush(c);
+    }
+    if (len > 0) PUTS(c, s, len);
+}
+
 static void tiny_parse_whitespace(tiny_context* c){
     const char *p = c->json;
     while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'){
@@ -106,48 +416,137 @@ static int tiny_parse_false(tiny_context* c, tiny_node* node){
 
 // TODO: 功能更强大的数字解析
 
-static int tiny_parse_number(tiny_context* c, tiny_node* node){
-    const char* p = c->json;
-    if (*p == '-') p++;
-    if (*p == '0') p++;
+/// @brief 按 JSON 语法扫描一个数字
+/// @tparam Bounded 为 true 时不读取 end 及之后的内容, 到达 end 视同遇到 '\0'
+/// @return 数字之后的位置, 不符合语法时返回 nullptr
+template <bool Bounded = false>
+static const char* tiny_scan_number(const char* p, const char* end = nullptr) {
+    auto at = [end](const char* q) { return !Bounded || q < end ? *q : '\0'; };
+    if (at(p) == '-') p++;
+    if (at(p) == '0') p++;
     // 解析整数部分的数字
     else{
-        if (!ISDIGIT1TO9(*p)) return TINY_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT1TO9(at(p))) return nullptr;
+        for (p++; ISDIGIT(at(p)); p++);
     }
     // 解析小数部分的数字
-    if (*p == '.'){
+    if (at(p) == '.'){
         p++;
-        if (!ISDIGIT(*p)) return TINY_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT(at(p))) return nullptr;
+        for (p++; ISDIGIT(at(p)); p++);
     }
     // 解析指数部分的数字
-    if (*p == 'e' || *p == 'E'){
+    if (at(p) == 'e' || at(p) == 'E'){
         p++;
-        if (*p == '+' || *p == '-') p++;
-        if (!ISDIGIT(*p)) return TINY_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (at(p) == '+' || at(p) == '-') p++;
+        if (!ISDIGIT(at(p))) return nullptr;
+        for (p++; ISDIGIT(at(p)); p++);
+    }
+    return p;
+}
+
+/// @tparam Trusted 为 true 时不预先扫描语法, 直接以 strtod 停下的位置作为数字的结尾
+template <bool Trusted = false>
+static int tiny_parse_number(tiny_context* c, tiny_node* node){
+    const char* p;
+    if (Trusted) {
+        char* end;
+        errno = 0;
+        node->n = strtod(c->json, &end);
+        if (end == c->json) return TINY_PARSE_INVALID_VALUE;  // 保证每次至少前进一个字符
+        p = end;
+    }
+    else {
+        if ((p = tiny_scan_number(c->json)) == nullptr) return TINY_PARSE_INVALID_VALUE;
+        errno = 0;  // 程序异常的状态码
+        node->n = strtod(c->json, nullptr);
     }
-    errno = 0;  // 程序异常的状态码
-    node->n = strtod(c->json, nullptr);
     // 解析到过大的数字
     if (errno == ERANGE && (node->n == HUGE_VAL || node->n == -HUGE_VAL))
         return TINY_PARSE_NUMBER_TOO_BIG;
+    node->d.s = nullptr;
+    node->type = TINY_NUMBER;
+    c->json = p;
+    return TINY_PARSE_OK;
+}
+
+/// @brief 只检查语法并复制原文, 不调用 strtod; n 置为 NaN 表示尚未转换, 由 tiny_get_number 首次读取时转换
+static int tiny_parse_lazy_number(tiny_context* c, tiny_node* node) {
+    const char* p = tiny_scan_number(c->json);
+    size_t len;
+    if (p == nullptr) return TINY_PARSE_INVALID_VALUE;
+    len = p - c->json;
+    memcpy(node->d.s = (char*)tiny_malloc(len + 1), c->json, len);
+    node->d.s[len] = '\0';  // strtod 需要结束符
+    node->d.len = len;
+    node->n = NAN;
     node->type = TINY_NUMBER;
     c->json = p;
     return TINY_PARSE_OK;
 }
 
+// TINY_DECIMAL 的指数和位数的上限, 使指数加上位数仍在 int 范围内
+#define TINY_DECIMAL_MAX 999999999
+
+/// @brief 把数字解析为 TINY_DECIMAL, 不调用 strtod
+/// 整数和小数部分的数字先连续写入栈中, 去掉前导和末尾的 0 后复制到节点, 小数位数和末尾的 0 折算到指数中
+static int tiny_parse_decimal(tiny_context* c, tiny_node* node) {
+    const char* p = tiny_scan_number(c->json), *q = c->json, *s;
+    size_t head = c->top, len, lead = 0;
+    int64_t exp = 0, frac = 0;
+    char* d;
+    int neg;
+    if (p == nullptr) return TINY_PARSE_INVALID_VALUE;
+    if ((neg = *q == '-')) q++;
+    for (s = q; ISDIGIT(*q); q++) ;
+    PUTS(c, s, q - s);
+    if (*q == '.') {
+        for (s = ++q; ISDIGIT(*q); q++) ;
+        frac = q - s;
+        if (frac > 0) PUTS(c, s, frac);
+    }
+    if (*q == 'e' || *q == 'E') {
+        int eneg = 0;
+        if (*++q == '+' || *q == '-') eneg = *q++ == '-';
+        for (; ISDIGIT(*q); q++)
+            if (exp <= TINY_DECIMAL_MAX) exp = exp * 10 + (*q - '0');  // 超出上限后不再累加, 以免溢出
+        if (eneg) exp = -exp;
+    }
+    len = c->top - head;
+    d = (char*)tiny_context_pop(c, len);
+    while (lead < len && d[lead] == '0') lead++;
+    while (len > lead && d[len - 1] == '0') {
+        len--;
+        exp++;
+    }
+    len -= lead;
+    exp -= frac;
+    if (len == 0) neg = 0, exp = 0;  // 0 只有一种表示
+    else if (exp > TINY_DECIMAL_MAX || exp < -TINY_DECIMAL_MAX || len > TINY_DECIMAL_MAX)
+        return TINY_PARSE_NUMBER_TOO_BIG;
+    node->x.s = (char*)tiny_malloc(len);
+    if (len > 0) memcpy(node->x.s, d + lead, len);
+    node->x.len = len;
+    node->x.exp = (int)exp;
+    node->x.neg = neg;
+    node->type = TINY_DECIMAL;
+    c->json = p;
+    return TINY_PARSE_OK;
+}
+
 /// @brief 解析 json 节点中的十六进制数字
 /// @param p json 内容指针
 /// @param u 解析出的数字
+/// @tparam Trusted 为 true 时不检查字符, 调用者需保证还有 4 个字节
 /// @return 解析移动后的 json 内容指针
+template <bool Trusted = false>
 static const char* tiny_parse_hex4(const char* p, unsigned* u) {
     *u = 0;
     for (int i = 0; i < 4; i++) {
         char ch = *p++;
         *u <<= 4;  // 左移四位，相当于乘16
-        if      (ch >= '0' && ch <= '9') *u |= ch - '0';  // 相当于加
+        if (Trusted) *u |= (ch & 0xF) + (ch >> 6) * 9;  // 字母的低 4 位是 1~6, 再加上 9
+        else if (ch >= '0' && ch <= '9') *u |= ch - '0';  // 相当于加
         else if (ch >= 'A' && ch <= 'F') *u |= ch - ('A' - 10);
         else if (ch >= 'a' && ch <= 'f') *u |= ch - ('a' - 10);
         else return nullptr;
@@ -178,11 +577,33 @@ static void tiny_encode_utf8(tiny_context* c, unsigned u) {
     }
 }
 
+/// @brief 检查以非 ASCII 字节开头的 UTF-8 序列, 按 Unicode 标准表 3-7 限定第二个字节的范围,
+/// 从而拒绝超长编码、代理项 (U+D800~U+DFFF) 和大于 U+10FFFF 的码点
+/// @return 序列的字节数, 不合法时返回 0; 遇到 '\0' 时续字节检查失败, 不会越过字符串结尾
+static size_t tiny_utf8_length(const unsigned char* p) {
+    unsigned char lo = 0x80, hi = 0xBF;
+    if (p[0] < 0xC2 || p[0] > 0xF4) return 0;  // 续字节、超长的两字节序列或超出范围的首字节
+    if (p[0] < 0xE0) return (p[1] & 0xC0) == 0x80 ? 2 : 0;
+    if (p[0] == 0xE0) lo = 0xA0;
+    else if (p[0] == 0xED) hi = 0x9F;
+    else if (p[0] == 0xF0) lo = 0x90;
+    else if (p[0] == 0xF4) hi = 0x8F;
+    if (p[1] < lo || p[1] > hi || (p[2] & 0xC0) != 0x80) return 0;
+    if (p[0] < 0xF0) return 3;
+    return (p[3] & 0xC0) == 0x80 ? 4 : 0;
+}
+
+static size_t tiny_escape_scan(const char* s, size_t len);  // forward declare
+static size_t tiny_ascii_scan(const char* s, size_t len);
+
 /// @brief 解析 JSON 字符串，把结果写入 str 和 len
 /// @param c tiny_context, 临时存放解析结果
 /// @param str 写入的字符串
 /// @param len 字符串长度
+/// @tparam Trusted 为 true 时按块复制不需要转义的部分, 控制字符原样复制, \\u 转义不检查十六进制数字和代理项,
+/// 只在 '"'、'\\' 和输入结尾 c->end 处停下
 /// @return 解析状态码
+template <bool Trusted = false>
 static int tiny_parse_string_raw(tiny_context* c, char** str, size_t* len) {
     int ret;  // 返回值
     size_t head = c->top;
@@ -192,6 +613,13 @@ static int tiny_parse_string_raw(tiny_context* c, char** str, size_t* len) {
     p = c->json;
 
     for(;;) {
+        if (Trusted) {
+            size_t n = tiny_escape_scan(p, c->end - p);
+            if (n > 0) {
+                PUTS(c, p, n);
+                p += n;
+            }
+        }
         char ch = *p++;
         switch (ch) {
         case '\"':  // 意味着字符串结束
@@ -210,6 +638,17 @@ static int tiny_parse_string_raw(tiny_context* c, char** str, size_t* len) {
                 case 'r':  PUTC(c, '\r'); break;
                 case 't':  PUTC(c, '\t'); break;
                 case 'u':
+                    if (Trusted) {
+                        if (c->end - p < 4) STRING_ERROR(TINY_PARSE_INVALID_UNICODE_HEX);
+                        p = tiny_parse_hex4<true>(p, &u);
+                        if (u >= 0xD800 && u <= 0xDBFF) {
+                            if (c->end - p < 6) STRING_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE);
+                            p = tiny_parse_hex4<true>(p + 2, &u2);
+                            u = (((u - 0xD800) << 10) | (u2 & 0x3FF)) + 0x10000;  // 取低 10 位, 保证不超过 U+10FFFF
+                        }
+                        tiny_encode_utf8(c, u);
+                        break;
+                    }
                     if (!(p = tiny_parse_hex4(p, &u))) STRING_ERROR(TINY_PARSE_INVALID_UNICODE_HEX);
                     if (u >= 0xD800 && u <= 0xDBFF) {
                         if (*p++ != '\\') STRING_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE);
@@ -218,6 +657,8 @@ static int tiny_parse_string_raw(tiny_context* c, char** str, size_t* len) {
                         if (u2 < 0xDC00 || u2 > 0xDFFF) STRING_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE);
                         u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
                     }
+                    else if (u >= 0xDC00 && u <= 0xDFFF && (c->options->flags & TINY_PARSE_STRICT_UTF8))
+                        STRING_ERROR(TINY_PARSE_INVALID_UNICODE_SURROGATE);  // 单独的低代理项
                     tiny_encode_utf8(c, u);
                     break;
                 default: STRING_ERROR(TINY_PARSE_INVALID_STRING_ESCAPE);
@@ -225,51 +666,218 @@ static int tiny_parse_string_raw(tiny_context* c, char** str, size_t* len) {
             break;
         case '\0': STRING_ERROR(TINY_PARSE_MISS_QUOTATION_MARK);
         default:
-            if ((unsigned char)ch < 0x20) STRING_ERROR(TINY_PARSE_INVALID_STRING_CHAR);
+            if (!Trusted && (unsigned char)(ch - 0x20) >= 0x60) {  // 只有控制字符和非 ASCII 字节需要进一步检查
+                if ((unsigned char)ch < 0x20) STRING_ERROR(TINY_PARSE_INVALID_STRING_CHAR);
+                if (c->options->flags & TINY_PARSE_STRICT_UTF8) {
+                    size_t n = tiny_utf8_length((const unsigned char*)p - 1);
+                    if (n == 0) STRING_ERROR(TINY_PARSE_INVALID_UTF8);
+                    PUTS(c, p - 1, n);
+                    p += n - 1;
+                    break;
+                }
+            }
             PUTC(c, ch);
         }
     }
 }
 
+/// @brief 不含转义的字符串直接引用输入中的字节, 不经过栈也不复制
+/// @return 遇到转义、控制字符、输入结尾或 (严格模式下) 非 ASCII 字节时返回 0, 由调用者按普通方式重新解析
+static int tiny_parse_string_view(tiny_context* c, tiny_node* node) {
+    const char* p = c->json + 1;
+    size_t n = (c->options->flags & TINY_PARSE_STRICT_UTF8) ? tiny_ascii_scan(p, c->end - p) : tiny_escape_scan(p, c->end - p);
+    if (p[n] != '"') return 0;
+    node->s.s = (char*)p;
+    node->s.len = n;
+    node->s.capacity = 0;
+    node->type = TINY_STRING;
+    c->json = p + n + 1;
+    return 1;
+}
+
 /// @brief 解析字符串并写入 json 节点
 /// @param c tiny_context
 /// @param node json 节点
 /// @return 解析状态码
+template <bool Trusted = false>
 static int tiny_parse_string(tiny_context* c, tiny_node* node){
     int ret;
     char* s;
     size_t len;
-    if ((ret = tiny_parse_string_raw(c, &s, &len)) == TINY_PARSE_OK) 
+    if ((c->options->flags & TINY_PARSE_BORROW_STRINGS) && tiny_parse_string_view(c, node)) return TINY_PARSE_OK;
+    if ((ret = tiny_parse_string_raw<Trusted>(c, &s, &len)) != TINY_PARSE_OK) return ret;
+    tiny_node* old = c->reuse;
+    if (old != nullptr && old->type == TINY_STRING && old->s.capacity > len) {
+        // 旧字符串的缓冲区足够大时直接覆盖, 保留原来的 capacity 以便按原大小释放
+        memcpy(old->s.s, s, len);
+        old->s.s[len] = '\0';
+        old->s.len = len;
+        memcpy(node, old, sizeof(tiny_node));
+        old->type = TINY_NULL;
+    }
+    else
         tiny_set_string(node, s, len);
     return ret;
 }
 
+template <bool Trusted = false>
 static int tiny_parse_value(tiny_context* c, tiny_node* node);  // forward declare
 
+/// @brief 可信输入中的字面量只检查剩余长度, 不比较内容
+static int tiny_parse_trusted_literal(tiny_context* c, tiny_node* node, tiny_type type, size_t len) {
+    if ((size_t)(c->end - c->json) < len) return TINY_PARSE_INVALID_VALUE;
+    c->json += len;
+    node->type = type;
+    return TINY_PARSE_OK;
+}
+
+// tiny_parse_packed 遇到非数字元素时的返回值, 调用者改按普通数组解析
+#define TINY_PARSE_NOT_PACKED (-1)
+
+/// @brief 紧凑数字数组中元素的字节数
+static size_t tiny_packed_size(tiny_packed_type type) {
+    return type == TINY_PACKED_FLOAT ? sizeof(float) : sizeof(double);
+}
+
+// 紧凑数组的数据前面留出一个头部, 存放只读访问元素时按需构造的元素视图, 见 tiny_packed_views
+typedef std::atomic<tiny_node*> tiny_packed_header;
+#define TINY_PACKED_HEADER sizeof(double)  // 保持元素按 8 字节对齐
+static_assert(sizeof(tiny_packed_header) <= TINY_PACKED_HEADER, "packed header too large");
+
+static tiny_packed_header* tiny_packed_head(const tiny_node* node) {
+    return (tiny_packed_header*)((char*)node->v.p - TINY_PACKED_HEADER);
+}
+
+/// @brief 分配 size 个 type 类型元素的紧凑数组数据, 返回元素的起始地址
+static void* tiny_packed_alloc(tiny_packed_type type, size_t size) {
+    char* p = (char*)tiny_malloc(TINY_PACKED_HEADER + size * tiny_packed_size(type));
+    new (p) tiny_packed_header(nullptr);
+    return p + TINY_PACKED_HEADER;
+}
+
+/// @brief 按整数解析数字, 不是整数或超出 int64_t 范围时返回 0
+static int tiny_parse_int64(const char** json, int64_t* out) {
+    const char* p = *json;
+    uint64_t u = 0, limit = (uint64_t)INT64_MAX;
+    if (*p == '-') {
+        p++;
+        limit++;
+    }
+    if (*p == '0') p++;
+    else {
+        if (!ISDIGIT1TO9(*p)) return 0;
+        for (; ISDIGIT(*p); p++) {
+            if (u > (limit - (*p - '0')) / 10) return 0;
+            u = u * 10 + (*p - '0');
+        }
+    }
+    if (*p == '.' || *p == 'e' || *p == 'E') return 0;
+    *out = **json == '-' ? (int64_t)(0 - u) : (int64_t)u;
+    *json = p;
+    return 1;
+}
+
+/// @brief 把全为数字的数组直接解析为 TINY_NUMBER_ARRAY, 数字逐个写入栈中, 不构造 tiny_node
+/// 要求 int64 时遇到非整数、要求 float 时遇到超出范围的数, 都整体改为 double
+/// @return 遇到非数字元素或格式错误时回退到数组开头并返回 TINY_PARSE_NOT_PACKED
+static int tiny_parse_packed(tiny_context* c, tiny_node* node) {
+    const char* start = c->json;
+    size_t head = c->top, size = 0, i;
+    tiny_packed_type type = c->options->packed;
+    tiny_node e;
+    int ret;
+    for (;;) {
+        if (*c->json != '-' && !ISDIGIT(*c->json)) break;
+        if (type == TINY_PACKED_INT64) {
+            int64_t n;
+            if (tiny_parse_int64(&c->json, &n)) {
+                memcpy(tiny_context_push(c, sizeof(int64_t)), &n, sizeof(int64_t));
+                goto next;
+            }
+            // 已解析的整数原地转为 double, 两者大小相同
+            for (i = 0; i < size; i++) {
+                char* p = c->stack + head + i * sizeof(double);
+                int64_t v;
+                double d;
+                memcpy(&v, p, sizeof(v));
+                d = (double)v;
+                memcpy(p, &d, sizeof(d));
+            }
+            type = TINY_PACKED_DOUBLE;
+        }
+        if ((ret = tiny_parse_number(c, &e)) != TINY_PARSE_OK) {
+            c->top = head;
+            return ret;
+        }
+        if (type == TINY_PACKED_FLOAT) {
+            float f = (float)e.n;
+            if (!isinf(f)) {
+                memcpy(tiny_context_push(c, sizeof(float)), &f, sizeof(float));
+                goto next;
+            }
+            // 超出 float 范围时整体改为 double 重新解析, 以免已解析的元素损失精度
+            c->json = start;
+            c->top = head;
+            size = 0;
+            type = TINY_PACKED_DOUBLE;
+            continue;
+        }
+        memcpy(tiny_context_push(c, sizeof(double)), &e.n, sizeof(double));
+    next:
+        size++;
+        tiny_parse_whitespace(c);
+        if (*c->json == ',') {
+            c->json++;
+            tiny_parse_whitespace(c);
+        }
+        else if (*c->json == ']') {
+            size_t n = size * tiny_packed_size(type);
+            c->json++;
+            node->type = TINY_NUMBER_ARRAY;
+            node->v.size = size;
+            node->v.type = type;
+            memcpy(node->v.p = tiny_packed_alloc(type, size), tiny_context_pop(c, n), n);
+            return TINY_PARSE_OK;
+        }
+        else break;
+    }
+    c->json = start;
+    c->top = head;
+    return TINY_PARSE_NOT_PACKED;
+}
+
+static inline void tiny_cache_forget(const void* buffer);  // forward declare
+
+/// @tparam Trusted 为 true 时元素之后不是 ']' 就当作 ','
+template <bool Trusted>
 static int tiny_parse_array(tiny_context* c, tiny_node* node) {
     size_t size = 0;  // 维护 array 的 size
     int ret;  // 维护返回值
+    tiny_node* old = c->reuse != nullptr && c->reuse->type == TINY_ARRAY ? c->reuse : nullptr;
     EXPECT(c, '[');
     tiny_parse_whitespace(c);  // 处理空格
     // 空的 array
     if (*c->json == ']') {
         c->json++;
         node->type = TINY_ARRAY;
-        node->a.size = 0;
+        node->a.size = node->a.capacity = 0;
         node->a.e = nullptr;  // 空指针！困扰了两天的bug
         return TINY_PARSE_OK;
     }
+    if (c->options->packed != TINY_PACKED_NONE && (ret = tiny_parse_packed(c, node)) != TINY_PARSE_NOT_PACKED)
+        return ret;
 
     for (;;) {
         tiny_node e;
         tiny_init(&e);  // 初始化 json 节点来存放 array 中的 element
+        c->reuse = old != nullptr && size < old->a.size ? &old->a.e[size] : nullptr;
         // 逐个解析 array 中的 element，并将信息存在 e 中
-        if ((ret = tiny_parse_value(c, &e)) != TINY_PARSE_OK) break;
+        if ((ret = tiny_parse_value<Trusted>(c, &e)) != TINY_PARSE_OK) break;
         // 将解析得到的 array 节点压入栈
         memcpy(tiny_context_push(c, sizeof(tiny_node)), &e, sizeof(tiny_node));
         size++;
         tiny_parse_whitespace(c);
-        if (*c->json == ',') {
+        if (Trusted ? *c->json != ']' && *c->json != '\0' : *c->json == ',') {
             c->json++;  // element 的分隔符
             tiny_parse_whitespace(c);
         }
@@ -277,10 +885,20 @@ static int tiny_parse_array(tiny_context* c, tiny_node* node) {
         else if (*c->json == ']') {
             c->json++;
             node->type = TINY_ARRAY;
-            node->a.size = size;
+            node->a.size = node->a.capacity = size;
+            if (old != nullptr && old->a.capacity >= size) {
+                // 接管旧数组的缓冲区, 先释放其中没有被接管的元素
+                for (size_t i = 0; i < old->a.size; i++) tiny_free(&old->a.e[i]);
+                tiny_cache_forget(old->a.e);
+                node->a.e = old->a.e;
+                node->a.capacity = old->a.capacity;
+                old->type = TINY_NULL;
+            }
+            else
+                node->a.e = (tiny_node*)tiny_malloc(size * sizeof(tiny_node));
             size *= sizeof(tiny_node);
             // 将结果拷贝到当前节点的对应结构中
-            memcpy(node->a.e = (tiny_node*)malloc(size), tiny_context_pop(c, size), size);
+            memcpy(node->a.e, tiny_context_pop(c, size), size);
             return TINY_PARSE_OK;
         }
         // 在 array 中解析完一个 element 只可能遇到 , 或 ]; 其余均为无效情况
@@ -296,10 +914,33 @@ static int tiny_parse_array(tiny_context* c, tiny_node* node) {
     return ret;
 }
 
+static void tiny_member_set_key(tiny_member* m, const char* key, size_t klen);  // forward declare
+static void tiny_member_escape_key(tiny_member* m);
+static void tiny_member_free_key(tiny_member* m);
+
+/// @brief 复用旧成员的 key 缓冲区, 仅在 old->keycap > klen 时调用; 内容不同时覆盖并重新计算转义缓存
+static void tiny_member_reuse_key(tiny_member* m, tiny_member* old, const char* key, size_t klen) {
+    m->key = old->key;
+    m->keycap = old->keycap;
+    m->escaped = old->escaped;
+    old->key = old->escaped = nullptr;
+    if (old->keylen == klen && memcmp(m->key, key, klen) == 0) {
+        m->keylen = klen;
+        return;
+    }
+    memcpy(m->key, key, klen);
+    m->key[m->keylen = klen] = '\0';
+    if (m->escaped != nullptr) tiny_dealloc(m->escaped, strlen(m->escaped) + 1);
+    tiny_member_escape_key(m);
+}
+
+/// @tparam Trusted 为 true 时键之后的字符当作 ':', 值之后不是 '}' 就当作 ','
+template <bool Trusted>
 static int tiny_parse_object(tiny_context* c, tiny_node* node) {
     size_t size;
     tiny_member m;  // 创建临时 member 存放当前数据
     int ret;
+    tiny_node* old = c->reuse != nullptr && c->reuse->type == TINY_OBJECT ? c->reuse : nullptr;
     EXPECT(c, '{');
     tiny_parse_whitespace(c);  // 解析空格
 
@@ -307,11 +948,12 @@ static int tiny_parse_object(tiny_context* c, tiny_node* node) {
         c->json++;
         node->type = TINY_OBJECT;
         node->o.m = 0;
-        node->o.size = 0;
+        node->o.size = node->o.capacity = 0;
         return TINY_PARSE_OK;
     }
 
     m.key = NULL;
+    m.escaped = NULL;
     size = 0;
     for(;;) {
         tiny_init(&m.value);
@@ -322,25 +964,27 @@ static int tiny_parse_object(tiny_context* c, tiny_node* node) {
             ret = TINY_PARSE_MISS_KEY;
             break;
         }
-        if ((ret = tiny_parse_string_raw(c, &str, &m.keylen)) != TINY_PARSE_OK) break;
-        memcpy(m.key = (char*)malloc(m.keylen + 1), str, m.keylen);
-        m.key[m.keylen] = '\0';
+        if ((ret = tiny_parse_string_raw<Trusted>(c, &str, &len)) != TINY_PARSE_OK) break;
+        tiny_member* om = old != nullptr && size < old->o.size ? &old->o.m[size] : nullptr;
+        if (om != nullptr && om->key != nullptr && om->keycap > len) tiny_member_reuse_key(&m, om, str, len);
+        else tiny_member_set_key(&m, str, len);
         /* parse ws colon ws */
         tiny_parse_whitespace(c);
-        if (*c->json != ':') {
+        if (Trusted ? *c->json == '\0' : *c->json != ':') {
             ret = TINY_PARSE_MISS_COLON;
             break;
         }
         c->json++;
         tiny_parse_whitespace(c);
         /* parse value */
-        if ((ret = tiny_parse_value(c, &m.value)) != TINY_PARSE_OK) break;
+        c->reuse = om != nullptr ? &om->value : nullptr;
+        if ((ret = tiny_parse_value<Trusted>(c, &m.value)) != TINY_PARSE_OK) break;
         memcpy(tiny_context_push(c, sizeof(tiny_member)), &m, sizeof(tiny_member));
         size++;
-        m.key = NULL; /* ownership is transferred to member on stack */
+        m.key = m.escaped = NULL; /* ownership is transferred to member on stack */
         /* parse ws [comma | right-curly-brace] ws */
         tiny_parse_whitespace(c);
-        if (*c->json == ',') {
+        if (Trusted ? *c->json != '}' && *c->json != '\0' : *c->json == ',') {
             c->json++;
             tiny_parse_whitespace(c);
         }
@@ -348,8 +992,21 @@ static int tiny_parse_object(tiny_context* c, tiny_node* node) {
             size_t s = sizeof(tiny_member) * size;
             c->json++;
             node->type = TINY_OBJECT;
-            node->o.size = size;
-            memcpy(node->o.m = (tiny_member*)malloc(s), tiny_context_pop(c, s), s);
+            node->o.size = node->o.capacity = size;
+            if (old != nullptr && old->o.capacity >= size) {
+                // 接管旧对象的缓冲区, key 已被接管的成员只剩下值需要释放
+                for (size_t i = 0; i < old->o.size; i++) {
+                    tiny_member_free_key(&old->o.m[i]);
+                    tiny_free(&old->o.m[i].value);
+                }
+                tiny_cache_forget(old->o.m);
+                node->o.m = old->o.m;
+                node->o.capacity = old->o.capacity;
+                old->type = TINY_NULL;
+            }
+            else
+                node->o.m = (tiny_member*)tiny_malloc(s);
+            memcpy(node->o.m, tiny_context_pop(c, s), s);
             return TINY_PARSE_OK;
         }
         else {
@@ -358,560 +1015,4265 @@ static int tiny_parse_object(tiny_context* c, tiny_node* node) {
         }
     }
     /* Pop and free members on the stack */
-    free(m.key);
+    if (m.key) tiny_member_free_key(&m);
     for (size_t i = 0; i < size; i++) {
         tiny_member* m = (tiny_member*)tiny_context_pop(c, sizeof(tiny_member));
-        free(m->key);
+        tiny_member_free_key(m);
         tiny_free(&m->value);
     }
     node->type = TINY_NULL;
     return ret;
 }
 
+template <bool Trusted>
 static int tiny_parse_value(tiny_context* c, tiny_node* node){
     switch (*c->json) {
-        case 'n' : return tiny_parse_null(c, node);
-        case 't' : return tiny_parse_true(c, node);
-        case 'f' : return tiny_parse_false(c, node);
-        default  : return tiny_parse_number(c, node);
-        case '"' : return tiny_parse_string(c, node);
-        case '[' : return tiny_parse_array(c, node);
-        case '{' : return tiny_parse_object(c, node);
+        case 'n' : return Trusted ? tiny_parse_trusted_literal(c, node, TINY_NULL, 4)  : tiny_parse_null(c, node);
+        case 't' : return Trusted ? tiny_parse_trusted_literal(c, node, TINY_TRUE, 4)  : tiny_parse_true(c, node);
+        case 'f' : return Trusted ? tiny_parse_trusted_literal(c, node, TINY_FALSE, 5) : tiny_parse_false(c, node);
+        default  :
+            if (c->options->flags & (TINY_PARSE_LAZY_NUMBER | TINY_PARSE_DECIMAL))
+                return (c->options->flags & TINY_PARSE_DECIMAL) ? tiny_parse_decimal(c, node) : tiny_parse_lazy_number(c, node);
+            return tiny_parse_number<Trusted>(c, node);
+        case '"' : return tiny_parse_string<Trusted>(c, node);
+        case '[' : return tiny_parse_array<Trusted>(c, node);
+        case '{' : return tiny_parse_object<Trusted>(c, node);
         case '\0': return TINY_PARSE_EXPECT_VALUE;  // '\0' 代表字符串结束符，因此可以判断是否为空
     }
 }
 
-int tiny_parse(tiny_node* node, const char* json){
-    tiny_context c;
-    int ret;
-    assert(node != nullptr);
-    
-    c.json = json;  // 存储数据
-    c.stack = nullptr;
-    c.size = c.top = 0;  // 初始化栈结构
+// 下面的跳过函数供 tiny_validate 和 tiny_parse_projected 使用, 所有读取都限制在 c->end 之前, 输入不必以 '\0' 结尾
 
-    tiny_init(node);  // 初始化节点
-    tiny_parse_whitespace(&c);  // 处理空格
-    if ((ret = tiny_parse_value(&c, node)) == TINY_PARSE_OK){
-        tiny_parse_whitespace(&c);  // 处理字符串后空格
-        if (*c.json != '\0'){  // 处理完后指向的不是字符串的结束符，即后面还有其他字符
-            node->type = TINY_NULL;
-            ret = TINY_PARSE_ROOT_NOT_SINGULAR;
-        }
-    }
-    assert(c.top == 0);  // 正常处理后栈应该弹空
-    free(c.stack);  // 释放栈空间
-    return ret;
+/// @brief 当前位置的字符, 到达 c->end 时返回 '\0'
+static inline char tiny_skip_peek(const tiny_context* c) {
+    return c->json < c->end ? *c->json : '\0';
 }
 
-// 字符串化未优化版本
-static void tiny_stringify_string(tiny_context* c, const char* s, size_t len, bool) {
-    size_t i;
-    assert(s != nullptr);
-    PUTC(c, '"');
-    for (i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) {
-            case '\"': PUTS(c, "\\\"", 2); break;
-            case '\\': PUTS(c, "\\\\", 2); break;
-            case '\b': PUTS(c, "\\b",  2); break;
-            case '\f': PUTS(c, "\\f",  2); break;
-            case '\n': PUTS(c, "\\n",  2); break;
-            case '\r': PUTS(c, "\\r",  2); break;
-            case '\t': PUTS(c, "\\t",  2); break;
-            default:
-                if (ch < 0x20) {
-                    char buffer[7];
-                    sprintf(buffer, "\\u%04x", ch);
-                    PUTS(c, buffer, 6);
-                }
-                else PUTC(c, s[i]);
+static void tiny_skip_whitespace(tiny_context* c) {
+    const char* p = c->json;
+    while (p < c->end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    c->json = p;
+}
+
+/// @brief 跳过一个字符串, 与 tiny_parse_string_raw 做同样的检查但不写出内容
+/// 出错时 c->json 指向出错的字符或转义序列
+static int tiny_skip_string(tiny_context* c) {
+    const char* p = c->json + 1;
+    const char* q;
+    unsigned u;
+    size_t n;
+    int strict = c->options->flags & TINY_PARSE_STRICT_UTF8;
+    for (;;) {
+        p += strict ? tiny_ascii_scan(p, c->end - p) : tiny_escape_scan(p, c->end - p);  // 普通字符按字跳过
+        if (p == c->end) return c->json = p, TINY_PARSE_MISS_QUOTATION_MARK;
+        char ch = *p++;
+        if (ch == '\"') break;
+        if (ch == '\\') {
+            q = p - 1;
+            if (p == c->end) return c->json = q, TINY_PARSE_INVALID_STRING_ESCAPE;
+            switch (*p++) {
+                case '\"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': break;
+                case 'u':
+                    if (c->end - p < 4 || !(p = tiny_parse_hex4(p, &u))) return c->json = q, TINY_PARSE_INVALID_UNICODE_HEX;
+                    if (u >= 0xD800 && u <= 0xDBFF) {
+                        if (c->end - p < 6 || p[0] != '\\' || p[1] != 'u') return c->json = q, TINY_PARSE_INVALID_UNICODE_SURROGATE;
+                        if (!(p = tiny_parse_hex4(p + 2, &u))) return c->json = q, TINY_PARSE_INVALID_UNICODE_HEX;
+                        if (u < 0xDC00 || u > 0xDFFF) return c->json = q, TINY_PARSE_INVALID_UNICODE_SURROGATE;
+                    }
+                    else if (u >= 0xDC00 && u <= 0xDFFF && strict) return c->json = q, TINY_PARSE_INVALID_UNICODE_SURROGATE;
+                    break;
+                default: return c->json = q, TINY_PARSE_INVALID_STRING_ESCAPE;
+            }
+        }
+        else if (ch == '\0') return c->json = p - 1, TINY_PARSE_MISS_QUOTATION_MARK;
+        else if ((unsigned char)ch < 0x20) return c->json = p - 1, TINY_PARSE_INVALID_STRING_CHAR;
+        else if ((unsigned char)ch >= 0x80 && strict) {
+            unsigned char tail[4] = { 0 };  // 结尾不足 4 字节时补 0 后检查, 补的 0 不是续字节
+            const unsigned char* s = (const unsigned char*)p - 1;
+            if (c->end - (p - 1) < 4) s = (const unsigned char*)memcpy(tail, p - 1, c->end - (p - 1));
+            if ((n = tiny_utf8_length(s)) == 0) return c->json = p - 1, TINY_PARSE_INVALID_UTF8;
+            p += n - 1;
         }
     }
-    PUTC(c, '"');
+    c->json = p;
+    return TINY_PARSE_OK;
 }
 
-/// @brief 优化后的 stringify 函数，提前开辟足够的空间确保不会反复查询空间是否足够
-/// @param c tiny_context
-/// @param s json 值中的字符串
-/// @param len 字符串长度
-static void tiny_stringify_string(tiny_context* c, const char* s, size_t len) {
-    static const char hex_digits[] = { '0', '1', '2', '3', '4', '5', '6', 
-        '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-    size_t i, size;
-    char *head, *p;
-    assert(s != nullptr);
-    // 开辟足够大的空间 "\u00xx..."
-    p = head = (char*)tiny_context_push(c, size = len * 6 + 2);
-    *p++ = '"';
-    for (i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) {
-            case '\"': *p++ = '\\'; *p++ = '\"'; break;
-            case '\\': *p++ = '\\'; *p++ = '\\'; break;
-            case '\b': *p++ = '\\'; *p++ = 'b';  break;
-            case '\f': *p++ = '\\'; *p++ = 'f';  break;
-            case '\n': *p++ = '\\'; *p++ = 'n';  break;
-            case '\r': *p++ = '\\'; *p++ = 'r';  break;
-            case '\t': *p++ = '\\'; *p++ = 't';  break;
-            default:
-                if (ch < 0x20) {
-                    *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
-                    *p++ = hex_digits[ch >> 4];  // 写入十位
-                    *p++ = hex_digits[ch & 15];  // 写入个位
-                }
-                else *p++ = s[i];
+/// @brief 跳过一个数字, 与 tiny_parse_number 一样检查是否过大, 但只在数量级可能溢出时才调用 strtod
+static int tiny_skip_number(tiny_context* c) {
+    const char* p = c->json;
+    const char* q = tiny_scan_number<true>(p, c->end);
+    int64_t digits = 0, exp = 0;
+    int neg = 0;
+    if (q == nullptr) return TINY_PARSE_INVALID_VALUE;
+    if (*p == '-') p++;
+    for (; p < q && ISDIGIT(*p); p++) digits++;
+    if (p < q && *p == '.') for (p++; p < q && ISDIGIT(*p); p++);
+    if (p < q && (*p == 'e' || *p == 'E')) {
+        neg = *++p == '-';
+        if (*p == '+' || *p == '-') p++;
+        for (; p < q && exp < 100000; p++) exp = exp * 10 + (*p - '0');
+    }
+    // 数值小于 10^(digits + exp), 不超过 10^308 时一定不会溢出
+    if (digits + (neg ? -exp : exp) > 308) {
+        // strtod 在数字之后的字符处停下; 数字恰好到 c->end 结束时先复制出来补上结束符
+        size_t len = q - c->json;
+        char buffer[64], *s = (char*)c->json;
+        double d;
+        if (q == c->end) {
+            s = len < sizeof(buffer) ? buffer : (char*)tiny_malloc(len + 1);
+            memcpy(s, c->json, len);
+            s[len] = '\0';
         }
+        errno = 0;
+        d = strtod(s, nullptr);
+        if (s != c->json && s != buffer) tiny_dealloc(s, len + 1);
+        if (errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL)) return TINY_PARSE_NUMBER_TOO_BIG;
     }
-    *p++ = '"';
-    c->top -= size - (p - head);  // 按实际输出量调整堆栈指针
+    c->json = q;
+    return TINY_PARSE_OK;
 }
 
-static void tiny_stringify_value(tiny_context* c, const tiny_node* node) {
-    switch (node->type) {
-        case TINY_NULL:     PUTS(c, "null",  4); break;
-        case TINY_FALSE:    PUTS(c, "false", 5); break;
-        case TINY_TRUE:     PUTS(c, "true",  4); break;
-        // 开辟 32 位的空间写入数字，但不一定能够写满 32 位，因此 top 指针要在操作完回调
-        case TINY_NUMBER:   c->top -= 32 - sprintf((char*)tiny_context_push(c, 32), "%.17g", node->n); break;
-        case TINY_STRING:   tiny_stringify_string(c, node->s.s, node->s.len); break;
-        case TINY_ARRAY:
-            PUTC(c, '[');
-            for (size_t i = 0; i < node->a.size; i++) {
-                if (i > 0) PUTC(c, ',');
-                tiny_stringify_value(c, &node->a.e[i]);
+static int tiny_skip_literal(tiny_context* c, const char* literal, size_t len) {
+    if ((size_t)(c->end - c->json) < len || memcmp(c->json, literal, len) != 0) return TINY_PARSE_INVALID_VALUE;
+    c->json += len;
+    return TINY_PARSE_OK;
+}
+
+/// @brief 跳过一个值而不构造节点, 返回的状态码与 tiny_parse_value 相同, 出错时 c->json 指向出错的位置
+static int tiny_skip_value(tiny_context* c) {
+    int ret;
+    switch (tiny_skip_peek(c)) {
+        case 'n' : return tiny_skip_literal(c, "null", 4);
+        case 't' : return tiny_skip_literal(c, "true", 4);
+        case 'f' : return tiny_skip_literal(c, "false", 5);
+        case '"' : return tiny_skip_string(c);
+        case '\0': return TINY_PARSE_EXPECT_VALUE;
+        default  : return tiny_skip_number(c);
+        case '[' :
+            c->json++;
+            tiny_skip_whitespace(c);
+            if (tiny_skip_peek(c) == ']') break;
+            for (;;) {
+                if ((ret = tiny_skip_value(c)) != TINY_PARSE_OK) return ret;
+                tiny_skip_whitespace(c);
+                if (tiny_skip_peek(c) == ']') break;
+                if (tiny_skip_peek(c) != ',') return TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                c->json++;
+                tiny_skip_whitespace(c);
             }
-            PUTC(c, ']');
             break;
-        case TINY_OBJECT:
-            PUTC(c, '{');
-            for (size_t i = 0; i < node->o.size; i++) {
-                if (i > 0) PUTC(c, ',');
-                PUTC(c, '\"');
-                PUTS(c, node->o.m[i].key, node->o.m[i].keylen);
-                PUTC(c, '\"');
-                PUTC(c, ':');
-                tiny_stringify_value(c, &node->o.m[i].value);
+        case '{' :
+            c->json++;
+            tiny_skip_whitespace(c);
+            if (tiny_skip_peek(c) == '}') break;
+            for (;;) {
+                if (tiny_skip_peek(c) != '"') return TINY_PARSE_MISS_KEY;
+                if ((ret = tiny_skip_string(c)) != TINY_PARSE_OK) return ret;
+                tiny_skip_whitespace(c);
+                if (tiny_skip_peek(c) != ':') return TINY_PARSE_MISS_COLON;
+                c->json++;
+                tiny_skip_whitespace(c);
+                if ((ret = tiny_skip_value(c)) != TINY_PARSE_OK) return ret;
+                tiny_skip_whitespace(c);
+                if (tiny_skip_peek(c) == '}') break;
+                if (tiny_skip_peek(c) != ',') return TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                c->json++;
+                tiny_skip_whitespace(c);
             }
-            PUTC(c, '}');
             break;
-        default: assert(0 && "invalid type");
     }
+    c->json++;  // 跳过 ']' 或 '}'
+    return TINY_PARSE_OK;
 }
 
-
-char* tiny_stringify(const tiny_node* node, size_t* length) {
+/// @brief 可信模式下跳过一个值, 不检查语法, 只找到值的结尾: 字符串按块找引号, 容器只数括号的层数, 标量到分隔符为止
+/// 与可信模式的解析一样不越过 c->end, 输入被截断时返回相应的错误
+static int tiny_skip_trusted(tiny_context* c) {
+    const char* p = c->json;
+    size_t depth = 0;
+    char open = 0;  // 最外层容器的左括号
+    do {
+        if (p == c->end) {
+            c->json = p;
+            return open == 0 ? TINY_PARSE_EXPECT_VALUE : open == '[' ? TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+        }
+        switch (*p) {
+            case '"':
+                for (p++; ; ) {
+                    p += tiny_escape_scan(p, c->end - p);
+                    if (p == c->end) return c->json = p, TINY_PARSE_MISS_QUOTATION_MARK;
+                    if (*p == '"') break;
+                    if (*p == '\\' && ++p == c->end) return c->json = p, TINY_PARSE_MISS_QUOTATION_MARK;
+                    p++;  // 跳过转义的字符, 控制字符原样跳过
+                }
+                p++;
+                break;
+            case '[': case '{':
+                if (depth++ == 0) open = *p;
+                p++;
+                break;
+            case ']': case '}':
+                if (depth == 0) return TINY_PARSE_INVALID_VALUE;
+                depth--;
+                p++;
+                break;
+            default:
+                if (depth > 0) p++;  // 容器中的标量、空白和分隔符逐个跳过
+                else {
+                    while (p < c->end && *p != ',' && *p != ']' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+                    if (p == c->json) return TINY_PARSE_INVALID_VALUE;  // 保证每次至少前进一个字符
+                }
+                break;
+        }
+    } while (depth > 0);
+    c->json = p;
+    return TINY_PARSE_OK;
+}
+
+/// @brief 按模板参数选择跳过值的方式, 与 tiny_parse_value<Trusted> 相对应
+template <bool Trusted>
+static inline int tiny_skip(tiny_context* c) {
+    return Trusted ? tiny_skip_trusted(c) : tiny_skip_value(c);
+}
+
+struct tiny_projection_node {
+    char* key; size_t klen;  // 从父节点到此节点的 token
+    size_t index;            // token 预解析的数组下标
+    size_t child, next;      // 第一个子节点、下一个兄弟节点的下标, 没有时为 TINY_KEY_NOT_EXIST
+    int whole;               // 有路径在此结束, 保留整个子树
+};
+
+// tiny_parse_projected_value 跳过了整个值时的返回值, 调用者不保留该值
+#define TINY_PARSE_NOT_PROJECTED (-2)
+
+template <bool Trusted>
+static int tiny_parse_projected_value(tiny_context* c, tiny_node* node, const tiny_projection* proj, size_t pn);
+
+template <bool Trusted>
+static int tiny_parse_projected_array(tiny_context* c, tiny_node* node, const tiny_projection* proj, size_t pn) {
+    size_t i, k, size = 0;
+    int ret;
+    EXPECT(c, '[');
+    tiny_parse_whitespace(c);
+    for (i = 0; ; i++) {
+        tiny_node e;
+        tiny_init(&e);
+        if (i == 0 && *c->json == ']') ret = TINY_PARSE_OK;
+        else {
+            for (k = proj->nodes[pn].child; k != TINY_KEY_NOT_EXIST && proj->nodes[k].index != i; k = proj->nodes[k].next);
+            ret = k == TINY_KEY_NOT_EXIST ? tiny_skip<Trusted>(c) : tiny_parse_projected_value<Trusted>(c, &e, proj, k);
+            if (ret == TINY_PARSE_OK && k != TINY_KEY_NOT_EXIST) {
+                memcpy(tiny_context_push(c, sizeof(tiny_node)), &e, sizeof(tiny_node));
+                size++;
+            }
+            if (ret == TINY_PARSE_NOT_PROJECTED) ret = TINY_PARSE_OK;
+            if (ret != TINY_PARSE_OK) break;
+            tiny_parse_whitespace(c);
+        }
+        if (*c->json == ',') {
+            c->json++;
+            tiny_parse_whitespace(c);
+        }
+        else if (*c->json == ']') {
+            c->json++;
+            tiny_set_array(node, size);
+            node->a.size = size;
+            if (size > 0) memcpy(node->a.e, tiny_context_pop(c, size * sizeof(tiny_node)), size * sizeof(tiny_node));
+            return TINY_PARSE_OK;
+        }
+        else {
+            ret = TINY_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    for (i = 0; i < size; i++) tiny_free((tiny_node*)tiny_context_pop(c, sizeof(tiny_node)));
+    return ret;
+}
+
+template <bool Trusted>
+static int tiny_parse_projected_object(tiny_context* c, tiny_node* node, const tiny_projection* proj, size_t pn) {
+    size_t i, k, len, size = 0;
+    tiny_member m;
+    char* str;
+    int ret;
+    EXPECT(c, '{');
+    tiny_parse_whitespace(c);
+    m.key = m.escaped = nullptr;
+    for (i = 0; ; i++) {
+        tiny_init(&m.value);
+        if (i == 0 && *c->json == '}') ret = TINY_PARSE_OK;
+        else {
+            if (*c->json != '"') {
+                ret = TINY_PARSE_MISS_KEY;
+                break;
+            }
+            if ((ret = tiny_parse_string_raw<Trusted>(c, &str, &len)) != TINY_PARSE_OK) break;
+            for (k = proj->nodes[pn].child; k != TINY_KEY_NOT_EXIST; k = proj->nodes[k].next) {
+                if (proj->nodes[k].klen == len && memcmp(proj->nodes[k].key, str, len) == 0) break;
+            }
+            if (k != TINY_KEY_NOT_EXIST) tiny_member_set_key(&m, str, len);
+            tiny_parse_whitespace(c);
+            if (*c->json != ':') {
+                ret = TINY_PARSE_MISS_COLON;
+                break;
+            }
+            c->json++;
+            tiny_parse_whitespace(c);
+            ret = k == TINY_KEY_NOT_EXIST ? tiny_skip<Trusted>(c) : tiny_parse_projected_value<Trusted>(c, &m.value, proj, k);
+            if (ret == TINY_PARSE_OK && k != TINY_KEY_NOT_EXIST) {
+                memcpy(tiny_context_push(c, sizeof(tiny_member)), &m, sizeof(tiny_member));
+                size++;
+                m.key = nullptr;  // key 的所有权转移给栈中的成员
+            }
+            if (ret == TINY_PARSE_NOT_PROJECTED) ret = TINY_PARSE_OK;
+            if (ret != TINY_PARSE_OK) break;
+            if (m.key) tiny_member_free_key(&m);
+            tiny_parse_whitespace(c);
+        }
+        if (*c->json == ',') {
+            c->json++;
+            tiny_parse_whitespace(c);
+        }
+        else if (*c->json == '}') {
+            c->json++;
+            tiny_set_object(node, size);
+            node->o.size = size;
+            if (size > 0) memcpy(node->o.m, tiny_context_pop(c, size * sizeof(tiny_member)), size * sizeof(tiny_member));
+            return TINY_PARSE_OK;
+        }
+        else {
+            ret = TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    if (m.key) tiny_member_free_key(&m);
+    for (i = 0; i < size; i++) {
+        tiny_member* pm = (tiny_member*)tiny_context_pop(c, sizeof(tiny_member));
+        tiny_member_free_key(pm);
+        tiny_free(&pm->value);
+    }
+    return ret;
+}
+
+/// @brief 按前缀树的第 pn 个节点解析值, 不在任何路径上的子树只检查语法而不构造节点
+/// @tparam Trusted 为 true 时保留的值按可信模式解析, 跳过的子树只找结尾而不检查语法
+/// @return 解析状态码; 路径要求容器而值是标量时跳过该值并返回 TINY_PARSE_NOT_PROJECTED
+template <bool Trusted>
+static int tiny_parse_projected_value(tiny_context* c, tiny_node* node, const tiny_projection* proj, size_t pn) {
+    int ret;
+    if (proj->nodes[pn].whole) return tiny_parse_value<Trusted>(c, node);
+    switch (*c->json) {
+        case '[': return tiny_parse_projected_array<Trusted>(c, node, proj, pn);
+        case '{': return tiny_parse_projected_object<Trusted>(c, node, proj, pn);
+        default : return (ret = tiny_skip<Trusted>(c)) == TINY_PARSE_OK ? TINY_PARSE_NOT_PROJECTED : ret;
+    }
+}
+
+static inline void tiny_cache_touch(const tiny_node* node);  // forward declare
+
+static const tiny_parse_options tiny_default_options = { nullptr, TINY_PACKED_NONE, 0 };
+
+/// @param proj 非空时只保留其中的路径
+/// @param end 非空时输入必须恰好在此结束, 否则在 '\0' 处结束
+/// @param reuse 非空时为旧的树, 解析时接管其中形状相同部分的缓冲区
+/// @tparam Trusted 为 true 时使用跳过语法检查的特化版本
+template <bool Trusted = false>
+static int tiny_parse_root(tiny_node* node, const char* json, const tiny_parse_options* options, 
+    const tiny_projection* proj = nullptr, const char* end = nullptr, tiny_node* reuse = nullptr) {
     tiny_context c;
+    int ret;
     assert(node != nullptr);
-    c.stack = (char*)malloc(c.size = TINY_PARSE_STRINGIFY_INIT_SIZE);
-    c.top = 0;
-    tiny_stringify_value(&c, node);
-    if (length) *length = c.top;  // 当传入非空指针时，就能获得生成 JSON 的长度
-    PUTC(&c, '\0');
-    return c.stack;
+    tiny_cache_touch(node);
+    
+    c.json = json;  // 存储数据
+    c.options = options;
+    // 可信模式和引用字符串时按 c.end 限制读取范围
+    c.end = (Trusted || (options->flags & TINY_PARSE_BORROW_STRINGS)) && end == nullptr ? json + strlen(json) : end;
+    c.stack = nullptr;
+    c.size = c.top = 0;  // 初始化栈结构
+    c.sink = nullptr;
+    c.gather = nullptr;
+    c.reuse = reuse;
+
+    tiny_init(node);  // 初始化节点
+    tiny_parse_whitespace(&c);  // 处理空格
+    ret = proj != nullptr ? tiny_parse_projected_value<Trusted>(&c, node, proj, 0) : tiny_parse_value<Trusted>(&c, node);
+    if (ret == TINY_PARSE_NOT_PROJECTED) ret = TINY_PARSE_OK;  // 根节点为标量但要求的是其中的字段, 结果为 null
+    if (ret == TINY_PARSE_OK){
+        tiny_parse_whitespace(&c);  // 处理字符串后空格
+        if (end != nullptr ? c.json != end : *c.json != '\0'){  // 处理完后指向的不是字符串的结束符，即后面还有其他字符
+            tiny_free(node);
+            ret = TINY_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    assert(c.top == 0);  // 正常处理后栈应该弹空
+    tiny_dealloc(c.stack, c.size);  // 释放栈空间
+    return ret;
+}
+
+int tiny_parse(tiny_node* node, const char* json){
+    return tiny_parse_root(node, json, &tiny_default_options);
+}
+
+/// @brief 带选项的解析
+/// @param node json 节点
+/// @param json 输入字符串
+/// @param options 解析选项, 可以为 nullptr
+/// @return 解析状态码
+int tiny_parse_ex(tiny_node* node, const char* json, const tiny_parse_options* options) {
+    const tiny_allocator* old;
+    int ret;
+    if (options == nullptr) options = &tiny_default_options;
+    auto parse = (options->flags & TINY_PARSE_TRUSTED) ? tiny_parse_root<true> : tiny_parse_root<false>;
+    if (options->allocator == nullptr) return parse(node, json, options, nullptr, nullptr, nullptr);
+    old = tiny_set_allocator(options->allocator);
+    ret = parse(node, json, options, nullptr, nullptr, nullptr);
+    tiny_set_allocator(old);
+    return ret;
+}
+
+/// @brief 只检查输入是否为合法的 JSON, 不构造节点也不分配内存: 数字只检查不转换, 字符串只扫描不复制
+/// @param json 输入, 不需要以 '\0' 结尾, 不会读取 json[len] 及之后的内容
+/// @param len 输入长度
+/// @param err_offset 非空时写入出错位置的字节偏移, 成功时写入 len
+/// @return 与 tiny_parse 相同的解析状态码
+int tiny_validate(const char* json, size_t len, size_t* err_offset) {
+    return tiny_validate_ex(json, len, err_offset, nullptr);
+}
+
+/// @brief 带选项的校验, 只使用选项中的 flags
+int tiny_validate_ex(const char* json, size_t len, size_t* err_offset, const tiny_parse_options* options) {
+    tiny_context c;
+    int ret;
+    assert(json != nullptr);
+    c.json = json;
+    c.options = options != nullptr ? options : &tiny_default_options;
+    c.end = json + len;
+    tiny_skip_whitespace(&c);
+    if ((ret = tiny_skip_value(&c)) == TINY_PARSE_OK) {
+        tiny_skip_whitespace(&c);
+        if (c.json != c.end) ret = TINY_PARSE_ROOT_NOT_SINGULAR;
+    }
+    if (err_offset != nullptr) *err_offset = ret == TINY_PARSE_OK ? len : (size_t)(c.json - json);
+    return ret;
+}
+
+/// @brief 只解析 proj 中的路径, 其余子树用不构造节点的扫描器跳过, 但仍检查其语法
+/// 数组只保留路径中指定下标的元素, 保留的元素按原顺序紧凑存放; 路径经过的标量被丢弃
+/// @param node json 节点
+/// @param json 输入, json[len] 必须为 '\0'
+/// @param len 输入长度
+/// @param proj 要保留的字段
+/// @return 解析状态码
+int tiny_parse_projected(tiny_node* node, const char* json, size_t len, const tiny_projection* proj) {
+    return tiny_parse_projected_ex(node, json, len, proj, nullptr);
+}
+
+/// @brief 带选项的投影解析; 设置 TINY_PARSE_TRUSTED 时保留的值按可信模式解析, 跳过的子树不检查语法
+/// @param options 解析选项, 可以为 nullptr
+int tiny_parse_projected_ex(tiny_node* node, const char* json, size_t len, const tiny_projection* proj, const tiny_parse_options* options) {
+    const tiny_allocator* old;
+    int ret;
+    assert(json != nullptr && json[len] == '\0' && proj != nullptr && proj->size > 0);
+    if (options == nullptr) options = &tiny_default_options;
+    auto parse = (options->flags & TINY_PARSE_TRUSTED) ? tiny_parse_root<true> : tiny_parse_root<false>;
+    if (options->allocator == nullptr) return parse(node, json, options, proj, json + len, nullptr);
+    old = tiny_set_allocator(options->allocator);
+    ret = parse(node, json, options, proj, json + len, nullptr);
+    tiny_set_allocator(old);
+    return ret;
+}
+
+/// @brief 解析到已有内容的节点中, 按位置复用旧树里足够大的缓冲区: 数组元素, 对象成员,
+/// 以及缓冲区足够大的 key 和字符串; 剩下没有被接管的部分在最后释放
+/// 同一形状的文档反复解析时几乎不再分配内存
+/// @param node 已解析过的 json 节点, 也可以是 TINY_NULL 等标量
+/// @param json 输入, json[len] 必须为 '\0'
+/// @param len 输入长度
+/// @return 解析状态码, 出错时 node 为 TINY_NULL
+int tiny_parse_reuse(tiny_node* node, const char* json, size_t len) {
+    tiny_node old;
+    int ret;
+    assert(node != nullptr && json != nullptr && json[len] == '\0');
+    memcpy(&old, node, sizeof(tiny_node));
+    ret = tiny_parse_root(node, json, &tiny_default_options, nullptr, json + len, &old);
+    tiny_free(&old);  // 释放没有被接管的部分
+    return ret;
+}
+
+/// @brief 把一组 JSON Pointer 合并为前缀树, 一条路径是另一条的前缀时保留较短的那条
+/// @param proj 编译结果, 用 tiny_projection_free 释放
+/// @param paths JSON Pointer 字符串数组
+/// @param n 路径个数
+/// @return TINY_PATCH_OK 或 TINY_PATCH_INVALID_POINTER
+int tiny_projection_compile(tiny_projection* proj, const char* const* paths, size_t n) {
+    tiny_pointer ptr;
+    size_t i, j, cur, k;
+    int ret;
+    assert(proj != nullptr && (paths != nullptr || n == 0));
+    proj->nodes = (tiny_projection_node*)tiny_malloc(sizeof(tiny_projection_node));
+    proj->size = proj->capacity = 1;
+    proj->nodes[0].key = nullptr;
+    proj->nodes[0].klen = 0;
+    proj->nodes[0].index = proj->nodes[0].child = proj->nodes[0].next = TINY_KEY_NOT_EXIST;
+    proj->nodes[0].whole = 0;
+    for (i = 0; i < n; i++) {
+        if ((ret = tiny_pointer_compile(&ptr, paths[i], strlen(paths[i]))) != TINY_PATCH_OK) {
+            tiny_projection_free(proj);
+            return ret;
+        }
+        for (cur = 0, j = 0; j < ptr.size && !proj->nodes[cur].whole; j++, cur = k) {
+            tiny_pointer_token* t = &ptr.t[j];
+            for (k = proj->nodes[cur].child; k != TINY_KEY_NOT_EXIST; k = proj->nodes[k].next) {
+                if (proj->nodes[k].klen == t->len && memcmp(proj->nodes[k].key, t->s, t->len) == 0) break;
+            }
+            if (k != TINY_KEY_NOT_EXIST) continue;
+            if (proj->size == proj->capacity) {
+                proj->nodes = (tiny_projection_node*)tiny_realloc(proj->nodes,
+                    proj->capacity * sizeof(tiny_projection_node), proj->capacity * 2 * sizeof(tiny_projection_node));
+                proj->capacity *= 2;
+            }
+            k = proj->size++;
+            proj->nodes[k].key = t->s;  // 接管 token 的字符串
+            proj->nodes[k].klen = t->len;
+            proj->nodes[k].index = t->index;
+            proj->nodes[k].child = TINY_KEY_NOT_EXIST;
+            proj->nodes[k].next = proj->nodes[cur].child;
+            proj->nodes[k].whole = 0;
+            proj->nodes[cur].child = k;
+            t->s = nullptr;
+        }
+        proj->nodes[cur].whole = 1;
+        tiny_pointer_free(&ptr);
+    }
+    return TINY_PATCH_OK;
+}
+
+void tiny_projection_free(tiny_projection* proj) {
+    assert(proj != nullptr);
+    for (size_t i = 0; i < proj->size; i++) tiny_dealloc(proj->nodes[i].key, proj->nodes[i].klen + 1);
+    tiny_dealloc(proj->nodes, proj->capacity * sizeof(tiny_projection_node));
+    proj->nodes = nullptr;
+    proj->size = proj->capacity = 0;
+}
+
+#define TINY_SWAR_ONES  0x0101010101010101ULL
+#define TINY_SWAR_HIGHS 0x8080808080808080ULL
+
+/// @brief 返回 s 中第一个需要转义的字节 (控制字符、'"' 或 '\\') 的下标, 不存在时返回 len
+/// 每次读入 8 个字节, 用 SWAR 一次性判断整个字中是否含有需要转义的字节
+static size_t tiny_escape_scan(const char* s, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x, q, b;
+        memcpy(&x, s + i, 8);
+        q = x ^ (TINY_SWAR_ONES * '"');
+        b = x ^ (TINY_SWAR_ONES * '\\');
+        // x 中有字节小于 0x20, 或 q、b 中有字节为 0 (即等于 '"' 或 '\\') 时, 对应字节的最高位被置位
+        if ((((x - TINY_SWAR_ONES * 0x20) & ~x) | ((q - TINY_SWAR_ONES) & ~q) | ((b - TINY_SWAR_ONES) & ~b)) & TINY_SWAR_HIGHS)
+            break;
+    }
+    for (; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch < 0x20 || ch == '"' || ch == '\\') break;
+    }
+    return i;
+}
+
+/// @brief 与 tiny_escape_scan 相同, 但同时在第一个非 ASCII 字节处停下, 供检查 UTF-8 时跳过纯 ASCII 的部分
+static size_t tiny_ascii_scan(const char* s, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x, q, b;
+        memcpy(&x, s + i, 8);
+        q = x ^ (TINY_SWAR_ONES * '"');
+        b = x ^ (TINY_SWAR_ONES * '\\');
+        if ((((x - TINY_SWAR_ONES * 0x20) & ~x) | ((q - TINY_SWAR_ONES) & ~q) | ((b - TINY_SWAR_ONES) & ~b) | x) & TINY_SWAR_HIGHS)
+            break;
+    }
+    for (; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch < 0x20 || ch == '"' || ch == '\\' || ch >= 0x80) break;
+    }
+    return i;
+}
+
+/// @brief 需要转义的字节对应的转义字符, 'u' 表示 \\u00XX 形式, 0 表示无需转义 (>= 0x60 的字节都无需转义)
+static const char tiny_escape_table[0x60] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+};
+
+/// @brief 扫描版本的 stringify 函数，整段复制无需转义的字节，只为实际输出开辟空间
+/// @param c tiny_context
+/// @param s json 值中的字符串
+/// @param len 字符串长度
+/// @tparam Exact 见 tiny_context_put
+template <bool Exact = false>
+static void tiny_stringify_string(tiny_context* c, const char* s, size_t len) {
+    static const char hex_digits[] = { '0', '1', '2', '3', '4', '5', '6', 
+        '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+    size_t i = 0, j, run, size;
+    unsigned char ch;
+    char* p;
+    assert(s != nullptr);
+    PUTC_E(c, '"');
+    while (i < len) {
+        run = tiny_escape_scan(s + i, len - i);
+        tiny_context_write<Exact>(c, s + i, run);
+        if ((i += run) == len) break;
+        // 连续需要转义的字节先算出准确长度, 再一次性写入, 每次至多 256 个以免超出流式输出的块大小
+        for (j = i, size = 0; j < len && j - i < 256 && (ch = (unsigned char)s[j]) < 0x60 && tiny_escape_table[ch]; j++)
+            size += tiny_escape_table[ch] == 'u' ? 6 : 2;
+        p = tiny_context_put<Exact>(c, size);
+        for (; i < j; i++) {
+            ch = (unsigned char)s[i];
+            *p++ = '\\';
+            *p++ = tiny_escape_table[ch];
+            if (tiny_escape_table[ch] == 'u') {
+                *p++ = '0'; *p++ = '0';
+                *p++ = hex_digits[ch >> 4];  // 写入十位
+                *p++ = hex_digits[ch & 15];  // 写入个位
+            }
+        }
+    }
+    PUTC_E(c, '"');
+}
+
+/*
+ * 最短往返浮点数格式化, 采用 Schubfach 算法 (R. Giulietti, "The Schubfach way to render doubles")
+ * 对任意有限 double 求出位数最少的十进制表示 f * 10^e, 位数相同时取最接近的一个,
+ * 因此 strtod() 一定能把输出还原为同一个 double; 全程整数运算, 与 locale 无关
+ */
+#define TINY_DTOA_P      53                      // double 的有效位数
+#define TINY_DTOA_Q_MIN  (-1074)                 // 最小二进制指数
+#define TINY_DTOA_C_MIN  ((uint64_t)1 << 52)     // 规格化数的最小有效值
+#define TINY_DTOA_K_MIN  (-324)                  // 十进制指数 k 的下界
+#define TINY_DTOA_MASK63 (((uint64_t)1 << 63) - 1)
+#define TINY_DTOA_MAX    25                      // 输出的最大长度, 如 "-2.2250738585072014e-308"
+
+/// @brief g(k) = floor(10^-k / 2^r) + 1, 其中 r 使得 2^125 <= 10^-k / 2^r < 2^126, k 从 TINY_DTOA_K_MIN 到 292
+/// 每项按高 63 位和低 63 位拆成两个整数存放
+static const uint64_t tiny_dtoa_g[][2] = {
+    { 0x4F0CEDC95A718DD4, 0x5B01E8B09AA0D1B5 }, { 0x7E7B160EF71C1621, 0x119CA780F767B5EE },
+    { 0x652F44D8C5B011B4, 0x0E16EC672C52F7F2 }, { 0x50F29D7A37C00E29, 0x581256B8F0425FF5 },
+    { 0x40C21794F96671BA, 0x79A84560C0351991 }, { 0x679CF287F570B5F7, 0x75DA089ACD21C281 },
+    { 0x52E3F5399126F7F9, 0x44AE6D48A41B0201 }, { 0x424FF76140EBF994, 0x36F1F106E9AF34CD },
+    { 0x6A198BCECE465C20, 0x57E981A4A918547B }, { 0x54E13CA571D1E34D, 0x2CBACE1D541376C9 },
+    { 0x43E763B78E4182A4, 0x23C8A4E44342C56E }, { 0x6CA56C58E39C043A, 0x060DD4A06B9E08B0 },
+    { 0x56EABD13E9499CFB, 0x1E7176E6BC7E6D59 }, { 0x458897432107B0C8, 0x7EC12BEBC9FEBDE1 },
+    { 0x6F40F20501A5E7A7, 0x7E01DFDFA9979635 }, { 0x5900C19D9AEB1FB9, 0x4B34B319547944F7 },
+    { 0x4733CE17AF227FC7, 0x55C3C27AA9FA9D93 }, { 0x71EC7CF2B1D0CC72, 0x560603F7765DC8EA },
+    { 0x5B2397288E40A38E, 0x7804CFF92B7E3A55 }, { 0x48E945BA0B66E93F, 0x13370CC755FE9511 },
+    { 0x74A86F90123E41FE, 0x51F1AE0BBCCA881B }, { 0x5D538C7341CB67FE, 0x74C1580963D539AF },
+    { 0x4AA93D29016F8665, 0x43CDE0078310FAF3 }, { 0x77752EA8024C0A3C, 0x0616333F381B2B1E },
+    { 0x5F90F22001D66E96, 0x3811C298F9AF55B1 }, { 0x4C73F4E667DEBEDE, 0x600E35472E25DE28 },
+    { 0x7A532170A6313164, 0x3349EED849D6303F }, { 0x61DC1AC084F42783, 0x42A18BE03B11C033 },
+    { 0x4E49AF006A5CEC69, 0x1BB46FE695A7CCF5 }, { 0x7D42B19A43C7E0A8, 0x2C53E63DBC3FAE55 },
+    { 0x64355AE1CFD31A20, 0x237651CAFCFFBEAA }, { 0x502AAF1B0CA8E1B3, 0x35F8416F30CC9888 },
+    { 0x402225AF3D53E7C2, 0x5E603458F3D6E06D }, { 0x669D0918621FD937, 0x4A3386F4B957CD7B },
+    { 0x52173A79E8197A92, 0x6E8F9F2A2DDFD796 }, { 0x41AC2EC7ECE12EDB, 0x720C7F54F17FDFAB },
+    { 0x69137E0CAE3517C6, 0x1CE0CBBB1BFFCC45 }, { 0x540F980A24F74638, 0x171A3C95AFFFD69E },
+    { 0x433FACD4EA5F6B60, 0x127B63AAF3331218 }, { 0x6B991487DD657899, 0x6A5F05DE51EB5026 },
+    { 0x5614106CB11DFA14, 0x5518D17EA7EF7352 }, { 0x44DCD9F08DB194DD, 0x2A7A41321FF2C2A8 },
+    { 0x6E2E2980E2B5BAFB, 0x5D906850331E043F }, { 0x5824EE00B55E2F2F, 0x647386A68F4B3699 },
+    { 0x4683F19A2AB1BF59, 0x36C2D21ED908F87B }, { 0x70D31C29DDE93228, 0x579E1CFE280E5A5D },
+    { 0x5A427CEE4B20F4ED, 0x2C7E7D98200B7B7E }, { 0x483530BEA280C3F1, 0x09FECAE019A2C932 },
+    { 0x73884DFDD0CE064E, 0x43314499C29E0EB6 }, { 0x5C6D0B3173D8050B, 0x4F5A9D47CEE4D891 },
+    { 0x49F0D5C129799DA2, 0x72AEE4397250AD41 }, { 0x764E22CEA8C295D1, 0x377E39F583B44868 },
+    { 0x5EA4E8A553CEDE41, 0x12CB61913629D387 }, { 0x4BB72084430BE500, 0x756F8140F8217605 },
+    { 0x792500D39E796E67, 0x6F18CECE59CF233C }, { 0x60EA670FB1FABEB9, 0x3F470BD847D8E8FD },
+    { 0x4D885272F4C89894, 0x329F3CAD064720CA }, { 0x7C0D50B7EE0DC0ED, 0x37652DE1A3A50143 },
+    { 0x633DDA2CBE716724, 0x2C50F1814FB73436 }, { 0x4F64AE8A31F45283, 0x3D0D8E010C92902B },
+    { 0x7F077DA9E986EA6B, 0x7B48E334E0EA8045 }, { 0x659F97BB2138BB89, 0x49071C2A4D88669D },
+    { 0x514C796280FA2FA1, 0x20D27CEEA46D1EE4 }, { 0x4109FAB533FB594D, 0x670ECA58838A7F1D },
+    { 0x680FF788532BC216, 0x0B4ADD5A6C10CB62 }, { 0x533FF939DC2301AB, 0x22A24AAEBCDA3C4E },
+    { 0x4299942E49B59AEF, 0x354EA22563E1C9D8 }, { 0x6A8F537D42BC2B18, 0x554A9D089FCFA95A },
+    { 0x553F75FDCEFCEF46, 0x776EE406E63FBAAE }, { 0x4432C4CB0BFD8C38, 0x5F8BE99F1E996225 },
+    { 0x6D1E07AB466279F4, 0x327975CB64289D08 }, { 0x574B3955D1E86190, 0x28612B091CED4A6D },
+    { 0x45D5C777DB204E0D, 0x06B4226DB0BDD524 }, { 0x6FBC72595E9A167B, 0x24536A491AC95506 },
+    { 0x59638EADE54811FC, 0x1D0F883A7BD44405 }, { 0x4782D88B1DD34196, 0x4A72D361FCA9D004 },
+    { 0x726AF411C952028A, 0x43EAEBCFFAA94CD3 }, { 0x5B88C3416DDB353B, 0x4FEF230CC88770A9 },
+    { 0x493A35CDF17C2A96, 0x0CBF4F3D6D3926EE }, { 0x7529EFAFE8C6AA89, 0x61321862485B717C },
+    { 0x5DBB262653D22207, 0x675B46B506AF8DFD }, { 0x4AFC1E850FDB4E6C, 0x52AF6BC405593E64 },
+    { 0x77F9CA6E7FC54A47, 0x377F12D33BC1FD6D }, { 0x5FFB085866376E9F, 0x45FF42429634CABD },
+    { 0x4CC8D379EB5F8BB2, 0x6B329B68782A3BCB }, { 0x7ADAEBF64565AC51, 0x2B842BDA59DD2C77 },
+    { 0x6248BCC5045156A7, 0x3C69BCAEAE4A89F9 }, { 0x4EA0970403744552, 0x6387CA25583BA194 },
+    { 0x7DCDBE6CD253A21E, 0x05A6103BC05F68ED }, { 0x64A498570EA94E7E, 0x37B80CFC99E5ED8A },
+    { 0x5083AD1272210B98, 0x2C933D96E184BE08 }, { 0x40695741F4E73C79, 0x7075CADF1AD09807 },
+    { 0x670EF2032171FA5C, 0x4D8944982AE759A4 }, { 0x52725B35B45B2EB0, 0x3E076A135585E150 },
+    { 0x41F515C49048F226, 0x64D2BB42AAD1810D }, { 0x698822D41A0E503E, 0x07B7920444826815 },
+    { 0x546CE8A9AE71D9CB, 0x1FC60E69D0685344 }, { 0x438A53BAF1F4AE3C, 0x196B3EBB0D20429D },
+    { 0x6C1085F7E9877D2D, 0x0F11FDF815006A94 }, { 0x56739E5FEE05FDBD, 0x58DB319344005543 },
+    { 0x45294B7FF19E6497, 0x60AF5ADC3666AA9C }, { 0x6EA878CCB5CA3A8C, 0x344BC4938A3DDDC7 },
+    { 0x5886C70A2B082ED6, 0x5D096A0FA1CB17D2 }, { 0x46D238D4EF39BF12, 0x173ABB3FB4A27975 },
+    { 0x71505AEE4B8F981D, 0x0B912B992103F588 }, { 0x5AA6AF25093FACE4, 0x0940EFADB4032AD3 },
+    { 0x488558EA6DCC8A50, 0x07672624900288A9 }, { 0x74088E43E2E0DD4C, 0x723EA36DB337410E },
+    { 0x5CD3A5031BE71770, 0x5B654F8AF5C5CDA5 }, { 0x4A42EA68E31F45F3, 0x62B772D5916B0AEB },
+    { 0x76D1770E38320986, 0x0458B7BC1BDE77DD }, { 0x5F0DF8D82CF4D46B, 0x1D13C630164B9318 },
+    { 0x4C0B2D79BD90A9EF, 0x30DC9E8CDEA2DC13 }, { 0x79AB7BF5FC1AA97F, 0x0160FDAE31049351 },
+    { 0x6155FCC4C9AEEDFF, 0x1AB3FE24F403A90E }, { 0x4DDE63D0A158BE65, 0x6229981D9002EDA5 },
+    { 0x7C97061A9BC130A2, 0x69DC2695B337E2A1 }, { 0x63AC04E2163426E8, 0x54B01EDE28F9821B },
+    { 0x4FBCD0B4DE901F20, 0x43C018B1BA6134E2 }, { 0x7F9481216419CB67, 0x1F99C11C5D68549D },
+    { 0x6610674DE9AE3C52, 0x4C7B00E37DED107E }, { 0x51A6B90B21583042, 0x09FC00B5FE574065 },
+    { 0x41522DA2811359CE, 0x3B3000919845CD1D }, { 0x68837C3734EBC2E3, 0x784CCDB5C06FAE95 },
+    { 0x539C635F5D8968B6, 0x2D0A3E2B00595877 }, { 0x42E382B2B13ABA2B, 0x3DA1CB5599E11393 },
+    { 0x6B059DEAB52AC378, 0x629C7888F634EC1E }, { 0x559E17EEF755692D, 0x3549FA072B5D89B1 },
+    { 0x447E798BF91120F1, 0x1107FB38EF7E07C1 }, { 0x6D9728DFF4E834B5, 0x01A65EC17F300C68 },
+    { 0x57AC20B32A535D5D, 0x4E1EB23465C009ED }, { 0x46234D5C21DC4AB1, 0x24E55B5D1E333B24 },
+    { 0x70387BC69C93AAB5, 0x216EF894FD1EC506 }, { 0x59C6C96BB076222A, 0x4DF2607730E56A6C },
+    { 0x47D23ABC8D2B4E88, 0x3E5B805F5A5121F0 }, { 0x72E9F79415121740, 0x63C59A322A1B697F },
+    { 0x5BEE5FA9AA74DF67, 0x03047B5B54E2BACC }, { 0x498B7FBAEEC3E5EC, 0x0269FC4910B5623D },
+    { 0x75ABFF917E063CAC, 0x6A432D41B45569FB }, { 0x5E2332DACB38308A, 0x21CF5767C37787FC },
+    { 0x4B4F5BE23C2CF3A1, 0x67D912B9692C6CCA }, { 0x787EF969F9E185CF, 0x595B5128A8471476 },
+    { 0x60659454C7E79E3F, 0x6115DA86ED05A9F8 }, { 0x4D1E1043D31FB1CC, 0x4DAB1538BD9E2193 },
+    { 0x7B634D3951CC4FAD, 0x62AB552795C9CF52 }, { 0x62B5D7610E3D0C8B, 0x0222AA86116E3F75 },
+    { 0x4EF7DF80D830D6D5, 0x4E822204DABE992A }, { 0x7E59659AF38157BC, 0x17369CD49130F510 },
+    { 0x65145148C2CDDFC9, 0x5F5EE3DD40F3F740 }, { 0x50DD0DD3CF0B196E, 0x1918B64A9A5CC5CD },
+    { 0x40B0D7DCA5A27ABE, 0x4746F83BAEB09E3E }, { 0x678159610903F797, 0x253E59F91780FD2F },
+    { 0x52CDE11A6D9CC612, 0x50FEAE60DF9A6426 }, { 0x423E4DAEBE1704DB, 0x5A65584D7FAEB685 },
+    { 0x69FD4917968B3AF9, 0x10A226E265E4573B }, { 0x54CAA0DFABA29594, 0x0D4E8581EB1D1295 },
+    { 0x43D54D7FBC821143, 0x243ED134BC174211 }, { 0x6C887BFF94034ED2, 0x06CAE85460253682 },
+    { 0x56D396661002A574, 0x6BD586A9E6842B9B }, { 0x457611EB40021DF7, 0x09779EEE52035616 },
+    { 0x6F234FDECCD02FF1, 0x5BF297E3B66BBCEF }, { 0x58E90CB23D73598E, 0x165BACB62B8963F3 },
+    { 0x4720D6F4FDF5E13E, 0x451623C4EFA11CC2 }, { 0x71CE24BB2FEFCECA, 0x3B569FA17F682E03 },
+    { 0x5B0B5095BFF30BD5, 0x15DEE61ACC535803 }, { 0x48D5DA11665C0977, 0x2B18B8157042ACCF },
+    { 0x74895CE8A3C6758B, 0x5E8DF355806AAE18 }, { 0x5D3AB0BA1C9EC46F, 0x653E5C4466BBBE7A },
+    { 0x4A955A2E7D4BD059, 0x3765169D1EFC9861 }, { 0x77555D172EDFB3C2, 0x256E8A94FE60F3CF },
+    { 0x5F777DAC257FC301, 0x6ABED543FEB3F63F }, { 0x4C5F97BCEACC9C01, 0x3BCBDDCFFEF65E99 },
+    { 0x7A328C6177ADC668, 0x5FAC961997F0975B }, { 0x61C209E792F16B86, 0x7FBD44E1465A12AF },
+    { 0x4E34D4B9425ABC6B, 0x7FCA9D810514DBBF }, { 0x7D21545B9D5DFA46, 0x32DDC8CE6E87C5FF },
+    { 0x641AA9E2E44B2E9E, 0x5BE4A0A525396B32 }, { 0x501554B5836F587E, 0x7CB6E6EA842DEF5C },
+    { 0x4011109135F2AD32, 0x30925255368B25E3 }, { 0x6681B41B89844850, 0x4DB6EA21F0DEA304 },
+    { 0x52015CE2D469D373, 0x57C5881B2718826A }, { 0x419AB0B576BB0F8F, 0x5FD139AF527A01EF },
+    { 0x68F781225791B27F, 0x4C81F5E550C3364A }, { 0x53F9341B79415B99, 0x239B2B1DDA35C508 },
+    { 0x432DC3492DCDE2E1, 0x02E288E4AE916A6D }, { 0x6B7C6BA849496B01, 0x516A74A1174F10AE },
+    { 0x55FD22ED076DEF34, 0x4121F6E745D8DA25 }, { 0x44CA82573924BF5D, 0x1A8192529E4714EB },
+    { 0x6E10D08B8EA1322E, 0x5D9C1D50FD3E87DD }, { 0x580D73A2D880F4F2, 0x17B01773FDCB9FE4 },
+    { 0x4671294F139A5D8E, 0x4626792997D61984 }, { 0x70B50EE4EC2A2F4A, 0x3D0A5B75BFBCF59F },
+    { 0x5A2A7250BCEE8C3B, 0x4A6EAF916630C47F }, { 0x4821F50D63F209C9, 0x21F2260DEB5A36CC },
+    { 0x736988156CB6760E, 0x69837016455D247A }, { 0x5C546CDDF091F80B, 0x6E02C011D1175062 },
+    { 0x49DD23E4C074C66F, 0x719BCCDB0DAC404E }, { 0x762E9FD467213D7F, 0x68F947C4E2AD33B0 },
+    { 0x5E8BB3105280FDFF, 0x6D94396A4EF0F627 }, { 0x4BA2F5A6A8673199, 0x3E102DEEA58D91B9 },
+    { 0x7904BC3DDA3EB5C2, 0x3019E3176F48E927 }, { 0x60D09697E1CBC49B, 0x4014B5AC590720EC },
+    { 0x4D73ABACB4A303AF, 0x4CDD5E237A6C1A57 }, { 0x7BEC45E12104D2B2, 0x47C8969F2A46908A },
+    { 0x63236B1A80D0A88E, 0x6CA0787F5505406F }, { 0x4F4F88E200A6ED3F, 0x0A19F9FF773766BF },
+    { 0x7EE5A7D0010B1531, 0x5CF65CCBF1F23DFE }, { 0x6584864000D5AA8E, 0x172B7D6FF4C1CB32 },
+    { 0x5136D1CCCD77BBA4, 0x78EF978CC3CE3C28 }, { 0x40F8A7D70AC62FB7, 0x13F2DFA3CFD83020 },
+    { 0x67F43FBE77A37F8B, 0x398499061959E699 }, { 0x5329CC985FB5FFA2, 0x6136E0D1ADE18548 },
+    { 0x4287D6E04C91994F, 0x00F8B3DAF181376D }, { 0x6A72F166E0E8F54B, 0x1B27862B1C01F247 },
+    { 0x5528C11F1A53F76F, 0x2F52D1BC1667F506 }, { 0x44209A7F48432C59, 0x0C424163451FF738 },
+    { 0x6D00F7320D3846F4, 0x7A039BD208332526 }, { 0x5733F8F4D76038C3, 0x7B361641A028EA85 },
+    { 0x45C32D90AC4CFA36, 0x2F5E78348020BB9E }, { 0x6F9EAF4DE07B29F0, 0x4BCA59ED99CDF8FC },
+    { 0x594BBF71806287F3, 0x563B7B247B0B2D96 }, { 0x476FCC5ACD1B9FF6, 0x11C92F50626F57AC },
+    { 0x724C7A2AE1C5CCBD, 0x02DB7EE703E55912 }, { 0x5B7061BBE7D17097, 0x1BE2CBEC031DE0DC },
+    { 0x4926B496530DF3AC, 0x164F09899C17E716 }, { 0x750ABA8A1E7CB913, 0x3D4B4275C68CA4F0 },
+    { 0x5DA22ED4E530940F, 0x4AA29B916BA3B726 }, { 0x4AE825771DC07672, 0x6EE87C74561C9285 },
+    { 0x77D9D58B62CD8A51, 0x3173FA53BCFA8408 }, { 0x5FE177A2B5713B74, 0x278FFB7630C869A0 },
+    { 0x4CB45FB55DF42F90, 0x1FA662C4F3D387B3 }, { 0x7ABA32BBC986B280, 0x32A3D13B1FB8D91F },
+    { 0x622E8EFCA1388ECD, 0x0EE9742F4C93E0E6 }, { 0x4E8BA596E760723D, 0x58BAC3590A0FE71E },
+    { 0x7DAC3C24A5671D2F, 0x412AD228101971C9 }, { 0x6489C9B6EAB8E426, 0x00EF0E8673478E3B },
+    { 0x506E3AF8BBC71CEB, 0x1A58D86B8F6C71C9 }, { 0x40582F2D6305B0BC, 0x1513E0560C56C16E },
+    { 0x66F37EAF04D5E793, 0x3B530089AD579BE2 }, { 0x525C6558D0AB1FA9, 0x15DC006E2446164F },
+    { 0x41E384470D55B2ED, 0x5E4999F1B69E783F }, { 0x696C06D81555EB15, 0x7D428FE92430C065 },
+    { 0x54566BE0111188DE, 0x31020CBA835A3384 }, { 0x4378564CDA746D7E, 0x5A680A2ECF7B5C69 },
+    { 0x6BF3BD47C3ED7BFD, 0x770CDD17B25EFA42 }, { 0x565C976C9CBDFCCB, 0x1270B0DFC1E59502 },
+    { 0x4516DF8A16FE63D5, 0x5B8D5A4C9B1E10CE }, { 0x6E8AFF4357FD6C89, 0x127BC3ADC4FCE7B0 },
+    { 0x586F329C466456D4, 0x0EC96957D0CA52F3 }, { 0x46BF5BB038504576, 0x3F07877973D50F29 },
+    { 0x71322C4D26E6D58A, 0x31A5A58F1FBB4B75 }, { 0x5A8E89D75252446E, 0x5AEAEAD8E62F6F91 },
+    { 0x487207DF750E9D25, 0x2F22557A51BF8C74 }, { 0x73E9A63254E42EA2, 0x1836EF2A1C65AD86 },
+    { 0x5CBAEB5B771CF21B, 0x2CF8BF54E3848AD2 }, { 0x4A2F22AF927D8E7C, 0x23FA32AA4F9D3BDB },
+    { 0x76B1D118EA627D93, 0x5329EAAA18FB92F8 }, { 0x5EF4A74721E86476, 0x0F54BBBB472FA8C6 },
+    { 0x4BF6EC38E7ED1D2B, 0x25DD62FC38F2ED6C }, { 0x798B138E3FE1C845, 0x22FBD1938E517BDF },
+    { 0x613C0FA4FFE7D36A, 0x4F2FDADC71DAC97F }, { 0x4DC9A61D998642BB, 0x58F3157D27E23ACC },
+    { 0x7C75D695C2706AC5, 0x74B82261D969F7AD }, { 0x63917877CEC0556B, 0x10934EB4ADEE5FBE },
+    { 0x4FA793930BCD1122, 0x4075D8908B251965 }, { 0x7F7285B812E1B504, 0x00BC8DB411D4F56E },
+    { 0x65F537C675815D9C, 0x66FD3E29A7DD9125 }, { 0x5190F96B91344AE3, 0x6BFDCB54864ADA84 },
+    { 0x4140C78940F6A24F, 0x6FFE3C439EA2486A }, { 0x6867A5A867F103B2, 0x7FFD2D38FDD073DC },
+    { 0x53861E2053273628, 0x6664242D97D9F64A }, { 0x42D1B1B375B8F820, 0x51E9B68ADFE191D5 },
+    { 0x6AE91C5255F4C034, 0x1CA924116635B621 }, { 0x558749DB77F70029, 0x63BA83411E915E81 },
+    { 0x446C3B15F9926687, 0x6962029A7EDAB201 }, { 0x6D79F82328EA3DA6, 0x0F03375D97C45001 },
+    { 0x5794C6828721CAEB, 0x259C2C4ADFD04001 }, { 0x46109ECED2816F22, 0x5149BD08B30D0001 },
+    { 0x701A97B150CF1837, 0x3542C80DEB480001 }, { 0x59AEDFC10D7279C5, 0x7768A00B22A00001 },
+    { 0x47BF19673DF52E37, 0x79208008E8800001 }, { 0x72CB5BD86321E38C, 0x5B67334174000001 },
+    { 0x5BD5E313828182D6, 0x7C528F6790000001 }, { 0x4977E8DC68679BDF, 0x16A872B940000001 },
+    { 0x758CA7C70D7292FE, 0x5773EAC200000001 }, { 0x5E0A1FD271287598, 0x45F6556800000001 },
+    { 0x4B3B4CA85A86C47A, 0x04C5112000000001 }, { 0x785EE10D5DA46D90, 0x07A1B50000000001 },
+    { 0x604BE73DE4838AD9, 0x52E7C40000000001 }, { 0x4D0985CB1D3608AE, 0x0F1FD00000000001 },
+    { 0x7B426FAB61F00DE3, 0x31CC800000000001 }, { 0x629B8C891B267182, 0x5B0A000000000001 },
+    { 0x4EE2D6D415B85ACE, 0x7C08000000000001 }, { 0x7E37BE2022C0914B, 0x1340000000000001 },
+    { 0x64F964E68233A76F, 0x2900000000000001 }, { 0x50C783EB9B5C85F2, 0x5400000000000001 },
+    { 0x409F9CBC7C4A04C2, 0x1000000000000001 }, { 0x6765C793FA10079D, 0x0000000000000001 },
+    { 0x52B7D2DCC80CD2E4, 0x0000000000000001 }, { 0x422CA8B0A00A4250, 0x0000000000000001 },
+    { 0x69E10DE76676D080, 0x0000000000000001 }, { 0x54B40B1F852BDA00, 0x0000000000000001 },
+    { 0x43C33C1937564800, 0x0000000000000001 }, { 0x6C6B935B8BBD4000, 0x0000000000000001 },
+    { 0x56BC75E2D6310000, 0x0000000000000001 }, { 0x4563918244F40000, 0x0000000000000001 },
+    { 0x6F05B59D3B200000, 0x0000000000000001 }, { 0x58D15E1762800000, 0x0000000000000001 },
+    { 0x470DE4DF82000000, 0x0000000000000001 }, { 0x71AFD498D0000000, 0x0000000000000001 },
+    { 0x5AF3107A40000000, 0x0000000000000001 }, { 0x48C2739500000000, 0x0000000000000001 },
+    { 0x746A528800000000, 0x0000000000000001 }, { 0x5D21DBA000000000, 0x0000000000000001 },
+    { 0x4A817C8000000000, 0x0000000000000001 }, { 0x7735940000000000, 0x0000000000000001 },
+    { 0x5F5E100000000000, 0x0000000000000001 }, { 0x4C4B400000000000, 0x0000000000000001 },
+    { 0x7A12000000000000, 0x0000000000000001 }, { 0x61A8000000000000, 0x0000000000000001 },
+    { 0x4E20000000000000, 0x0000000000000001 }, { 0x7D00000000000000, 0x0000000000000001 },
+    { 0x6400000000000000, 0x0000000000000001 }, { 0x5000000000000000, 0x0000000000000001 },
+    { 0x4000000000000000, 0x0000000000000001 }, { 0x6666666666666666, 0x3333333333333334 },
+    { 0x51EB851EB851EB85, 0x0F5C28F5C28F5C29 }, { 0x4189374BC6A7EF9D, 0x5916872B020C49BB },
+    { 0x68DB8BAC710CB295, 0x74F0D844D013A92B }, { 0x53E2D6238DA3C211, 0x43F3E0370CDC8755 },
+    { 0x431BDE82D7B634DA, 0x698FE69270B06C44 }, { 0x6B5FCA6AF2BD215E, 0x0F4CA41D811A46D4 },
+    { 0x55E63B88C230E77E, 0x3F70834ACDAE9F10 }, { 0x44B82FA09B5A52CB, 0x4C5A02A23E254C0D },
+    { 0x6DF37F675EF6EADF, 0x2D5CD10396A21347 }, { 0x57F5FF85E592557F, 0x3DE3DA69454E75D3 },
+    { 0x465E6604B7A84465, 0x7E4FE1EDD10B9175 }, { 0x709709A125DA0709, 0x4A19697C81AC1BEF },
+    { 0x5A126E1A84AE6C07, 0x54E1213067BCE326 }, { 0x480EBE7B9D58566C, 0x43E74DC052FD8285 },
+    { 0x734ACA5F6226F0AD, 0x530BAF9A1E626A6D }, { 0x5C3BD5191B525A24, 0x426FBFAE7EB521F1 },
+    { 0x49C97747490EAE83, 0x4EBFCC8B9890E7F4 }, { 0x760F253EDB4AB0D2, 0x4ACC7A78F41B0CBA },
+    { 0x5E72843249088D75, 0x223D2EC729AF3D62 }, { 0x4B8ED0283A6D3DF7, 0x34FDBF05BAF29781 },
+    { 0x78E480405D7B9658, 0x54C931A2C4B758CF }, { 0x60B6CD004AC94513, 0x5D6DC14F03C5E0A5 },
+    { 0x4D5F0A66A23A9DA9, 0x31249AA59C9E4D51 }, { 0x7BCB43D769F762A8, 0x4EA0F76F60FD4882 },
+    { 0x63090312BB2C4EED, 0x254D92BF80CAA068 }, { 0x4F3A68DBC8F03F24, 0x1DD7A89933D54D20 },
+    { 0x7EC3DAF941806506, 0x62F2A75B86221500 }, { 0x65697BFA9ACD1D9F, 0x025BB91604E810CD },
+    { 0x51212FFBAF0A7E18, 0x684960DE6A5340A4 }, { 0x40E7599625A1FE7A, 0x203AB3E521DC33B6 },
+    { 0x67D88F56A29CCA5D, 0x19F7863B696052BD }, { 0x5313A5DEE87D6EB0, 0x7B2C6B62BAB37564 },
+    { 0x42761E4BED31255A, 0x2F56BC4EFBC2C450 }, { 0x6A5696DFE1E83BC3, 0x655793B192D13A1A },
+    { 0x5512124CB4B9C969, 0x377942F475742E7B }, { 0x440E750A2A2E3ABA, 0x5F9435905DF68B96 },
+    { 0x6CE3EE76A9E3912A, 0x65B9EF4D63241289 }, { 0x571CBEC554B60DBB, 0x6AFB25D782834207 },
+    { 0x45B0989DDD5E7163, 0x08C8EB12CECF6806 }, { 0x6F80F42FC8971BD1, 0x5ADB11B7B14BD9A3 },
+    { 0x5933F68CA078E30E, 0x157C0E2C8DD647B5 }, { 0x475CC53D4D2D8271, 0x5DFCD823A4AB6C91 },
+    { 0x722E086215159D82, 0x632E269F6DDF141B }, { 0x5B5806B4DDAAE468, 0x4F581EE5F17F4349 },
+    { 0x49133890B1558386, 0x72ACE584C1329C3B }, { 0x74EB8DB44EEF38D7, 0x6AAE3C079B842D2A },
+    { 0x5D893E29D8BF60AC, 0x5558300616035755 }, { 0x4AD431BB13CC4D56, 0x7779C004DE6912AB },
+    { 0x77B9E92B52E07BBE, 0x258F99A163DB5111 }, { 0x5FC7EDBC424D2FCB, 0x37A614811CAF740D },
+    { 0x4C9FF163683DBFD5, 0x7951AA00E3BF900B }, { 0x7A998238A6C932EF, 0x754F7667D2CC19AB },
+    { 0x6214682D523A8F26, 0x2AA5F8530F09AE22 }, { 0x4E76B9BDDB620C1E, 0x55519375A5A1581B },
+    { 0x7D8AC2C95F034697, 0x3BB5B8BC3C3559C5 }, { 0x646F023AB2690545, 0x7C9160969691149E },
+    { 0x5058CE955B87376B, 0x16DAB3ABABA743B2 }, { 0x40470BAAAF9F5F88, 0x78AEF622EFB902F5 },
+    { 0x66D812AAB29898DB, 0x0DE4BD04B2C19E54 }, { 0x524675555BAD4715, 0x57EA30D08F014B76 },
+    { 0x41D1F7777C8A9F44, 0x4654F3DA0C01092C }, { 0x694FF258C7443207, 0x23BB1FC346680EAC },
+    { 0x543FF513D29CF4D2, 0x4FC8E635D1ECD88A }, { 0x43665DA9754A5D75, 0x263A51C4A7F0AD3B },
+    { 0x6BD6FC425543C8BB, 0x56C3B607731AAEC4 }, { 0x5645969B77696D62, 0x789C919F8F488BD0 },
+    { 0x4504787C5F878AB5, 0x46E3A7B2D906D640 }, { 0x6E6D8D93CC0C1122, 0x3E390C515B3E239A },
+    { 0x5857A4763CD6741B, 0x4B60D6A77C31B615 }, { 0x46AC8391CA4529AF, 0x55E7121F968E2B44 },
+    { 0x711405B6106EA919, 0x0971B698F0E3786D }, { 0x5A766AF80D255414, 0x078E2BAD8D82C6BD },
+    { 0x485EBBF9A41DDCDC, 0x6C71BC8AD79BD231 }, { 0x73CAC65C39C96161, 0x2D82C7448C2C8382 },
+    { 0x5CA23849C7D44DE7, 0x3E023903A356CF9B }, { 0x4A1B603B06437185, 0x7E682D9C82ABD949 },
+    { 0x76923391A39F1C09, 0x4A4048FA6AAC8EDB }, { 0x5EDB5C7482E5B007, 0x55003A61EEF07249 },
+    { 0x4BE2B05D35848CD2, 0x773361E7F259F507 }, { 0x796AB3C855A0E151, 0x3EB89CA6508FEE71 },
+    { 0x6122296D114D810D, 0x7EFA16EB73A6585B }, { 0x4DB4EDF0DAA4673E, 0x3261ABEF8FB846AF },
+    { 0x7C54AFE7C43A3ECA, 0x1D691318E5F3A44B }, { 0x6376F31FD02E98A1, 0x64540F471E5C836F },
+    { 0x4F925C1973587A1B, 0x0376729F4B7D35F3 }, { 0x7F50935BEBC0C35E, 0x38BD84321261EFEB },
+    { 0x65DA0F7CBC9A35E5, 0x13CAD0280EB4BFEF }, { 0x517B3F96FD482B1D, 0x5CA240200BC3CCBF },
+    { 0x412F66126439BC17, 0x63B50019A3030A33 }, { 0x684BD683D38F9359, 0x1F88002904D1A9EA },
+    { 0x536FDECFDC72DC47, 0x32D3335403DAEE55 }, { 0x42BFE57316C249D2, 0x5BDC291003158B77 },
+    { 0x6ACCA251BE03A951, 0x12F9DB4CD1BC1258 }, { 0x557081DAFE695440, 0x7594AF70A7C9A847 },
+    { 0x445A017BFEBAA9CD, 0x4476F2C0863AED06 }, { 0x6D5CCF2CCAC442E2, 0x3A57EACDA3917B3C },
+    { 0x577D728A3BD03581, 0x7B7988A482DAC8FD }, { 0x45FDF53B630CF79B, 0x15FAD3B6CF156D97 },
+    { 0x6FFCBB923814BF5E, 0x565E1F8AE4EF15BE }, { 0x5996FC74F9AA32B2, 0x11E4E608B725AAFF },
+    { 0x47ABFD2A6154F55B, 0x27EA51A0928488CC }, { 0x72ACC843CEEE555E, 0x7310829A84074146 },
+    { 0x5BBD6D030BF1DDE5, 0x42739BAED005CDD2 }, { 0x49645735A327E4B7, 0x4EC2E2F24004A4A8 },
+    { 0x756D5855D1D96DF2, 0x4AD16B1D333AA10C }, { 0x5DF11377DB1457F5, 0x2241227DC2954DA3 },
+    { 0x4B2742C648DD132A, 0x4E9A81FE35443E1C }, { 0x783ED13D4161B844, 0x175D9CC9EED39694 },
+    { 0x603240FDCDE7C69C, 0x7917B0A18BDC7876 }, { 0x4CF500CB0B1FD217, 0x1412F3B46FE39392 },
+    { 0x7B219ADE7832E9BE, 0x535185ED7FD285B6 }, { 0x628148B1F9C25498, 0x42A79E57997537C5 },
+    { 0x4ECDD3C1949B76E0, 0x3552E512E12A9304 }, { 0x7E161F9C20F8BE33, 0x6EEB081E3510EB39 },
+    { 0x64DE7FB01A609829, 0x3F226CE4F740BC2E }, { 0x50B1FFC0151A1354, 0x3281F0B72C33C9BE },
+    { 0x408E66334414DC43, 0x42018D5F568FD498 }, { 0x674A3D1ED354939F, 0x1CCF48988A7FBA8D },
+    { 0x52A1CA7F0F76DC7F, 0x30A5D3AD3B99620B }, { 0x421B0865A5F8B065, 0x73B7DC8A96144E6F },
+    { 0x69C4DA3C3CC11A3C, 0x52BFC7442353B0B1 }, { 0x549D7B6363CDAE96, 0x756639034F7626F4 },
+    { 0x43B12F82B63E2545, 0x4451C735D92B525D }, { 0x6C4EB26ABD303BA2, 0x3A1C71EFC1DEEA2E },
+    { 0x56A55B889759C94E, 0x61B05B2634B254F2 }, { 0x45511606DF7B0772, 0x1AF37C1E908EAA5B },
+    { 0x6EE8233E325E7250, 0x2B1F2CFDB41776F8 }, { 0x58B9B5CB5B7EC1D9, 0x6F4C23FE29AC5F2D },
+    { 0x46FAF7D5E2CBCE47, 0x72A34FFE87BD18F1 }, { 0x71918C896ADFB073, 0x04387FFDA5FB5B1B },
+    { 0x5ADAD6D4557FC05C, 0x0360666484C915AF }, { 0x48AF1243779966B0, 0x02B3851D3707448C },
+    { 0x744B506BF28F0AB3, 0x1DEC082EBE720746 }, { 0x5D090D2328726EF5, 0x64BCD358985B3905 },
+    { 0x4A6DA41C205B8BF7, 0x6A30A913AD15C738 }, { 0x7715D36033C5ACBF, 0x5D1AA81F7B560B8C },
+    { 0x5F44A919C3048A32, 0x7DAEECE5FC44D609 }, { 0x4C36EDAE359D3B5B, 0x7E258A51969D7808 },
+    { 0x79F17C49EF61F893, 0x16A276E8F0FBF33F }, { 0x618DFD07F2B4C6DC, 0x121B9253F3FCC299 },
+    { 0x4E0B30D328909F16, 0x41AFA84329970214 }, { 0x7CDEB4850DB431BD, 0x4F7F739EA8F19CED },
+    { 0x63E55D373E29C164, 0x3F99294BBA5AE3F1 }, { 0x4FEAB0F8FE87CDE9, 0x7FADBAA2FB7BE98D },
+    { 0x7FDDE7F4CA72E30F, 0x7F7C5DD1925FDC15 }, { 0x664B1FF7085BE8D9, 0x4C637E4141E649AB },
+    { 0x51D5B32C06AFED7A, 0x704F983434B83AEF }, { 0x4177C2899EF32462, 0x26A6135CF6F9C8BF },
+    { 0x68BF9DA8FE51D3D0, 0x3DD685618B294132 }, { 0x53CC7E20CB74A973, 0x4B12044E08EDCDC2 },
+    { 0x4309FE80A2C3BAC2, 0x6F419D0B3A57D7CE }, { 0x6B4330CDD1392AD1, 0x320294DEC3BFBFB0 },
+    { 0x55CF5A3E40FA88A7, 0x419BAA4BCFCC995A }, { 0x44A5E1CB672ED3B9, 0x1AE2EEA30CA3ADE1 },
+    { 0x6DD636123EB152C1, 0x77D17DD1ADD2AFCF }, { 0x57DE91A832277567, 0x797464A7BE42263F },
+    { 0x464BA7B9C1B92AB9, 0x4790508631CE84FF }, { 0x70790C5C6928445C, 0x0C1A1A704FB0D4CC },
+    { 0x59FA7049EDB9D049, 0x567B4859D95A43D6 }, { 0x47FB8D07F161736E, 0x11FC39E17AAE9CAB },
+    { 0x732C14D98235857D, 0x032D2968C44A9445 }, { 0x5C2343E134F79DFD, 0x4F575453D03BA9D1 },
+    { 0x49B5CFE75D92E4CA, 0x72AC4376402FBB0E }, { 0x75EFB30BC8EB07AB, 0x0446D256CD192B49 },
+    { 0x5E595C096D88D2EF, 0x1D0575123DADBC3A }, { 0x4B7AB0078AD3DBF2, 0x4A6AC40E97BE302F },
+    { 0x78C44CD8DE1FC650, 0x771139B0F2C9E6B1 }, { 0x609D0A4718196B73, 0x78DA948D8F07EBC1 },
+    { 0x4D4A6E9F467ABC5C, 0x60AEDD3E0C065634 }, { 0x7BAA4A9870C46094, 0x344AFB9679A3BD20 },
+    { 0x62EEA2138D69E6DD, 0x103BFC78614FCA80 }, { 0x4F254E760ABB1F17, 0x26966393810CA200 },
+    { 0x7EA21723445E9825, 0x2423D2859B476999 }, { 0x654E78E9037EE01D, 0x69B642047C392148 },
+    { 0x510B93ED9C658017, 0x6E2B680396941AA0 }, { 0x40D60FF149EACCDF, 0x71BC53361210154D },
+    { 0x67BCE64EDCAAE166, 0x1C6085235019BBAE }, { 0x52FD850BE3BBE784, 0x7D1A041C40149625 },
+    { 0x42646A6FE9631F9D, 0x4A7B367D0010781D }, { 0x6A3A43E642383295, 0x5D91F0C8001A59C8 },
+    { 0x54FB698501C68EDE, 0x17A7F3D3334847D4 }, { 0x43FC546A67D20BE4, 0x79532975C2A03976 },
+    { 0x6CC6ED770C83463B, 0x0EEB75893766C256 }, { 0x57058AC5A39C382F, 0x25892AD42C523512 },
+    { 0x459E089E1C7CF9BF, 0x37A0EF102374F742 }, { 0x6F6340FCFA618F98, 0x59017E8038BB2536 },
+    { 0x591C33FD951AD946, 0x7A67986693C8EA91 }, { 0x4749C33144157A9F, 0x151FAD1EDCA0BBA8 },
+    { 0x720F9EB539BBF765, 0x0832AE97C76792A5 }, { 0x5B3FB22A94965F84, 0x068EF21305EC7551 },
+    { 0x48FFC1BBAA11E603, 0x1ED8C1A8D189F774 }, { 0x74CC692C434FD66B, 0x4AF4690E1C0FF253 },
+    { 0x5D705423690CAB89, 0x225D20D816732843 }, { 0x4AC0434F873D5607, 0x35174D79AB8F5369 },
+    { 0x779A054C0B955672, 0x21BEE25C45B21F0E }, { 0x5FAE6AA33C77785B, 0x3498B5169E2818D8 },
+    { 0x4C8B888296C5F9E2, 0x5D46F7454B534713 }, { 0x7A78DA6A8AD65C9D, 0x7BA4BED545520B52 },
+    { 0x61FA48553BDEB07E, 0x2FB6FF110441A2A8 }, { 0x4E61D37763188D31, 0x72F8CC0D9D014EED },
+    { 0x7D6952589E8DAEB6, 0x1E5AE015C80217E1 }, { 0x645441E07ED7BEF8, 0x1848B344A001ACB4 },
+    { 0x504367E6CBDFCBF9, 0x603A2903B3348A2A }, { 0x4035ECB8A3196FFB, 0x002E873628F6D4EE },
+    { 0x66BCADF43828B32B, 0x19E40B89DB2487E3 }, { 0x52308B29C686F5BC, 0x14B66FA17C1D3983 },
+    { 0x41C06F549ED25E30, 0x1091F2E7967DC79C }, { 0x6933E554315096B3, 0x341CB7D8F0C93F5F },
+    { 0x542984435AA6DEF5, 0x767D5FE0C0A0FF80 }, { 0x435469CF7BB8B25E, 0x2B977FE70080CC66 },
+    { 0x6BBA42E592C11D63, 0x5F58CCA4CD9AE0A3 }, { 0x562E9BEADBCDB11C, 0x4C470A1D7148B3B6 },
+    { 0x44F216557CA48DB0, 0x3D05A1B1276D5C92 }, { 0x6E5023BBFAA0E2B3, 0x7B3C35E83F1560E9 },
+    { 0x58401C96621A4EF6, 0x2F635E5365AAB3ED }, { 0x4699B0784E7B725E, 0x591C4B75EAEEF658 },
+    { 0x70F5E726E3F8B6FD, 0x74FA125644B18A26 }, { 0x5A5E5285832D5F31, 0x43FB41DE9D5AD4EB },
+    { 0x484B75379C244C27, 0x4FFC34B2177BDD89 }, { 0x73ABEEBF603A1372, 0x4CC6BAB68BF96274 },
+    { 0x5C898BCC4CFB42C2, 0x0A38955ED6611B90 }, { 0x4A07A309D72F689B, 0x21C6DDE5784DAFA7 },
+    { 0x76729E762518A75E, 0x693E2FD58D49190B }, { 0x5EC2185E8413B918, 0x5431BFDE0AA0E0D5 },
+    { 0x4BCE79E536762DAD, 0x29C1664B3BB3E711 }, { 0x794A5CA1F0BD15E2, 0x0F9BD6DEC5ECA4E8 },
+    { 0x61084A1B26FDAB1B, 0x2616457F04BD50BA }, { 0x4DA03B48EBFE227C, 0x1E783798D09773C8 },
+    { 0x7C33920E46636A60, 0x30C058F480F252D9 }, { 0x635C74D8384F884D, 0x0D66AD9067284247 },
+    { 0x4F7D2A469372D370, 0x711EF14052869B6C }, { 0x7F2EAA0A85848581, 0x34FE4ECD50D75F14 },
+    { 0x65BEEE6ED136D134, 0x2A650BD773DF7F43 }, { 0x51658B8BDA9240F6, 0x551DA312C319329C },
+    { 0x411E093CAEDB672B, 0x5DB14F4235ADC217 }, { 0x68300EC77E2BD845, 0x7C4EE536BC49368A },
+    { 0x5359A56C64EFE037, 0x7D0BEA92303A9208 }, { 0x42AE1DF050BFE693, 0x173CBBA8269541A0 },
+    { 0x6AB02FE6E79970EB, 0x3EC792A6A422029A }, { 0x5559BFEBEC7AC0BC, 0x3239421EE9B4CEE1 },
+    { 0x4447CCBCBD2F0096, 0x5B6101B25490A581 }, { 0x6D3FADFAC84B3424, 0x2BCE691D541AA268 },
+    { 0x576624C8A03C29B6, 0x563EBA7DDCE21B87 }, { 0x45EB50A08030215E, 0x78322ECB171B4939 },
+    { 0x6FDEE76733803564, 0x59E9E47824F87527 }, { 0x597F1F85C2CCF783, 0x6187E9F9B72D2A86 },
+    { 0x4798E6049BD72C69, 0x346CBB2E2C242205 }, { 0x728E3CD42C8B7A42, 0x20ADF849E039D007 },
+    { 0x5BA4FD768A092E9B, 0x33BE603B19C7D99F }, { 0x4950CAC53B3A8BAF, 0x42FEB3627B0647B3 },
+    { 0x754E113B91F745E5, 0x5197856A5E7072B8 }, { 0x5DD80DC941929E51, 0x27AC6ABB7EC05BC6 },
+    { 0x4B133E3A9ADBB1DA, 0x52F05562CBCD1638 }, { 0x781EC9F75E2C4FC4, 0x1E4D556ADFAE89F3 },
+    { 0x6018A192B1BD0C9C, 0x7EA444557FBED4C3 }, { 0x4CE0814227CA707D, 0x4BB69D1132FF109C },
+    { 0x7B00CED03FAA4D95, 0x5F8A94E851981A93 }, { 0x62670BD9CC883E11, 0x32D543ED0E134875 },
+    { 0x4EB8D647D6D364DA, 0x5BDDCFF0D80F6D2B }, { 0x7DF48A0C8AEBD491, 0x12FC7FE7C018AEAB },
+    { 0x64C3A1A3A25643A7, 0x28C9FFEC99AD5889 }, { 0x509C814FB511CFB9, 0x0707FFF07AF113A1 },
+    { 0x407D343FC40E3FC7, 0x1F39998D2F2742E7 }, { 0x672EB9FFA016CC71, 0x7EC28F484B7204A4 },
+    { 0x528BC7FFB345705B, 0x189BA5D36F8E6A1D }, { 0x42096CCC8F6AC048, 0x7A161E42BFA521B1 },
+    { 0x69A8AE1418AACD41, 0x435696D132A1CF81 }, { 0x5486F1A9AD557101, 0x1C454574288172CE },
+    { 0x439F27BAF1112734, 0x169DD129BA0128A5 }, { 0x6C31D92B1B4EA520, 0x242FB50F9001DAA1 },
+    { 0x568E4755AF721DB3, 0x368C90D940017BB4 }, { 0x453E9F77BF8E7E29, 0x120A0D7A999AC95D },
+    { 0x6ECA98BF98E3FD0E, 0x50101590F5C47561 }, { 0x58A213CC7A4FFDA5, 0x26734473F7D05DE8 },
+    { 0x46E80FD6C83FFE1D, 0x6B8F69F65FD9E4B9 }, { 0x71734C8AD9FFFCFC, 0x45B24323CC8FD45C },
+    { 0x5AC2A3A247FFFD96, 0x6AF502830A0CA9E3 }, { 0x489BB61B6CCCCADF, 0x08C402026E7087E9 },
+    { 0x742C569247AE1164, 0x746CD003E3E73FDB }, { 0x5CF04541D2F1A783, 0x76BD73364FEC3315 },
+    { 0x4A59D101758E1F9C, 0x5EFDF5C50CBCF5AB }, { 0x76F61B3588E365C7, 0x4B2FEFA1ADFB22AB },
+    { 0x5F2B48F7A0B5EB06, 0x08F3261AF195B555 }, { 0x4C22A0C61A2B226B, 0x20C284E25ADE2AAB },
+    { 0x79D1013CF6AB6A45, 0x1AD0D49D5E304444 }, { 0x617400FD9222BB6A, 0x48A7107DE4F369D0 },
+    { 0x4DF6673141B562BB, 0x53B8D9FE50C2BB0D }, { 0x7CBD71E869223792, 0x52C15CCA1AD12B48 },
+    { 0x63CAC186BA81C60E, 0x75677D6E7BDA8906 }, { 0x4FD5679EFB9B04D8, 0x5DEC645863153A6C },
+    { 0x7FBBD8FE5F5E6E27, 0x497A3A2704EEC3DF },
+};
+
+/// @brief 64 x 64 位乘法的高 64 位
+static uint64_t tiny_umul_high(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#else
+    uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+// floor(e * log10(2)), floor(e * log10(3/4 * 2)), floor(e * log2(10)), 在算法用到的范围内精确
+static int tiny_flog10_pow2(int e) { return (int)((int64_t)e * 661971961083LL >> 41); }
+static int tiny_flog10_three_quarters_pow2(int e) { return (int)(((int64_t)e * 661971961083LL - 274743187321LL) >> 41); }
+static int tiny_flog2_pow10(int e) { return (int)((int64_t)e * 913124641741LL >> 38); }
+
+/// @brief 计算 g * cp / 2^127 的近似值, 按 round-to-odd 保留粘滞位
+static uint64_t tiny_dtoa_rop(uint64_t g1, uint64_t g0, uint64_t cp) {
+    uint64_t x1 = tiny_umul_high(g0, cp);
+    uint64_t y0 = g1 * cp;
+    uint64_t y1 = tiny_umul_high(g1, cp);
+    uint64_t z = (y0 >> 1) + x1;
+    uint64_t vbp = y1 + (z >> 63);
+    return vbp | (((z & TINY_DTOA_MASK63) + TINY_DTOA_MASK63) >> 63);
+}
+
+/// @brief 求 c * 2^q 的最短十进制表示 *f * 10^*e
+/// @param irregular c 是规格化数的最小有效值 (2 的整数次幂) 且指数不是最小值, 此时左侧间隔只有右侧的一半
+static void tiny_dtoa_decimal(int q, uint64_t c, int irregular, uint64_t* f, int* e) {
+    uint64_t out = c & 1, cb = c << 2, cbr = cb + 2, cbl;
+    uint64_t vb, vbl, vbr, s, t;
+    const uint64_t* g;
+    int k, h;
+    if (!irregular) {
+        cbl = cb - 2;
+        k = tiny_flog10_pow2(q);
+    }
+    else {
+        cbl = cb - 1;
+        k = tiny_flog10_three_quarters_pow2(q);
+    }
+    h = q + tiny_flog2_pow10(-k) + 2;
+    g = tiny_dtoa_g[k - TINY_DTOA_K_MIN];
+    vb  = tiny_dtoa_rop(g[0], g[1], cb << h);
+    vbl = tiny_dtoa_rop(g[0], g[1], cbl << h);
+    vbr = tiny_dtoa_rop(g[0], g[1], cbr << h);
+    s = vb >> 2;
+    if (s >= 10) {  // 先尝试少一位的候选, 区间宽度不足 10 个单位, 两者至多一个落在区间内
+        uint64_t sp10 = s / 10 * 10, tp10 = sp10 + 10;
+        int upin = vbl + out <= sp10 << 2, wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin) {
+            *f = upin ? sp10 : tp10;
+            *e = k;
+            return;
+        }
+    }
+    t = s + 1;
+    int uin = vbl + out <= s << 2, win = (t << 2) + out <= vbr;
+    *e = k;
+    if (uin != win) {
+        *f = uin ? s : t;
+        return;
+    }
+    // 两个候选都在舍入区间内时取更接近的, 距离相同取偶数
+    int64_t cmp = (int64_t)(vb - ((s + t) << 1));
+    *f = cmp < 0 || (cmp == 0 && (s & 1) == 0) ? s : t;
+}
+
+/// @brief 两位数字查找表, 一次输出两位
+static const char tiny_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/// @brief 去掉 *f 末尾的 0
+/// @return *f 的十进制位数
+static int tiny_dtoa_trim(uint64_t* f, int* e) {
+    static const uint64_t pow10[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 
+        10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL };
+    int n;
+    // 按 10^8、10^4、10^2、10 分段去掉末尾的 0
+    while (*f % 100000000 == 0) {
+        *f /= 100000000;
+        *e += 8;
+    }
+    if (*f % 10000 == 0) { *f /= 10000; *e += 4; }
+    if (*f % 100 == 0)   { *f /= 100;   *e += 2; }
+    if (*f % 10 == 0)    { *f /= 10;    *e += 1; }
+    for (n = 1; n < 17 && *f >= pow10[n]; n++) ;
+    return n;
+}
+
+/// @brief 求有限非零 double 的最短表示 *f * 10^*e, *f 不含末尾的 0
+/// @return *f 的十进制位数
+static int tiny_dtoa_shortest(uint64_t bits, uint64_t* f, int* e) {
+    int bq = (int)(bits >> (TINY_DTOA_P - 1)) & 0x7FF;
+    uint64_t t = bits & (TINY_DTOA_C_MIN - 1), c;
+    if (bq != 0) {
+        int mq = -TINY_DTOA_Q_MIN + 1 - bq;
+        c = TINY_DTOA_C_MIN | t;
+        if (0 < mq && mq < TINY_DTOA_P && (c >> mq) << mq == c) {  // 整数可以直接输出
+            *f = c >> mq;
+            *e = 0;
+        }
+        else tiny_dtoa_decimal(-mq, c, t == 0 && bq > 1, f, e);
+    }
+    else tiny_dtoa_decimal(TINY_DTOA_Q_MIN, t, 0, f, e);  // 非规格化数
+    return tiny_dtoa_trim(f, e);
+}
+
+/// @brief 求有限非零 float 的最短表示, 舍入区间按 float 的精度计算, 因此位数不超过 9
+static int tiny_ftoa_shortest(uint32_t bits, uint64_t* f, int* e) {
+    int bq = (int)(bits >> 23) & 0xFF;
+    uint32_t t = bits & 0x7FFFFF, c;
+    if (bq != 0) {
+        int mq = 150 - bq;
+        c = 0x800000 | t;
+        if (0 < mq && mq < 24 && (c >> mq) << mq == c) {
+            *f = c >> mq;
+            *e = 0;
+        }
+        else tiny_dtoa_decimal(-mq, c, t == 0 && bq > 1, f, e);
+    }
+    else tiny_dtoa_decimal(-149, t, 0, f, e);
+    return tiny_dtoa_trim(f, e);
+}
+
+/// @brief 把 n 位数字 digits * 10^e 按 "%.17g" 的布局 (指数在 [-4, 17) 内用定点表示) 写入 p
+/// TINY_DECIMAL 的有效数字没有位数限制, 也用这个布局输出
+/// @return 写入后的位置
+static char* tiny_dtoa_layout(char* p, const char* digits, int e, int n) {
+    int exp = e + n - 1;  // 首位数字的十进制指数
+    if (exp < -4 || exp >= 17) {
+        char buffer[10];
+        int i = 0;
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, n - 1);
+            p += n - 1;
+        }
+        *p++ = 'e';
+        *p++ = exp < 0 ? '-' : '+';
+        if (exp < 0) exp = -exp;
+        do buffer[i++] = (char)('0' + exp % 10); while (exp /= 10);
+        while (i > 0) *p++ = buffer[--i];
+    }
+    else if (exp < 0) {  // 0.000ddd
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', -exp - 1);
+        memcpy(p += -exp - 1, digits, n);
+        p += n;
+    }
+    else if (exp >= n - 1) {  // 整数, 补齐末尾的 0
+        memcpy(p, digits, n);
+        memset(p += n, '0', exp - n + 1);
+        p += exp - n + 1;
+    }
+    else {
+        memcpy(p, digits, exp + 1);
+        p += exp + 1;
+        *p++ = '.';
+        memcpy(p, digits + exp + 1, n - exp - 1);
+        p += n - exp - 1;
+    }
+    return p;
+}
+
+/// @brief 把 n 位的最短表示 f * 10^e 按 tiny_dtoa_layout 的布局写入 p
+/// @return 写入后的位置
+static char* tiny_dtoa_digits(char* p, uint64_t f, int e, int n) {
+    char digits[18];
+    int i;
+    // 每次取两位数字, 从后向前写入
+    for (i = n; f >= 100; f /= 100) {
+        i -= 2;
+        memcpy(digits + i, tiny_digit_pairs + f % 100 * 2, 2);
+    }
+    if (f >= 10) memcpy(digits, tiny_digit_pairs + f * 2, 2);
+    else digits[0] = (char)('0' + f);
+    return tiny_dtoa_layout(p, digits, e, n);
+}
+
+/// @brief 计算 tiny_dtoa_layout 的输出长度
+static size_t tiny_dtoa_digits_length(int e, int n) {
+    int exp = e + n - 1;
+    if (exp < -4 || exp >= 17) {  // d.ddde+XXX
+        size_t len = (size_t)n + (n > 1) + 3;
+        for (exp = exp < 0 ? -exp : exp; exp >= 10; exp /= 10) len++;
+        return len;
+    }
+    if (exp < 0) return 1 - exp + n;  // 0.000ddd
+    return exp >= n - 1 ? exp + 1 : n + 1;
+}
+
+/// @brief 以最短往返形式输出 double, 格式与 "%.17g" 一致 (指数在 [-4, 17) 内用定点表示)
+/// @param buffer 至少 TINY_DTOA_MAX 字节
+/// @return 写入的字节数
+static size_t tiny_dtoa(double d, char* buffer) {
+    uint64_t bits, f;
+    int e, n;
+    char* p = buffer;
+    memcpy(&bits, &d, sizeof(d));
+    if ((bits >> (TINY_DTOA_P - 1) & 0x7FF) == 0x7FF) {  // JSON 无法表示 inf 和 nan
+        memcpy(p, "null", 4);
+        return 4;
+    }
+    if (bits >> 63) *p++ = '-';
+    if ((bits << 1) == 0) {
+        *p++ = '0';
+        return p - buffer;
+    }
+    n = tiny_dtoa_shortest(bits, &f, &e);
+    return tiny_dtoa_digits(p, f, e, n) - buffer;
+}
+
+/// @brief 按 tiny_dtoa 的格式计算输出长度, 只求最短表示而不生成字符
+static size_t tiny_dtoa_length(double d) {
+    uint64_t bits, f;
+    int e, n;
+    size_t len;
+    memcpy(&bits, &d, sizeof(d));
+    if ((bits >> (TINY_DTOA_P - 1) & 0x7FF) == 0x7FF) return 4;
+    len = bits >> 63;  // 负号
+    if ((bits << 1) == 0) return len + 1;
+    n = tiny_dtoa_shortest(bits, &f, &e);
+    return len + tiny_dtoa_digits_length(e, n);
+}
+
+/// @brief 以 float 精度下的最短往返形式输出, 格式与 tiny_dtoa 相同
+static size_t tiny_ftoa(float x, char* buffer) {
+    uint32_t bits;
+    uint64_t f;
+    int e, n;
+    char* p = buffer;
+    memcpy(&bits, &x, sizeof(x));
+    if ((bits >> 23 & 0xFF) == 0xFF) {
+        memcpy(p, "null", 4);
+        return 4;
+    }
+    if (bits >> 31) *p++ = '-';
+    if ((bits << 1) == 0) {
+        *p++ = '0';
+        return p - buffer;
+    }
+    n = tiny_ftoa_shortest(bits, &f, &e);
+    return tiny_dtoa_digits(p, f, e, n) - buffer;
+}
+
+static size_t tiny_ftoa_length(float x) {
+    uint32_t bits;
+    uint64_t f;
+    int e, n;
+    size_t len;
+    memcpy(&bits, &x, sizeof(x));
+    if ((bits >> 23 & 0xFF) == 0xFF) return 4;
+    len = bits >> 31;
+    if ((bits << 1) == 0) return len + 1;
+    n = tiny_ftoa_shortest(bits, &f, &e);
+    return len + tiny_dtoa_digits_length(e, n);
+}
+
+/// @brief 输出 64 位整数
+/// @param buffer 至少 20 字节
+/// @return 写入的字节数
+static size_t tiny_i64toa(int64_t i, char* buffer) {
+    char temp[20], *p = temp + sizeof(temp);
+    uint64_t u = i < 0 ? 0ULL - (uint64_t)i : (uint64_t)i;
+    for (; u >= 100; u /= 100) memcpy(p -= 2, tiny_digit_pairs + u % 100 * 2, 2);
+    if (u >= 10) memcpy(p -= 2, tiny_digit_pairs + u * 2, 2);
+    else *--p = (char)('0' + u);
+    if (i < 0) *--p = '-';
+    memcpy(buffer, p, temp + sizeof(temp) - p);
+    return temp + sizeof(temp) - p;
+}
+
+static size_t tiny_i64toa_length(int64_t i) {
+    uint64_t u = i < 0 ? 0ULL - (uint64_t)i : (uint64_t)i;
+    size_t n = 1 + (i < 0);
+    for (; u >= 10; u /= 10) n++;
+    return n;
+}
+
+/// @brief 输出紧凑数字数组中下标在 [begin, end) 内的元素, 规则同 tiny_stringify_elements
+/// @tparam Exact 为 true 时直接格式化到输出缓冲区中, 否则先格式化到局部缓冲区
+template <bool Exact = false>
+static void tiny_stringify_packed(tiny_context* c, const tiny_node* node, size_t begin, size_t end) {
+    char buffer[TINY_DTOA_MAX + 1], *p;
+    size_t i, n;
+    buffer[0] = ',';
+    for (i = begin; i < end; i++) {
+        if (Exact) {
+            if (i > 0) c->stack[c->top++] = ',';
+            p = c->stack + c->top;
+        }
+        else p = buffer + 1;
+        switch (node->v.type) {
+            case TINY_PACKED_FLOAT: n = tiny_ftoa(((const float*)node->v.p)[i], p); break;
+            case TINY_PACKED_INT64: n = tiny_i64toa(((const int64_t*)node->v.p)[i], p); break;
+            default:                n = tiny_dtoa(((const double*)node->v.p)[i], p); break;
+        }
+        if (Exact) tiny_context_put<true>(c, n);
+        else if (i > 0) PUTS(c, buffer, n + 1);
+        else PUTS(c, p, n);
+    }
+}
+
+/// @brief 计算 tiny_stringify_packed 输出的长度
+/// @tparam Bound 为 true 时每个数字按 TINY_DTOA_MAX 计, 得到不需要格式化的上界
+template <bool Bound = false>
+static size_t tiny_stringify_packed_length(const tiny_node* node, size_t begin, size_t end) {
+    size_t i, n = begin < end ? end - begin - (begin == 0) : 0;  // 逗号
+    if (Bound) return n + (end - begin) * TINY_DTOA_MAX;
+    for (i = begin; i < end; i++) {
+        switch (node->v.type) {
+            case TINY_PACKED_FLOAT: n += tiny_ftoa_length(((const float*)node->v.p)[i]); break;
+            case TINY_PACKED_INT64: n += tiny_i64toa_length(((const int64_t*)node->v.p)[i]); break;
+            default:                n += tiny_dtoa_length(((const double*)node->v.p)[i]); break;
+        }
+    }
+    return n;
+}
+
+/// @brief TINY_DECIMAL 的输出长度
+static size_t tiny_stringify_decimal_length(const tiny_node* node) {
+    return node->x.neg + (node->x.len == 0 ? 1 : tiny_dtoa_digits_length(node->x.exp, (int)node->x.len));
+}
+
+/// @brief 按 tiny_dtoa_layout 的布局直接把有效数字写入栈中, 同一个值的输出唯一
+template <bool Exact = false>
+static void tiny_stringify_decimal(tiny_context* c, const tiny_node* node) {
+    char* p = tiny_context_put<Exact>(c, tiny_stringify_decimal_length(node));
+    if (node->x.neg) *p++ = '-';
+    if (node->x.len == 0) *p = '0';
+    else tiny_dtoa_layout(p, node->x.s, node->x.exp, (int)node->x.len);
+}
+
+template <bool Exact = false>
+static void tiny_stringify_elements(tiny_context* c, const tiny_node* node, size_t begin, size_t end);  // forward declare
+
+/// @tparam Exact 见 tiny_context_put; 为 true 时数字直接格式化到输出缓冲区中
+template <bool Exact = false>
+static void tiny_stringify_value(tiny_context* c, const tiny_node* node) {
+    char buffer[TINY_DTOA_MAX];
+    size_t n;
+    switch (node->type) {
+        case TINY_NULL:     PUTS_E(c, "null",  4); break;
+        case TINY_FALSE:    PUTS_E(c, "false", 5); break;
+        case TINY_TRUE:     PUTS_E(c, "true",  4); break;
+        // 先格式化到局部缓冲区再按实际长度写入, 使输出缓冲区可以按 tiny_stringify_length 精确分配
+        // 延迟转换的数字未被修改过, 直接输出原文
+        case TINY_NUMBER:
+            if (node->d.s != nullptr) PUTS_E(c, node->d.s, node->d.len);
+            else if (Exact) tiny_context_put<true>(c, tiny_dtoa(node->n, c->stack + c->top));
+            else {
+                n = tiny_dtoa(node->n, buffer);
+                PUTS(c, buffer, n);
+            }
+            break;
+        case TINY_DECIMAL:  tiny_stringify_decimal<Exact>(c, node); break;
+        case TINY_STRING:   tiny_stringify_string<Exact>(c, node->s.s, node->s.len); break;
+        case TINY_ARRAY:
+            PUTC_E(c, '[');
+            tiny_stringify_elements<Exact>(c, node, 0, node->a.size);
+            PUTC_E(c, ']');
+            break;
+        case TINY_OBJECT:
+            PUTC_E(c, '{');
+            tiny_stringify_elements<Exact>(c, node, 0, node->o.size);
+            PUTC_E(c, '}');
+            break;
+        case TINY_NUMBER_ARRAY:
+            PUTC_E(c, '[');
+            tiny_stringify_packed<Exact>(c, node, 0, node->v.size);
+            PUTC_E(c, ']');
+            break;
+        default: assert(0 && "invalid type");
+    }
+}
+
+/// @brief 输出对象成员的 key 和冒号
+template <bool Exact = false>
+static void tiny_stringify_key(tiny_context* c, const tiny_member* m) {
+    if (m->escaped != nullptr) {
+        tiny_context_write<Exact>(c, m->escaped, strlen(m->escaped));
+    }
+    else {
+        PUTC_E(c, '\"');
+        tiny_context_write<Exact>(c, m->key, m->keylen);
+        PUTC_E(c, '\"');
+    }
+    PUTC_E(c, ':');
+}
+
+/// @brief 输出容器中下标在 [begin, end) 内的元素 (对象为成员), 下标大于 0 的元素前带逗号
+/// 因此相邻的区间可以分别输出后直接拼接
+template <bool Exact>
+static void tiny_stringify_elements(tiny_context* c, const tiny_node* node, size_t begin, size_t end) {
+    if (node->type == TINY_NUMBER_ARRAY) {
+        tiny_stringify_packed<Exact>(c, node, begin, end);
+        return;
+    }
+    for (size_t i = begin; i < end; i++) {
+        if (i > 0) PUTC_E(c, ',');
+        if (node->type == TINY_ARRAY) {
+            tiny_stringify_value<Exact>(c, &node->a.e[i]);
+        }
+        else {
+            tiny_stringify_key<Exact>(c, &node->o.m[i]);
+            tiny_stringify_value<Exact>(c, &node->o.m[i].value);
+        }
+    }
+}
+
+
+/// @brief 计算字符串序列化后的长度 (含两侧引号)
+static size_t tiny_stringify_string_length(const char* s, size_t len) {
+    size_t i = 0, n = len + 2;
+    while ((i += tiny_escape_scan(s + i, len - i)) < len)
+        n += tiny_escape_table[(unsigned char)s[i++]] == 'u' ? 5 : 1;  // \u00XX 多 5 个字节, 其余转义多 1 个
+    return n;
+}
+
+/// @brief 复制 key 到成员中; key 含有需要转义的字节时, 同时缓存其序列化后的形式 (含引号)
+/// 绝大多数 key 无需转义, 序列化时直接复制; 需要转义的 key 只在这里转义一次
+static void tiny_member_set_key(tiny_member* m, const char* key, size_t klen) {
+    memcpy(m->key = (char*)tiny_malloc(klen + 1), key, klen);  // 注意 key 一定要先分配空间
+    m->key[klen] = '\0';  // 加上结束符
+    m->keylen = klen;  // keylen 也要赋值！
+    m->keycap = klen + 1;
+    tiny_member_escape_key(m);
+}
+
+/// @brief 按成员当前的 key 重新计算转义缓存, 无需转义时为空指针
+static void tiny_member_escape_key(tiny_member* m) {
+    tiny_context c;
+    m->escaped = nullptr;
+    if (tiny_escape_scan(m->key, m->keylen) == m->keylen) return;
+    c.stack = (char*)tiny_malloc(c.size = tiny_stringify_string_length(m->key, m->keylen) + 1);
+    c.top = 0;
+    c.sink = nullptr;
+    c.gather = nullptr;
+    tiny_stringify_string<true>(&c, m->key, m->keylen);
+    c.stack[c.top] = '\0';
+    m->escaped = c.stack;
+}
+
+/// @brief 释放成员的 key 及其转义缓存
+static void tiny_member_free_key(tiny_member* m) {
+    tiny_dealloc(m->key, m->keycap);
+    if (m->escaped != nullptr) tiny_dealloc(m->escaped, strlen(m->escaped) + 1);
+}
+
+template <bool Bound = false>
+static size_t tiny_stringify_elements_length(const tiny_node* node, size_t begin, size_t end);  // forward declare
+
+/// @brief 计算 json 节点序列化后的长度, 不生成输出
+/// @tparam Bound 为 false 时结果精确; 为 true 时 double 按 TINY_DTOA_MAX 计, 只求上界而不必格式化每个数字
+template <bool Bound>
+static size_t tiny_stringify_value_length(const tiny_node* node) {
+    switch (node->type) {
+        case TINY_NULL:     return 4;
+        case TINY_FALSE:    return 5;
+        case TINY_TRUE:     return 4;
+        case TINY_NUMBER:   return node->d.s != nullptr ? node->d.len : Bound ? TINY_DTOA_MAX : tiny_dtoa_length(node->n);
+        case TINY_DECIMAL:  return tiny_stringify_decimal_length(node);
+        case TINY_STRING:   return tiny_stringify_string_length(node->s.s, node->s.len);
+        case TINY_ARRAY:    return 2 + tiny_stringify_elements_length<Bound>(node, 0, node->a.size);  // 加上方括号
+        case TINY_OBJECT:   return 2 + tiny_stringify_elements_length<Bound>(node, 0, node->o.size);  // 加上花括号
+        case TINY_NUMBER_ARRAY: return 2 + tiny_stringify_packed_length<Bound>(node, 0, node->v.size);
+        default: assert(0 && "invalid type"); return 0;
+    }
+}
+
+/// @brief 精确计算 json 节点序列化后的长度, 不生成输出
+/// @param node json 节点
+/// @return 与 tiny_stringify 输出的长度相同, 不含结尾的 '\0'
+size_t tiny_stringify_length(const tiny_node* node) {
+    assert(node != nullptr);
+    return tiny_stringify_value_length<false>(node);
+}
+
+/// @brief 计算 tiny_stringify_elements 输出的长度
+template <bool Bound>
+static size_t tiny_stringify_elements_length(const tiny_node* node, size_t begin, size_t end) {
+    size_t n = begin < end ? end - begin - (begin == 0) : 0;  // 逗号
+    if (node->type == TINY_NUMBER_ARRAY) return tiny_stringify_packed_length<Bound>(node, begin, end);
+    for (size_t i = begin; i < end; i++) {
+        if (node->type == TINY_ARRAY) {
+            n += tiny_stringify_value_length<Bound>(&node->a.e[i]);
+        }
+        else {
+            const tiny_member* m = &node->o.m[i];
+            n += (m->escaped != nullptr ? strlen(m->escaped) : m->keylen + 2) + 1;  // 引号和冒号
+            n += tiny_stringify_value_length<Bound>(&m->value);
+        }
+    }
+    return n;
+}
+
+char* tiny_stringify(const tiny_node* node, size_t* length) {
+    tiny_context c;
+    size_t n;
+    assert(node != nullptr);
+    // 按上界一次分配, 每个 double 只在写入时格式化一次, 写入不检查容量;
+    // 含 double 时上界比实际长度大, 最后缩到恰好 length + 1 个字节
+    c.stack = (char*)tiny_malloc(c.size = tiny_stringify_value_length<true>(node) + 1);
+    c.top = 0;
+    c.sink = nullptr;
+    c.gather = nullptr;
+    tiny_stringify_value<true>(&c, node);
+    n = c.top;
+    c.stack[n] = '\0';
+    if (n + 1 < c.size) c.stack = (char*)tiny_realloc(c.stack, c.size, n + 1);
+    if (length) *length = n;  // 当传入非空指针时，就能获得生成 JSON 的长度
+    return c.stack;
+}
+
+/// @brief 流式生成 JSON, 每填满一个 TINY_STRINGIFY_CHUNK_SIZE 大小的块就交给 sink
+/// @param node json 节点
+/// @param sink 接收输出的回调
+/// @return 0 表示成功, 否则为 sink 返回的第一个非 0 值 (之后的输出被丢弃)
+int tiny_stringify_to(const tiny_node* node, const tiny_sink* sink) {
+    tiny_context c;
+    assert(node != nullptr && sink != nullptr && sink->write != nullptr);
+    c.stack = (char*)tiny_malloc(c.size = TINY_STRINGIFY_CHUNK_SIZE);
+    c.top = 0;
+    c.sink = sink;
+    c.gather = nullptr;
+    c.status = 0;
+    tiny_stringify_value(&c, node);
+    tiny_context_flush(&c);
+    tiny_dealloc(c.stack, c.size);
+    return c.status;
+}
+
+#ifndef _WIN32
+/// @brief 生成 JSON 并用 writev 分散写出到文件描述符
+/// 不短于 TINY_GATHER_MIN_LENGTH 的无需转义的字符串片段和 key 直接引用 DOM 中的内存,
+/// 只有标点、数字、转义片段和短字符串放在 TINY_STRINGIFY_CHUNK_SIZE 大小的缓冲块中
+/// @param node json 节点
+/// @param fd 文件描述符
+/// @return 0 表示成功, 否则为 writev 失败时的 errno
+int tiny_stringify_fd(const tiny_node* node, int fd) {
+    tiny_context c;
+    tiny_gather g;
+    assert(node != nullptr);
+    g.fd = fd;
+    g.count = 0;
+    g.mark = 0;
+    c.stack = (char*)tiny_malloc(c.size = TINY_STRINGIFY_CHUNK_SIZE);
+    c.top = 0;
+    c.sink = nullptr;
+    c.gather = &g;
+    c.status = 0;
+    tiny_stringify_value(&c, node);
+    tiny_context_flush(&c);
+    tiny_dealloc(c.stack, c.size);
+    return c.status;
+}
+#endif
+
+/// @brief 生成 JSON 到调用方持有的缓冲区, 覆盖原有内容, 容量不够时扩容并在之后的调用中复用
+/// @param node json 节点
+/// @param buffer 输出缓冲区, 结果以 '\0' 结尾, 长度为 buffer->size
+void tiny_stringify_into(const tiny_node* node, tiny_buffer* buffer) {
+    tiny_context c;
+    size_t n;
+    assert(node != nullptr && buffer != nullptr);
+    n = tiny_stringify_value_length<true>(node) + 1;  // 上界, 见 tiny_stringify
+    if (buffer->capacity < n) {  // 容量不够时一次扩到所需大小
+        buffer->data = (char*)tiny_realloc(buffer->data, buffer->capacity, n);
+        buffer->capacity = n;
+    }
+    c.stack = buffer->data;
+    c.size = buffer->capacity;
+    c.top = 0;
+    c.sink = nullptr;
+    c.gather = nullptr;
+    tiny_stringify_value<true>(&c, node);
+    buffer->size = c.top;
+    c.stack[c.top] = '\0';
+}
+
+/// @brief 释放 tiny_buffer 的内存
+void tiny_buffer_free(tiny_buffer* buffer) {
+    assert(buffer != nullptr);
+    tiny_dealloc(buffer->data, buffer->capacity);
+    buffer->data = nullptr;
+    buffer->size = buffer->capacity = 0;
+}
+
+/// @brief 并行 stringify 中的一段输出
+typedef struct {
+    const char* text;        // 不为 nullptr 时是一段固定文本 (括号、逗号)
+    const tiny_member* key;  // 不为 nullptr 时是对象成员的 key 和冒号
+    const tiny_node* node;   // 否则是容器 node 中下标在 [begin, end) 内的元素
+    size_t begin, end;
+    size_t length, offset;   // 这一段的输出长度和在结果中的位置
+} tiny_piece;
+
+/// @brief 数出子树的节点个数, 达到 limit 即停止
+static size_t tiny_count_nodes(const tiny_node* node, size_t limit) {
+    size_t n = 1, i;
+    if (node->type == TINY_NUMBER_ARRAY) return n + node->v.size;  // 每个数字按一个节点计
+    if (node->type == TINY_ARRAY)
+        for (i = 0; i < node->a.size && n < limit; i++) n += tiny_count_nodes(&node->a.e[i], limit - n);
+    else if (node->type == TINY_OBJECT)
+        for (i = 0; i < node->o.size && n < limit; i++) n += tiny_count_nodes(&node->o.m[i].value, limit - n);
+    return n;
+}
+
+static void tiny_piece_text(tiny_context* pieces, const char* text) {
+    tiny_piece* p = (tiny_piece*)tiny_context_push(pieces, sizeof(tiny_piece));
+    p->text = text;
+    p->key = nullptr;
+    p->node = nullptr;
+    p->length = strlen(text);
+}
+
+static void tiny_piece_range(tiny_context* pieces, const tiny_node* node, size_t begin, size_t end) {
+    tiny_piece* p = (tiny_piece*)tiny_context_push(pieces, sizeof(tiny_piece));
+    p->text = nullptr;
+    p->key = nullptr;
+    p->node = node;
+    p->begin = begin;
+    p->end = end;
+}
+
+/// @brief 按输出顺序把容器切成小段: 相邻的小元素每 step 个合为一段, 使一个容器最多约 grains 段;
+/// 节点数达到 TINY_PARALLEL_MIN_NODES 的子容器单独向下切分, 少数很大的元素不会落在同一段里
+/// 各段的精确长度在第一趟中算出, 写出任务再按长度的前缀和合并相邻的段, 见 tiny_stringify_parallel
+static void tiny_parallel_plan(tiny_context* pieces, const tiny_node* node, size_t grains) {
+    size_t n = node->type == TINY_ARRAY ? node->a.size : node->type == TINY_OBJECT ? node->o.size : node->v.size, i;
+    size_t step = n / grains + 1, start = 0;
+    tiny_piece_text(pieces, node->type == TINY_OBJECT ? "{" : "[");
+    if (node->type == TINY_NUMBER_ARRAY) {
+        for (i = 0; i < n; i += step) tiny_piece_range(pieces, node, i, std::min(i + step, n));
+        n = 0;
+    }
+    for (i = 0; i < n; i++) {
+        const tiny_node* child = node->type == TINY_ARRAY ? &node->a.e[i] : &node->o.m[i].value;
+        if ((child->type != TINY_ARRAY && child->type != TINY_OBJECT && child->type != TINY_NUMBER_ARRAY) || 
+            tiny_count_nodes(child, TINY_PARALLEL_MIN_NODES) < TINY_PARALLEL_MIN_NODES) {
+            if (i + 1 - start == step) {
+                tiny_piece_range(pieces, node, start, i + 1);
+                start = i + 1;
+            }
+            continue;
+        }
+        if (start < i) tiny_piece_range(pieces, node, start, i);
+        start = i + 1;
+        if (i > 0) tiny_piece_text(pieces, ",");
+        if (node->type == TINY_OBJECT) {
+            tiny_piece* p = (tiny_piece*)tiny_context_push(pieces, sizeof(tiny_piece));
+            p->text = nullptr;
+            p->key = &node->o.m[i];
+            p->node = nullptr;
+            p->length = (p->key->escaped != nullptr ? strlen(p->key->escaped) : p->key->keylen + 2) + 1;
+        }
+        tiny_parallel_plan(pieces, child, grains);
+    }
+    if (start < n) tiny_piece_range(pieces, node, start, n);
+    tiny_piece_text(pieces, node->type == TINY_OBJECT ? "}" : "]");
+}
+
+/// @brief 用 threads 个线程 (含当前线程) 处理下标为 [0, n) 的任务, 按原子计数器动态分配
+template <typename F>
+static void tiny_parallel_for(size_t n, unsigned threads, F f) {
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i; (i = next.fetch_add(1, memory_order_relaxed)) < n; ) f(i);
+    };
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) workers.emplace_back(work);
+    work();
+    for (auto& w : workers) w.join();
+}
+
+/// @brief 多线程生成 JSON, 输出与 tiny_stringify 完全相同
+/// 大容器按元素切分成许多小段, 各线程先并行算出每段的精确长度, 得到每段在结果中的位置后,
+/// 按位置把相邻的段合并成字节数相近的任务, 再并行把各任务直接写入同一个缓冲区,
+/// 不需要额外的拼接和复制; 小文档走串行路径
+/// @param node json 节点
+/// @param length 不为 nullptr 时返回输出长度
+/// @param threads 线程数, 为 0 时使用硬件线程数
+/// @return 由当前线程的分配器分配的恰好 *length + 1 个字节
+char* tiny_stringify_parallel(const tiny_node* node, size_t* length, unsigned threads) {
+    tiny_context pieces;
+    tiny_piece* p;
+    size_t n, i, offset, target;
+    vector<size_t> tasks;  // 每个写出任务的第一段, 最后一项为 n
+    char* json;
+    assert(node != nullptr);
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads <= 1 || (node->type != TINY_ARRAY && node->type != TINY_OBJECT) || 
+        tiny_count_nodes(node, TINY_PARALLEL_MIN_NODES) < TINY_PARALLEL_MIN_NODES)
+        return tiny_stringify(node, length);
+
+    pieces.stack = nullptr;
+    pieces.size = pieces.top = 0;
+    pieces.sink = nullptr;
+    pieces.gather = nullptr;
+    tiny_parallel_plan(&pieces, node, (size_t)threads * TINY_PARALLEL_TASKS * TINY_PARALLEL_GRAIN);
+    p = (tiny_piece*)pieces.stack;
+    n = pieces.top / sizeof(tiny_piece);
+
+    // 第一趟: 并行计算各段长度, 再按顺序累加得到各段的位置
+    tiny_parallel_for(n, threads, [&](size_t k) {
+        if (p[k].node != nullptr) p[k].length = tiny_stringify_elements_length(p[k].node, p[k].begin, p[k].end);
+    });
+    for (i = offset = 0; i < n; i++) {
+        p[i].offset = offset;
+        offset += p[i].length;
+    }
+
+    // 按前缀和在每 target 个字节处切开, 合并成约 threads * TINY_PARALLEL_TASKS 个字节数相近的任务
+    target = offset / ((size_t)threads * TINY_PARALLEL_TASKS) + 1;
+    for (i = 0; i < n; i++)
+        if (tasks.empty() || p[i].offset >= tasks.size() * target) tasks.push_back(i);
+    tasks.push_back(n);
+
+    // 第二趟: 各任务依次把其中的段写入结果中的对应位置, 长度精确, 写入时不会扩容
+    json = (char*)tiny_malloc(offset + 1);
+    tiny_parallel_for(tasks.size() - 1, threads, [&](size_t t) {
+        tiny_context c;
+        size_t begin = tasks[t], end = tasks[t + 1];
+        c.stack = json + p[begin].offset;
+        c.size = (end < n ? p[end].offset : offset) - p[begin].offset;
+        c.top = 0;
+        c.sink = nullptr;
+        c.gather = nullptr;
+        for (size_t k = begin; k < end; k++) {
+            if (p[k].text != nullptr) memcpy(tiny_context_put<true>(&c, p[k].length), p[k].text, p[k].length);
+            else if (p[k].key != nullptr) tiny_stringify_key<true>(&c, p[k].key);
+            else tiny_stringify_elements<true>(&c, p[k].node, p[k].begin, p[k].end);
+        }
+        assert(c.top == c.size && c.stack == json + p[begin].offset);
+    });
+    json[offset] = '\0';
+    if (length) *length = offset;
+    tiny_dealloc(pieces.stack, pieces.size);
+    return json;
+}
+
+// tiny_writer 每一层容器的状态位
+#define TINY_WRITER_OBJECT 1  // 当前层是对象
+#define TINY_WRITER_COMMA  2  // 当前层已有元素, 下一个元素前要写逗号
+#define TINY_WRITER_KEY    4  // 对象中刚写完 key, 下一个应为值
+
+/// @brief 生成器写到 tiny_buffer 中, 覆盖原有内容并复用其容量, tiny_writer_finish 后结果以 '\0' 结尾
+void tiny_writer_init(tiny_writer* w, tiny_buffer* buffer) {
+    assert(w != nullptr && buffer != nullptr);
+    w->c.stack = buffer->data;
+    w->c.size = buffer->capacity;
+    w->c.top = 0;
+    w->c.sink = nullptr;
+    w->c.gather = nullptr;
+    w->c.status = 0;
+    w->buffer = buffer;
+    w->scopes = nullptr;
+    w->depth = w->capacity = 0;
+    w->roots = 0;
+}
+
+/// @brief 生成器写到 sink, 每填满一个 TINY_STRINGIFY_CHUNK_SIZE 大小的块就交给 sink
+void tiny_writer_init_sink(tiny_writer* w, const tiny_sink* sink) {
+    assert(w != nullptr && sink != nullptr && sink->write != nullptr);
+    w->c.stack = (char*)tiny_malloc(w->c.size = TINY_STRINGIFY_CHUNK_SIZE);
+    w->c.top = 0;
+    w->c.sink = sink;
+    w->c.gather = nullptr;
+    w->c.status = 0;
+    w->buffer = nullptr;
+    w->scopes = nullptr;
+    w->depth = w->capacity = 0;
+    w->roots = 0;
+}
+
+/// @brief 结束生成, 写出剩余内容并释放内部状态
+/// @return 0 表示成功, 否则为 sink 返回的第一个非 0 值
+int tiny_writer_finish(tiny_writer* w) {
+    assert(w != nullptr);
+    assert(w->depth == 0 && "unbalanced tiny_writer");
+    assert(w->roots == 1 && "tiny_writer must produce exactly one value");
+    if (w->buffer != nullptr) {
+        w->buffer->size = w->c.top;
+        PUTC(&w->c, '\0');
+        w->buffer->data = w->c.stack;
+        w->buffer->capacity = w->c.size;
+    }
+    else {
+        tiny_context_flush(&w->c);
+        tiny_dealloc(w->c.stack, w->c.size);
+    }
+    tiny_dealloc(w->scopes, w->capacity);
+    w->c.stack = nullptr;
+    w->c.size = w->c.top = 0;
+    w->scopes = nullptr;
+    w->depth = w->capacity = 0;
+    return w->c.status;
+}
+
+/// @brief 写一个值之前的处理: 数组中补逗号, 对象中要求前面刚写完 key
+static void tiny_writer_prefix(tiny_writer* w) {
+    unsigned char* scope;
+    if (w->depth == 0) {
+        assert(w->roots == 0 && "tiny_writer must produce exactly one value");
+        w->roots++;
+        return;
+    }
+    scope = &w->scopes[w->depth - 1];
+    if (*scope & TINY_WRITER_OBJECT) {
+        assert((*scope & TINY_WRITER_KEY) && "tiny_writer: object value without key");
+        *scope &= ~TINY_WRITER_KEY;
+    }
+    else {
+        if (*scope & TINY_WRITER_COMMA) PUTC(&w->c, ',');
+        *scope |= TINY_WRITER_COMMA;
+    }
+}
+
+static void tiny_writer_open(tiny_writer* w, char ch, unsigned char scope) {
+    tiny_writer_prefix(w);
+    if (w->depth == w->capacity) {
+        size_t capacity = w->capacity == 0 ? 16 : w->capacity * 2;
+        w->scopes = (unsigned char*)tiny_realloc(w->scopes, w->capacity, capacity);
+        w->capacity = capacity;
+    }
+    w->scopes[w->depth++] = scope;
+    PUTC(&w->c, ch);
+}
+
+static void tiny_writer_close(tiny_writer* w, char ch, unsigned char scope) {
+    (void)scope;
+    assert(w->depth > 0 && "unbalanced tiny_writer");
+    assert((w->scopes[w->depth - 1] & TINY_WRITER_OBJECT) == scope && "tiny_writer: mismatched end");
+    assert(!(w->scopes[w->depth - 1] & TINY_WRITER_KEY) && "tiny_writer: key without value");
+    w->depth--;
+    PUTC(&w->c, ch);
+}
+
+void tiny_writer_start_object(tiny_writer* w) { tiny_writer_open(w, '{', TINY_WRITER_OBJECT); }
+void tiny_writer_end_object(tiny_writer* w) { tiny_writer_close(w, '}', TINY_WRITER_OBJECT); }
+void tiny_writer_start_array(tiny_writer* w) { tiny_writer_open(w, '[', 0); }
+void tiny_writer_end_array(tiny_writer* w) { tiny_writer_close(w, ']', 0); }
+
+/// @brief 写对象成员的 key, 之后必须紧跟一个值
+void tiny_writer_key(tiny_writer* w, const char* key, size_t klen) {
+    unsigned char* scope;
+    assert(w->depth > 0 && (w->scopes[w->depth - 1] & TINY_WRITER_OBJECT) && "tiny_writer: key outside object");
+    scope = &w->scopes[w->depth - 1];
+    assert(!(*scope & TINY_WRITER_KEY) && "tiny_writer: key without value");
+    if (*scope & TINY_WRITER_COMMA) PUTC(&w->c, ',');
+    *scope |= TINY_WRITER_COMMA | TINY_WRITER_KEY;
+    tiny_stringify_string(&w->c, key, klen);
+    PUTC(&w->c, ':');
+}
+
+void tiny_writer_null(tiny_writer* w) {
+    tiny_writer_prefix(w);
+    PUTS(&w->c, "null", 4);
+}
+
+void tiny_writer_boolean(tiny_writer* w, int b) {
+    tiny_writer_prefix(w);
+    if (b) PUTS(&w->c, "true", 4);
+    else PUTS(&w->c, "false", 5);
+}
+
+/// @brief 写整数, 按十进制原样输出, 不经过 double
+void tiny_writer_int(tiny_writer* w, long long i) {
+    char buffer[20];
+    size_t n = tiny_i64toa(i, buffer);
+    tiny_writer_prefix(w);
+    PUTS(&w->c, buffer, n);
+}
+
+void tiny_writer_double(tiny_writer* w, double d) {
+    char buffer[TINY_DTOA_MAX];
+    size_t n;
+    tiny_writer_prefix(w);
+    n = tiny_dtoa(d, buffer);
+    PUTS(&w->c, buffer, n);
+}
+
+void tiny_writer_string(tiny_writer* w, const char* s, size_t len) {
+    tiny_writer_prefix(w);
+    tiny_stringify_string(&w->c, s, len);
+}
+
+/// @brief 把已有的 json 节点整体写入, 用于混合 DOM 和流式生成
+void tiny_writer_value(tiny_writer* w, const tiny_node* node) {
+    assert(node != nullptr);
+    tiny_writer_prefix(w);
+    tiny_stringify_value(&w->c, node);
+}
+
+/// @brief 增量 stringify 缓存中一个容器的记录, 以容器元素缓冲区的首地址为键
+/// 容器的缓冲区只在容器被释放或扩缩容时改变, 所以比节点地址稳定
+struct tiny_cache_entry {
+    const char* end;     // 元素缓冲区末尾, 用于按地址找到节点所在的容器
+    const char* parent;  // 父容器的元素缓冲区, 根为 nullptr
+    size_t offset;       // 上次输出时相对父容器起点的偏移
+    size_t length;       // 序列化后的长度
+    unsigned placed;     // 写出 offset 时父容器的 content, 两者相等时 offset 有效
+    unsigned content;    // 本容器的字节在第几趟生成, 被原样复制时不变
+    bool dirty;          // 本容器或其子孙被修改过
+};
+
+typedef std::unordered_map<const char*, tiny_cache_entry> tiny_cache_map;
+
+/// @brief 增量 stringify 缓存, 按线程登记, 本线程上的修改接口会把被修改位置到根的路径标脏
+struct tiny_stringify_cache {
+    tiny_cache_map entries;                           // 输出时按缓冲区查找
+    std::map<const char*, tiny_cache_entry*> ranges;  // 按地址有序, 用于找到节点所在的容器
+    tiny_context c;           // 本趟输出
+    char* old;                // 上一趟输出
+    size_t old_size;          // old 的容量
+    unsigned pass;            // 已完成的趟数, 上一趟输出由第 pass 趟生成
+    tiny_stringify_cache* next;
+};
+
+static thread_local tiny_stringify_cache* tiny_caches = nullptr;
+
+/// @brief 容器元素缓冲区的首尾, 空容器返回 nullptr
+static const char* tiny_cache_buffer(const tiny_node* node, const char** end) {
+    if (node->type == TINY_ARRAY && node->a.size > 0) {
+        *end = (const char*)(node->a.e + node->a.capacity);
+        return (const char*)node->a.e;
+    }
+    if (node->type == TINY_OBJECT && node->o.size > 0) {
+        *end = (const char*)(node->o.m + node->o.capacity);
+        return (const char*)node->o.m;
+    }
+    return nullptr;
+}
+
+/// @brief 把 node 所在的容器 (node 本身是已缓存的容器时为它自己) 到根的路径标脏
+/// 向上遇到已经是脏的记录即可停止, 它的祖先在它被标脏时已经标过
+static void tiny_cache_touch_slow(const tiny_node* node) {
+    const char *key, *end;
+    for (tiny_stringify_cache* cache = tiny_caches; cache != nullptr; cache = cache->next) {
+        tiny_cache_map::iterator it;
+        tiny_cache_entry* e = nullptr;
+        if ((key = tiny_cache_buffer(node, &end)) != nullptr && (it = cache->entries.find(key)) != cache->entries.end())
+            e = &it->second;
+        else {
+            std::map<const char*, tiny_cache_entry*>::iterator r = cache->ranges.upper_bound((const char*)node);
+            if (r == cache->ranges.begin() || (const char*)node >= (--r)->second->end) continue;
+            e = r->second;
+        }
+        while (!e->dirty) {
+            e->dirty = true;
+            if (e->parent == nullptr || (it = cache->entries.find(e->parent)) == cache->entries.end()) break;
+            e = &it->second;
+        }
+    }
+}
+
+/// @brief 修改节点前调用, 没有缓存时只有一次判断
+static inline void tiny_cache_touch(const tiny_node* node) {
+    if (tiny_caches != nullptr) tiny_cache_touch_slow(node);
+}
+
+/// @brief 容器的元素缓冲区被释放前调用, 防止地址被新容器复用后命中旧记录
+static inline void tiny_cache_forget(const void* buffer) {
+    for (tiny_stringify_cache* cache = tiny_caches; cache != nullptr; cache = cache->next) {
+        if (cache->entries.erase((const char*)buffer)) cache->ranges.erase((const char*)buffer);
+    }
+}
+
+/// @brief 容器扩缩容后调用, 把记录挪到新缓冲区下, 并更新子容器记录中的父容器
+static void tiny_cache_rekey(const tiny_node* node, const void* old) {
+    const char *key, *end, *child, *child_end;
+    size_t i, n;
+    if (tiny_caches == nullptr) return;
+    if ((key = tiny_cache_buffer(node, &end)) == nullptr) {  // 缩容到空
+        tiny_cache_forget(old);
+        return;
+    }
+    n = node->type == TINY_ARRAY ? node->a.size : node->o.size;
+    for (tiny_stringify_cache* cache = tiny_caches; cache != nullptr; cache = cache->next) {
+        tiny_cache_map::iterator it, ct;
+        if ((it = cache->entries.find((const char*)old)) == cache->entries.end()) continue;
+        if (key != (const char*)old) {
+            // 节点句柄保持记录的地址不变, ranges 中的指针依然有效
+            tiny_cache_map::node_type nh = cache->entries.extract(it);
+            nh.key() = key;
+            it = cache->entries.insert(std::move(nh)).position;
+            cache->ranges.erase((const char*)old);
+            cache->ranges.emplace(key, &it->second);
+            for (i = 0; i < n; i++) {
+                const tiny_node* e = node->type == TINY_ARRAY ? &node->a.e[i] : &node->o.m[i].value;
+                if ((child = tiny_cache_buffer(e, &child_end)) != nullptr && 
+                    (ct = cache->entries.find(child)) != cache->entries.end() && ct->second.parent == (const char*)old)
+                    ct->second.parent = key;
+            }
+        }
+        it->second.end = end;
+    }
+}
+
+/// @brief 新建增量 stringify 缓存并登记到当前线程
+/// 之后在本线程上通过 tiny_set_xxx 等接口做的修改都会使相应的缓存失效; 
+/// 直接改写 tiny_get_array_element 等返回的节点内容、或在其他线程上修改, 都不会被记录
+tiny_stringify_cache* tiny_stringify_cache_create() {
+    tiny_stringify_cache* cache = new tiny_stringify_cache;
+    cache->c.stack = nullptr;
+    cache->c.size = cache->c.top = 0;
+    cache->c.sink = nullptr;
+    cache->c.gather = nullptr;
+    cache->c.status = 0;
+    cache->old = nullptr;
+    cache->old_size = 0;
+    cache->pass = 0;
+    cache->next = tiny_caches;
+    tiny_caches = cache;
+    return cache;
+}
+
+/// @brief 释放缓存, 必须在创建它的线程上调用
+void tiny_stringify_cache_free(tiny_stringify_cache* cache) {
+    tiny_stringify_cache** p;
+    assert(cache != nullptr);
+    for (p = &tiny_caches; *p != cache; p = &(*p)->next) assert(*p != nullptr);
+    *p = cache->next;
+    tiny_dealloc(cache->c.stack, cache->c.size);
+    tiny_dealloc(cache->old, cache->old_size);
+    delete cache;
+}
+
+/// @brief 增量输出一个值
+/// 容器干净且在上一趟输出中的位置可知时直接复制上一趟的字节, 否则重新生成, 子容器仍可能被复制
+/// @param parent 父容器的元素缓冲区
+/// @param old_start 父容器在上一趟输出中的起点, 未知时为 TINY_KEY_NOT_EXIST
+/// @param old_content 父容器上一趟输出的字节是第几趟生成的
+/// @param start 父容器在本趟输出中的起点
+static void tiny_stringify_cached_value(tiny_stringify_cache* cache, const tiny_node* node, 
+    const char* parent, size_t old_start, unsigned old_content, size_t start) {
+    tiny_context* c = &cache->c;
+    tiny_cache_map::iterator it;
+    tiny_cache_entry* e;
+    const char *key, *end;
+    size_t i, n, from = TINY_KEY_NOT_EXIST, head = c->top;
+    unsigned content = 0;
+    if ((key = tiny_cache_buffer(node, &end)) == nullptr) {
+        tiny_stringify_value(c, node);
+        return;
+    }
+    // 递归中插入新记录可能导致 rehash, 迭代器失效但记录的地址不变, 所以只保留指针
+    if ((it = cache->entries.find(key)) != cache->entries.end()) {
+        e = &it->second;
+        if (old_start != TINY_KEY_NOT_EXIST && e->parent == parent && e->placed == old_content) {
+            from = old_start + e->offset;
+            if (!e->dirty) {
+                PUTS(c, cache->old + from, e->length);
+                e->offset = head - start;
+                e->placed = cache->pass + 1;
+                return;
+            }
+        }
+        content = e->content;
+    }
+    else {
+        e = &cache->entries.emplace(key, tiny_cache_entry()).first->second;
+        cache->ranges.emplace(key, e);
+    }
+
+    n = node->type == TINY_ARRAY ? node->a.size : node->o.size;
+    PUTC(c, node->type == TINY_ARRAY ? '[' : '{');
+    for (i = 0; i < n; i++) {
+        if (i > 0) PUTC(c, ',');
+        if (node->type == TINY_ARRAY) {
+            tiny_stringify_cached_value(cache, &node->a.e[i], key, from, content, head);
+        }
+        else {
+            tiny_stringify_key(c, &node->o.m[i]);
+            tiny_stringify_cached_value(cache, &node->o.m[i].value, key, from, content, head);
+        }
+    }
+    PUTC(c, node->type == TINY_ARRAY ? ']' : '}');
+
+    e->end = end;
+    e->parent = parent;
+    e->offset = head - start;
+    e->length = c->top - head;
+    e->placed = e->content = cache->pass + 1;
+    e->dirty = false;
+}
+
+/// @brief 增量生成 JSON, 只重新生成上次调用后被修改过的容器, 其余容器复制上一次的输出
+/// 单个字段的修改只需重新生成它到根路径上的各层容器 (不含其中干净的子容器), 再加一次整体复制
+/// @param cache 由 tiny_stringify_cache_create 创建的缓存, 可以用于多个文档, 但交替使用时不能命中
+/// @param node json 节点
+/// @param length 输出的长度, 可以为 nullptr
+/// @return 以 '\0' 结尾的输出, 属于 cache, 下一次调用或释放 cache 后失效
+const char* tiny_stringify_cached(tiny_stringify_cache* cache, const tiny_node* node, size_t* length) {
+    tiny_context* c = &cache->c;
+    char* stack;
+    size_t size;
+    assert(cache != nullptr && node != nullptr);
+    c->top = 0;
+    // 根在上一趟输出中的起点为 0, 根记录的 placed 就是上一趟的趟数
+    tiny_stringify_cached_value(cache, node, nullptr, 0, cache->pass, 0);
+    PUTC(c, '\0');
+    if (length) *length = c->top - 1;
+    cache->pass++;
+    // 本趟输出成为下一趟的 old, 原来的 old 留作下一趟的输出缓冲区
+    stack = cache->old;
+    size = cache->old_size;
+    cache->old = c->stack;
+    cache->old_size = c->size;
+    c->stack = stack;
+    c->size = size;
+    return cache->old;
+}
+
+/// @brief 紧凑数字数组的第 i 个元素
+static double tiny_packed_at(const tiny_node* node, size_t i) {
+    switch (node->v.type) {
+        case TINY_PACKED_FLOAT: return ((const float*)node->v.p)[i];
+        case TINY_PACKED_INT64: return (double)((const int64_t*)node->v.p)[i];
+        default:                return ((const double*)node->v.p)[i];
+    }
+}
+
+/// @brief 把紧凑数组的元素展开为 TINY_NUMBER 节点
+/// 绝对值超过 2^53 的 int64 元素无法用 double 精确表示, 节点同时保留其原文, 输出时不损失精度
+static tiny_node* tiny_packed_expand(const tiny_node* node) {
+    const int64_t limit = (int64_t)1 << 53;
+    size_t i, n = node->v.size;
+    tiny_node* e = (tiny_node*)tiny_malloc(n * sizeof(tiny_node));
+    for (i = 0; i < n; i++) {
+        e[i].n = tiny_packed_at(node, i);
+        e[i].d.s = nullptr;
+        e[i].type = TINY_NUMBER;
+        if (node->v.type == TINY_PACKED_INT64) {
+            int64_t v = ((const int64_t*)node->v.p)[i];
+            if (v > limit || v < -limit) {
+                char buffer[20];
+                e[i].d.len = tiny_i64toa(v, buffer);
+                memcpy(e[i].d.s = (char*)tiny_malloc(e[i].d.len + 1), buffer, e[i].d.len);
+                e[i].d.s[e[i].d.len] = '\0';
+            }
+        }
+    }
+    return e;
+}
+
+/// @brief 释放 tiny_packed_expand 得到的 n 个节点
+static void tiny_packed_release(tiny_node* e, size_t n) {
+    for (size_t i = 0; i < n; i++) tiny_dealloc(e[i].d.s, e[i].d.len + 1);
+    tiny_dealloc(e, n * sizeof(tiny_node));
+}
+
+/// @brief 紧凑数组的只读元素视图, 供 tiny_get_array_element 等只读访问使用, 数组本身不变
+/// 第一次访问时构造并发布到数据头部, 之后直到数组被修改或释放都不变; 多个线程同时构造时只保留先发布的一份
+static tiny_node* tiny_packed_views(const tiny_node* node) {
+    tiny_packed_header* h = tiny_packed_head(node);
+    tiny_node *e = h->load(memory_order_acquire), *expected = nullptr;
+    if (e != nullptr) return e;
+    e = tiny_packed_expand(node);
+    if (h->compare_exchange_strong(expected, e, memory_order_acq_rel, memory_order_acquire)) return e;
+    tiny_packed_release(e, node->v.size);
+    return expected;
+}
+
+/// @brief 释放紧凑数组的数据和元素视图
+static void tiny_packed_free(tiny_node* node) {
+    tiny_node* e = tiny_packed_head(node)->load(memory_order_acquire);
+    if (e != nullptr) tiny_packed_release(e, node->v.size);
+    tiny_dealloc((char*)node->v.p - TINY_PACKED_HEADER, TINY_PACKED_HEADER + node->v.size * tiny_packed_size(node->v.type));
+}
+
+/// @brief 把 TINY_NUMBER_ARRAY 原地展开为元素为 TINY_NUMBER 的 TINY_ARRAY, 其他类型不变; 只由修改数组的函数调用
+/// 已有元素视图时直接用作数组的元素
+static void tiny_unpack_array(tiny_node* node) {
+    tiny_node* e;
+    size_t n;
+    if (node->type != TINY_NUMBER_ARRAY) return;
+    tiny_cache_touch(node);
+    n = node->v.size;
+    if ((e = tiny_packed_head(node)->exchange(nullptr, memory_order_acquire)) == nullptr) e = tiny_packed_expand(node);
+    tiny_packed_free(node);
+    node->type = TINY_ARRAY;
+    node->a.e = e;
+    node->a.size = node->a.capacity = n;
+}
+
+static double tiny_decimal_to_double(const tiny_node* node);  // forward declare
+
+/// @brief TINY_NUMBER 或 TINY_DECIMAL 的值, 与 tiny_get_number 相同, 但延迟转换的数字只在本地转换而不写回节点
+/// 供 tiny_is_equal、tiny_diff 和 tiny_path_eval 等只读的函数使用, 可以在多个线程中同时调用
+static double tiny_number_value(const tiny_node* node) {
+    if (node->type == TINY_DECIMAL) return tiny_decimal_to_double(node);
+    return node->d.s != nullptr && isnan(node->n) ? strtod(node->d.s, nullptr) : node->n;
+}
+
+/// @brief 比较两个数组, 至少有一个是紧凑数字数组; 按数值逐个比较, 与存储方式无关
+static int tiny_is_equal_packed(const tiny_node* lhs, const tiny_node* rhs) {
+    size_t i, n;
+    if (lhs->type != TINY_NUMBER_ARRAY) {
+        const tiny_node* t = lhs;
+        lhs = rhs;
+        rhs = t;
+    }
+    n = lhs->v.size;
+    if (rhs->type == TINY_ARRAY) {
+        if (rhs->a.size != n) return 0;
+        for (i = 0; i < n; i++)
+            if (rhs->a.e[i].type != TINY_NUMBER || tiny_number_value(&rhs->a.e[i]) != tiny_packed_at(lhs, i)) return 0;
+        return 1;
+    }
+    if (rhs->v.size != n) return 0;
+    if (lhs->v.type == TINY_PACKED_INT64 && rhs->v.type == TINY_PACKED_INT64)
+        return n == 0 || memcmp(lhs->v.p, rhs->v.p, n * sizeof(int64_t)) == 0;
+    for (i = 0; i < n; i++)
+        if (tiny_packed_at(lhs, i) != tiny_packed_at(rhs, i)) return 0;
+    return 1;
+}
+
+/// @brief 实现对 json 节点的深度复制
+/// @param dst 目标节点 
+/// @param src 源节点
+void tiny_copy(tiny_node* dst, const tiny_node* src) {
+    assert(src != nullptr && dst != nullptr && src != dst);
+    size_t i, size;
+    switch (src->type) {
+        case TINY_STRING:
+            tiny_set_string(dst, src->s.s, src->s.len);
+            break;
+        case TINY_NUMBER:
+            tiny_free(dst);
+            memcpy(dst, src, sizeof(tiny_node));
+            if (src->d.s != nullptr) {  // 原文归各节点所有
+                memcpy(dst->d.s = (char*)tiny_malloc(src->d.len + 1), src->d.s, src->d.len + 1);
+            }
+            break;
+        case TINY_DECIMAL:
+            tiny_free(dst);
+            memcpy(dst, src, sizeof(tiny_node));
+            dst->x.s = (char*)tiny_malloc(src->x.len);
+            if (src->x.len > 0) memcpy(dst->x.s, src->x.s, src->x.len);
+            break;
+        case TINY_ARRAY:
+            tiny_free(dst);
+            size = src->a.size;
+            dst->a.size = dst->a.capacity = size;
+            dst->a.e = (tiny_node*)tiny_malloc(size * sizeof(tiny_node));
+            for (i = 0; i < size; i++) {
+                tiny_init(&dst->a.e[i]);
+                tiny_copy(&dst->a.e[i], &src->a.e[i]);
+            }
+            dst->type = TINY_ARRAY;
+            break;
+        case TINY_OBJECT:
+            tiny_free(dst);
+            size = src->o.size;
+            dst->o.size = dst->o.capacity = size;
+            dst->o.m = (tiny_member*)tiny_malloc(size * sizeof(tiny_member));
+            for (i = 0; i < size; i++) {
+                tiny_member_set_key(&dst->o.m[i], src->o.m[i].key, src->o.m[i].keylen);
+                tiny_init(&dst->o.m[i].value);
+                tiny_copy(&dst->o.m[i].value, &src->o.m[i].value);
+            }
+            dst->type = TINY_OBJECT;
+            break;
+        case TINY_NUMBER_ARRAY:
+            tiny_free(dst);
+            size = src->v.size * tiny_packed_size(src->v.type);
+            dst->v.p = tiny_packed_alloc(src->v.type, src->v.size);
+            if (size > 0) memcpy(dst->v.p, src->v.p, size);
+            dst->v.size = src->v.size;
+            dst->v.type = src->v.type;
+            dst->type = TINY_NUMBER_ARRAY;
+            break;
+        default:
+            tiny_free(dst);
+            memcpy(dst, src, sizeof(tiny_node));
+            break;
+    }
+}
+
+void tiny_move(tiny_node* dst, tiny_node* src) {
+    assert(dst != nullptr && src != nullptr && src != dst);
+    tiny_cache_touch(src);
+    tiny_free(dst);
+    memcpy(dst, src, sizeof(tiny_node));
+    tiny_init(src);
+}
+
+void tiny_swap(tiny_node* lhs, tiny_node* rhs) {
+    assert(lhs != nullptr && rhs != nullptr);
+    if (lhs != rhs) {
+        tiny_node temp;
+        tiny_cache_touch(lhs);
+        tiny_cache_touch(rhs);
+        memcpy(&temp, lhs, sizeof(tiny_node));
+        memcpy(lhs,   rhs, sizeof(tiny_node));
+        memcpy(rhs, &temp, sizeof(tiny_node));
+    }
+}
+
+void tiny_free(tiny_node* node) {
+    size_t i;
+    assert(node != nullptr);
+    tiny_cache_touch(node);
+    switch (node->type) {
+        case TINY_STRING:
+            if (node->s.capacity > 0) tiny_dealloc(node->s.s, node->s.capacity);  // 引用输入时 capacity 为 0
+            break;
+        case TINY_NUMBER:
+            tiny_dealloc(node->d.s, node->d.len + 1);  // 不是延迟转换的数字时为空指针
+            break;
+        case TINY_DECIMAL:
+            tiny_dealloc(node->x.s, node->x.len);
+            break;
+        case TINY_ARRAY:
+            // 先释放每个 ele 开辟的空间
+            for (i = 0; i < node->a.size; i++) {
+                tiny_free(&node->a.e[i]);
+            }
+            tiny_cache_forget(node->a.e);
+            tiny_dealloc(node->a.e, node->a.capacity * sizeof(tiny_node));  // 最后释放自己开辟的空间
+            break;
+        case TINY_OBJECT:
+            for (i = 0; i < node->o.size; i++) {
+                tiny_member_free_key(&node->o.m[i]);
+                tiny_free(&node->o.m[i].value);
+            }
+            tiny_cache_forget(node->o.m);
+            tiny_dealloc(node->o.m, node->o.capacity * sizeof(tiny_member));
+            break;
+        case TINY_NUMBER_ARRAY:
+            tiny_packed_free(node);
+            break;
+        default: break;
+    }
+    node->type = TINY_NULL;
+}
+
+tiny_type tiny_get_type(const tiny_node* node){
+    assert(node != nullptr);  // 先判断是否为空指针
+    return node->type;
+}
+
+/// @brief 把 TINY_DECIMAL 拼成 "-ddde-x" 形式后用 strtod 转换为最接近的 double
+static double tiny_decimal_to_double(const tiny_node* node) {
+    char buffer[64], *p;
+    size_t size = node->x.len + 14;  // 符号、'e'、指数和结束符
+    double d;
+    if (node->x.len == 0) return 0.0;
+    p = size <= sizeof(buffer) ? buffer : (char*)tiny_malloc(size);
+    p[0] = '-';
+    memcpy(p + 1, node->x.s, node->x.len);
+    p[1 + node->x.len] = 'e';
+    p[2 + node->x.len + tiny_i64toa(node->x.exp, p + 2 + node->x.len)] = '\0';
+    d = strtod(p + !node->x.neg, nullptr);
+    if (p != buffer) tiny_dealloc(p, size);
+    return d;
+}
+
+/// @brief 比较 TINY_DECIMAL 与 TINY_NUMBER: double 的最短往返表示与十进制数完全相同时才相等
+static int tiny_is_equal_decimal(const tiny_node* lhs, const tiny_node* rhs) {
+    uint64_t bits, f;
+    double d;
+    int e, n;
+    char digits[17];
+    if (lhs->type != TINY_DECIMAL) {
+        const tiny_node* t = lhs;
+        lhs = rhs;
+        rhs = t;
+    }
+    d = tiny_number_value(rhs);
+    if (d == 0.0) return lhs->x.len == 0;
+    if (isinf(d) || lhs->x.neg != (d < 0)) return 0;
+    memcpy(&bits, &d, sizeof(d));
+    n = tiny_dtoa_shortest(bits, &f, &e);
+    if ((size_t)n != lhs->x.len || e != lhs->x.exp) return 0;
+    for (e = n; e-- > 0; f /= 10) digits[e] = (char)('0' + f % 10);
+    return memcmp(digits, lhs->x.s, n) == 0;
+}
+
+/// @brief 计算 key 的哈希值 (FNV-1a)
+/// @param key key 字符串
+/// @param klen key 长度
+/// @return 哈希值
+static size_t tiny_hash_key(const char* key, size_t klen) {
+    unsigned long long h = 14695981039346656037ull;
+    for (size_t i = 0; i < klen; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ull;
+    }
+    return (size_t)h;
+}
+
+/// @brief 临时哈希表, 记录 object 中 key 到成员下标的映射 (开放寻址, 线性探测)
+typedef struct {
+    size_t* slots;
+    size_t mask;
+} tiny_key_index;
+
+/// @brief 为 object 的成员建立哈希索引, 重复的 key 以最后一个为准
+/// @param idx 哈希索引
+/// @param m 成员数组
+/// @param n 成员个数
+/// @param shadowed 非空时, 被后面同名 key 覆盖的成员会被标记为 1
+static void tiny_key_index_build(tiny_key_index* idx, const tiny_member* m, size_t n, unsigned char* shadowed) {
+    size_t i, cap, h;
+    for (cap = 8; cap < n * 2; cap <<= 1);  // 负载因子不超过 0.5
+    idx->mask = cap - 1;
+    idx->slots = (size_t*)tiny_malloc(cap * sizeof(size_t));
+    for (i = 0; i < cap; i++) idx->slots[i] = TINY_KEY_NOT_EXIST;
+    for (i = 0; i < n; i++) {
+        for (h = tiny_hash_key(m[i].key, m[i].keylen) & idx->mask; idx->slots[h] != TINY_KEY_NOT_EXIST; h = (h + 1) & idx->mask) {
+            const tiny_member* old = &m[idx->slots[h]];
+            if (old->keylen == m[i].keylen && memcmp(old->key, m[i].key, m[i].keylen) == 0) {
+                if (shadowed) shadowed[idx->slots[h]] = 1;
+                break;
+            }
+        }
+        idx->slots[h] = i;
+    }
+}
+
+/// @brief 在哈希索引中查找 key
+/// @return 成员下标, 没找到的话返回 TINY_KEY_NOT_EXIST
+static size_t tiny_key_index_find(const tiny_key_index* idx, const tiny_member* m, const char* key, size_t klen) {
+    size_t h;
+    for (h = tiny_hash_key(key, klen) & idx->mask; idx->slots[h] != TINY_KEY_NOT_EXIST; h = (h + 1) & idx->mask) {
+        const tiny_member* cur = &m[idx->slots[h]];
+        if (cur->keylen == klen && memcmp(cur->key, key, klen) == 0)
+            return idx->slots[h];
+    }
+    return TINY_KEY_NOT_EXIST;
+}
+
+static void tiny_key_index_free(tiny_key_index* idx) {
+    tiny_dealloc(idx->slots, (idx->mask + 1) * sizeof(size_t));
+}
+
+/// @brief 比较两个 object, 与成员顺序无关
+/// 顺序一致的前缀逐个位置比较, 之后按 rhs 的 key 建立哈希索引查找, 并标记已匹配的成员, 每个成员最多匹配一次
+static int tiny_is_equal_object(const tiny_node* lhs, const tiny_node* rhs) {
+    size_t i, j, n = lhs->o.size;
+    unsigned char* state;  // 0: 未匹配, 1: 被同名 key 覆盖, 2: 已匹配
+    tiny_key_index idx;
+    int eq = 1;
+    if (rhs->o.size != n) return 0;
+    for (i = 0; i < n; i++) {
+        const tiny_member *m = &lhs->o.m[i], *r = &rhs->o.m[i];
+        if (m->keylen != r->keylen || memcmp(m->key, r->key, m->keylen) != 0) break;
+        if (!tiny_is_equal(&m->value, &r->value)) return 0;
+    }
+    if (i == n) return 1;
+    state = (unsigned char*)tiny_malloc(n);
+    memset(state, 0, n);
+    tiny_key_index_build(&idx, rhs->o.m, n, state);
+    if (i > 0) memset(state, 2, i);
+    for (; eq && i < n; i++) {
+        const tiny_member* m = &lhs->o.m[i];
+        j = tiny_key_index_find(&idx, rhs->o.m, m->key, m->keylen);
+        eq = j != TINY_KEY_NOT_EXIST && state[j] != 2 && tiny_is_equal(&m->value, &rhs->o.m[j].value);
+        if (eq) state[j] = 2;
+    }
+    tiny_key_index_free(&idx);
+    tiny_dealloc(state, n);
+    return eq;
+}
+
+int tiny_is_equal(const tiny_node* lhs, const tiny_node* rhs) {
+    size_t i;
+    assert(lhs != nullptr && rhs != nullptr);
+    if ((lhs->type == TINY_NUMBER_ARRAY && (rhs->type == TINY_ARRAY || rhs->type == TINY_NUMBER_ARRAY)) ||
+        (rhs->type == TINY_NUMBER_ARRAY && lhs->type == TINY_ARRAY))
+        return tiny_is_equal_packed(lhs, rhs);
+    if ((lhs->type == TINY_DECIMAL && rhs->type == TINY_NUMBER) || (lhs->type == TINY_NUMBER && rhs->type == TINY_DECIMAL))
+        return tiny_is_equal_decimal(lhs, rhs);
+    if (lhs->type != rhs->type) return 0;
+    switch (lhs->type) {
+        case TINY_STRING:
+            return (lhs->s.len == rhs->s.len) && (memcmp(lhs->s.s, rhs->s.s, lhs->s.len) == 0);
+        case TINY_NUMBER:
+            return tiny_number_value(lhs) == tiny_number_value(rhs);
+        case TINY_DECIMAL:  // 表示唯一, 直接比较各部分
+            return lhs->x.neg == rhs->x.neg && lhs->x.exp == rhs->x.exp && lhs->x.len == rhs->x.len &&
+                (lhs->x.len == 0 || memcmp(lhs->x.s, rhs->x.s, lhs->x.len) == 0);
+        case TINY_ARRAY:
+            if (lhs->a.size != rhs->a.size) return 0;
+            for (i = 0; i < lhs->a.size; i++) {
+                if (!tiny_is_equal(&lhs->a.e[i], &rhs->a.e[i])) return 0;
+            }
+            return 1;
+        case TINY_OBJECT:
+            return tiny_is_equal_object(lhs, rhs);
+        default: return 1;
+    }
+}
+
+int tiny_get_boolean(const tiny_node* node){
+    assert(node != nullptr && (node->type == TINY_FALSE || node->type == TINY_TRUE));
+    return node->type == TINY_TRUE;  // 巧妙！
+}
+
+void tiny_set_boolean(tiny_node* node, int b){
+    assert(node != nullptr);
+    tiny_free(node);
+    node->type = b ? TINY_TRUE : TINY_FALSE;  // 巧妙！
+}
+
+double tiny_get_number(const tiny_node* node){
+    assert(node != nullptr && (node->type == TINY_NUMBER || node->type == TINY_DECIMAL));
+    if (node->type == TINY_DECIMAL) return tiny_decimal_to_double(node);
+    if (node->d.s != nullptr && isnan(node->n))
+        ((tiny_node*)node)->n = strtod(node->d.s, nullptr);  // 延迟转换, 结果缓存在节点中, 原文保留用于输出
+    return node->n;
+}
+
+void tiny_set_number(tiny_node* node, double n){
+    assert(node != nullptr);
+    tiny_free(node);
+    node->n = n;
+    node->d.s = nullptr;
+    node->type = TINY_NUMBER;
+}
+
+/// @brief 取出十进制数的各部分, d->digits 指向节点内部, 节点修改或释放后失效
+void tiny_get_decimal(const tiny_node* node, tiny_decimal* d) {
+    assert(node != nullptr && node->type == TINY_DECIMAL && d != nullptr);
+    d->digits = node->x.s;
+    d->len = node->x.len;
+    d->exponent = node->x.exp;
+    d->negative = node->x.neg;
+}
+
+/// @brief 设置十进制数, 去掉 d 中前导和末尾的 0 后复制; d->digits 可以指向 node 自身 (来自 tiny_get_decimal)
+/// @return 与 tiny_parse_decimal 一样, 指数或位数超出 TINY_DECIMAL_MAX 时返回 0 且不修改节点, 否则返回 1
+int tiny_set_decimal(tiny_node* node, const tiny_decimal* d) {
+    const char* s;
+    char* x;
+    size_t len;
+    int64_t exp;
+    assert(node != nullptr && d != nullptr && (d->digits != nullptr || d->len == 0));
+    s = d->digits;
+    len = d->len;
+    exp = d->exponent;
+    for (; len > 0 && *s == '0'; len--) s++;
+    for (; len > 0 && s[len - 1] == '0'; len--) exp++;
+    if (len == 0) exp = 0;  // 0 只有一种表示
+    else if (exp > TINY_DECIMAL_MAX || exp < -TINY_DECIMAL_MAX || len > TINY_DECIMAL_MAX) return 0;
+    x = (char*)tiny_malloc(len);
+    if (len > 0) memcpy(x, s, len);  // 先复制再释放, digits 可能指向旧的 x.s
+    tiny_free(node);
+    node->x.s = x;
+    node->x.len = len;
+    node->x.exp = (int)exp;
+    node->x.neg = len > 0 && d->negative;
+    node->type = TINY_DECIMAL;
+    return 1;
+}
+
+/// @brief 把十进制数乘以 10^scale 后转换为 int64_t, 例如金额按 scale = 2 转换为以分为单位的整数
+/// @return 结果恰好是 int64_t 范围内的整数时返回 1 并写入 *out, 否则返回 0
+int tiny_get_decimal_scaled(const tiny_node* node, int scale, int64_t* out) {
+    uint64_t u = 0, limit = (uint64_t)INT64_MAX;
+    int64_t k;
+    size_t i;
+    assert(node != nullptr && node->type == TINY_DECIMAL && out != nullptr);
+    k = (int64_t)node->x.exp + scale;
+    if (node->x.len == 0) {
+        *out = 0;
+        return 1;
+    }
+    if (k < 0) return 0;  // 有效数字不以 0 结尾, 指数为负时一定有小数部分
+    if (node->x.neg) limit++;
+    for (i = 0; i < node->x.len; i++) {
+        if (u > (limit - (node->x.s[i] - '0')) / 10) return 0;
+        u = u * 10 + (node->x.s[i] - '0');
+    }
+    for (; k > 0; k--) {  // u 不为 0, 最多乘 19 次就会超出范围
+        if (u > limit / 10) return 0;
+        u *= 10;
+    }
+    *out = node->x.neg ? (int64_t)(0 - u) : (int64_t)u;
+    return 1;
+}
+
+const char* tiny_get_string(const tiny_node* node){
+    // 引用输入的字符串不以 '\0' 结尾, 应使用 tiny_get_string_view 或先用 tiny_own_string 复制
+    assert(node != nullptr && node->type == TINY_STRING && node->s.capacity != 0);
+    return node->s.s;
+}
+
+/// @brief 把引用输入的字符串复制为节点自有的、以 '\0' 结尾的字符串, 已经自有时不变
+/// @return 以 '\0' 结尾的字符串
+const char* tiny_own_string(tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_STRING);
+    if (node->s.capacity == 0) {
+        char* s = (char*)tiny_malloc(node->s.len + 1);
+        if (node->s.len > 0) memcpy(s, node->s.s, node->s.len);
+        s[node->s.len] = '\0';
+        node->s.s = s;
+        node->s.capacity = node->s.len + 1;
+    }
+    return node->s.s;
+}
+
+/// @brief 取得字符串的内容和长度, 不复制, 返回的指针不一定以 '\0' 结尾
+const char* tiny_get_string_view(const tiny_node* node, size_t* len) {
+    assert(node != nullptr && node->type == TINY_STRING && len != nullptr);
+    *len = node->s.len;
+    return node->s.s;
+}
+
+size_t tiny_get_string_length(const tiny_node* node){
+    assert(node != nullptr && node->type == TINY_STRING);
+    return node->s.len;
+}
+
+/// @brief 设置 json 节点中的值为指定字符串
+/// @param node json 节点
+/// @param s 字符串指针
+/// @param len 字符串长度
+void tiny_set_string(tiny_node* node, const char* s, size_t len){
+    // (s != nullptr || len == 0) 的意思是当且仅当 s 指针不为空但 len 不为零时返回 false
+    assert(node != nullptr && (s != nullptr || len == 0));
+    tiny_free(node);
+    node->s.s = (char*)tiny_malloc(len + 1);  // 由于要放 '\0' 字符
+    if (len > 0) memcpy(node->s.s, s, len);  // 进行字节级别的拷贝, s 可能为空指针
+    node->s.s[len] = '\0';
+    node->s.len = len;
+    node->s.capacity = len + 1;
+    node->type = TINY_STRING;
+}
+
+/// @brief 设置为引用 s 的字符串而不复制, 调用者保证 s 在节点被修改或释放之前有效
+void tiny_set_string_view(tiny_node* node, const char* s, size_t len) {
+    assert(node != nullptr && (s != nullptr || len == 0));
+    tiny_free(node);
+    node->s.s = (char*)s;
+    node->s.len = len;
+    node->s.capacity = 0;
+    node->type = TINY_STRING;
+}
+
+/// @brief 将节点类型设置为数组，并提供初始容量
+/// @param node json 节点
+/// @param capacity 数组容量
+void tiny_set_array(tiny_node* node, size_t capacity) {
+    assert(node != nullptr);
+    tiny_free(node);
+    node->type = TINY_ARRAY;
+    node->a.size = 0;
+    node->a.capacity = capacity;
+    node->a.e = (tiny_node*)tiny_malloc(capacity * sizeof(tiny_node));
+}
+
+/// @brief 获取数组元素个数
+/// @param node 数组（json节点）
+/// @return 数组元素个数
+size_t tiny_get_array_size(const tiny_node* node) {
+    assert(node != nullptr && (node->type == TINY_ARRAY || node->type == TINY_NUMBER_ARRAY));
+    return node->type == TINY_ARRAY ? node->a.size : node->v.size;
+}
+
+size_t tiny_get_array_capacity(const tiny_node* node) {
+    assert(node != nullptr && (node->type == TINY_ARRAY || node->type == TINY_NUMBER_ARRAY));
+    return node->type == TINY_ARRAY ? node->a.capacity : node->v.size;
+}
+
+/// @brief 增大数组容量
+/// @param node json 节点
+/// @param capacity 数组容量
+void tiny_reserve_array(tiny_node* node, size_t capacity) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY);
+    if (node->a.capacity < capacity) {
+        const void* old = node->a.e;
+        tiny_cache_touch(node);
+        node->a.e = (tiny_node*)tiny_realloc(node->a.e, node->a.capacity * sizeof(tiny_node), capacity * sizeof(tiny_node));
+        node->a.capacity = capacity;
+        tiny_cache_rekey(node, old);
+    }
+}
+
+/// @brief 缩小数组容量至当前元素个数大小
+/// @param node json 节点
+void tiny_shrink_array(tiny_node* node) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY);
+    if (node->a.capacity > node->a.size) {
+        const void* old = node->a.e;
+        tiny_cache_touch(node);
+        node->a.e = (tiny_node*)tiny_realloc(node->a.e, node->a.capacity * sizeof(tiny_node), node->a.size * sizeof(tiny_node));
+        node->a.capacity = node->a.size;
+        tiny_cache_rekey(node, old);
+    }
+}
+
+/// @brief 清空数组
+/// @param node json 节点
+void tiny_clear_array(tiny_node* node) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY);
+    tiny_erase_array_element(node, 0, node->a.size);
+}
+
+/// @brief 获取数组元素
+/// @param node 数组（json节点）
+/// @param index 下标
+/// @return 对应下表数组元素; TINY_NUMBER_ARRAY 返回只读的元素视图, 数组本身不变
+tiny_node* tiny_get_array_element(const tiny_node* node, size_t index) {
+    assert(node != nullptr);
+    if (node->type == TINY_NUMBER_ARRAY) {  // 不展开, 返回只读的元素视图
+        assert(index < node->v.size);
+        return &tiny_packed_views(node)[index];
+    }
+    assert(node->type == TINY_ARRAY);
+    assert(index < node->a.size);
+    return &node->a.e[index];
+}
+
+tiny_node* tiny_pushback_array_element(tiny_node* node) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY);
+    tiny_cache_touch(node);
+    if (node->a.size == node->a.capacity) 
+        tiny_reserve_array(node, node->a.capacity == 0 ? 1 : node->a.capacity * 2);
+    tiny_init(&node->a.e[node->a.size]);
+    return &node->a.e[node->a.size++];  // 此处顺带改变了 array 中 size 的大小
+}
+
+void tiny_popback_array_element(tiny_node* node) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY && node->a.size > 0);
+    tiny_cache_touch(node);
+    tiny_free(&node->a.e[--node->a.size]);  // 此处顺带改变了 array 中 size 的大小
+}
+
+/// @brief 在数组的第 index 个腾出位置
+/// @param node json 节点
+/// @param index 插入下标
+/// @return 插入位置的节点指针
+tiny_node* tiny_insert_array_element(tiny_node* node, size_t index) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY && index <= node->a.size);
+    size_t i, size;
+    tiny_node e;  // 注意初始化两个指针在各自前面都要加 * 
+    tiny_init(&e);
+    tiny_move(tiny_pushback_array_element(node), &e);
+    size = node->a.size;
+    for (i = 0; i < node->a.size - index - 1; i++) {
+        tiny_swap(&node->a.e[size - 1 - i], &node->a.e[size - 2 - i]);
+    }
+    return &node->a.e[index];
+}
+
+void tiny_erase_array_element(tiny_node* node, size_t index, size_t count) {
+    tiny_unpack_array(node);
+    assert(node != nullptr && node->type == TINY_ARRAY && index <= node->a.size);
+    size_t i, num = std::max((size_t)0, node->a.size - index - count);
+    tiny_cache_touch(node);
+    for (i = 0; i < num; i++) {
+        tiny_swap(&node->a.e[index + i], &node->a.e[index + count + i]);
+    }
+    for (i = index + num; i < node->a.size; i++) {
+        tiny_free(&node->a.e[i]);
+    }
+    node->a.size = index + num;
+}
+
+tiny_packed_type tiny_get_number_array_type(const tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_NUMBER_ARRAY);
+    return node->v.type;
+}
+
+/// @brief 获取紧凑数字数组的数据, 元素类型须与函数名一致
+/// @param len 不为 nullptr 时返回元素个数
+const double* tiny_get_number_array(const tiny_node* node, size_t* len) {
+    assert(node != nullptr && node->type == TINY_NUMBER_ARRAY && node->v.type == TINY_PACKED_DOUBLE);
+    if (len) *len = node->v.size;
+    return (const double*)node->v.p;
+}
+
+const float* tiny_get_float_array(const tiny_node* node, size_t* len) {
+    assert(node != nullptr && node->type == TINY_NUMBER_ARRAY && node->v.type == TINY_PACKED_FLOAT);
+    if (len) *len = node->v.size;
+    return (const float*)node->v.p;
+}
+
+const int64_t* tiny_get_int64_array(const tiny_node* node, size_t* len) {
+    assert(node != nullptr && node->type == TINY_NUMBER_ARRAY && node->v.type == TINY_PACKED_INT64);
+    if (len) *len = node->v.size;
+    return (const int64_t*)node->v.p;
+}
+
+/// @brief 把节点设置为紧凑数字数组, 复制 len 个元素
+static void tiny_set_packed(tiny_node* node, tiny_packed_type type, const void* n, size_t len) {
+    size_t size = len * tiny_packed_size(type);
+    assert(node != nullptr && (n != nullptr || len == 0));
+    tiny_free(node);
+    node->v.p = tiny_packed_alloc(type, len);
+    if (size > 0) memcpy(node->v.p, n, size);
+    node->v.size = len;
+    node->v.type = type;
+    node->type = TINY_NUMBER_ARRAY;
+}
+
+void tiny_set_number_array(tiny_node* node, const double* n, size_t len) {
+    tiny_set_packed(node, TINY_PACKED_DOUBLE, n, len);
+}
+
+void tiny_set_float_array(tiny_node* node, const float* n, size_t len) {
+    tiny_set_packed(node, TINY_PACKED_FLOAT, n, len);
+}
+
+void tiny_set_int64_array(tiny_node* node, const int64_t* n, size_t len) {
+    tiny_set_packed(node, TINY_PACKED_INT64, n, len);
+}
+
+/// @brief 将节点类型设置为对象, 并提供初始容量
+/// @param node json 节点
+/// @param capacity 初始容量
+void tiny_set_object(tiny_node* node, size_t capacity) {
+    assert(node != nullptr);
+    tiny_free(node);
+    node->type = TINY_OBJECT;
+    node->o.size = 0;
+    node->o.capacity = capacity;
+    node->o.m = (tiny_member*)tiny_malloc(capacity * sizeof(tiny_member));
+}
+
+size_t tiny_get_object_size(const tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    return node->o.size;
+}
+
+size_t tiny_get_object_capacity(const tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    return node->o.capacity;
+}
+
+void tiny_reserve_object(tiny_node* node, size_t capacity) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    if (node->o.capacity < capacity) {
+        const void* old = node->o.m;
+        tiny_cache_touch(node);
+        node->o.m = (tiny_member*)tiny_realloc(node->o.m, node->o.capacity * sizeof(tiny_member), capacity * sizeof(tiny_member));
+        node->o.capacity = capacity;
+        tiny_cache_rekey(node, old);
+    }
+}
+
+void tiny_shrink_object(tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    if (node->o.capacity > node->o.size) {
+        const void* old = node->o.m;
+        tiny_cache_touch(node);
+        node->o.m = (tiny_member*)tiny_realloc(node->o.m, node->o.capacity * sizeof(tiny_member), node->o.size * sizeof(tiny_member));
+        node->o.capacity = node->o.size;
+        tiny_cache_rekey(node, old);
+    }
+}
+
+void tiny_clear_object(tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    size_t i;
+    tiny_member *curm;
+    tiny_cache_touch(node);
+    for (i = 0; i < node->o.size; i++) {
+        curm = &node->o.m[i];
+        tiny_member_free_key(curm);
+        tiny_free(&curm->value);
+    }
+    node->o.size = 0;
+}
+
+const char* tiny_get_object_key(const tiny_node* node, size_t index) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    assert(index < node->o.size);
+    return node->o.m[index].key;
+}
+
+size_t tiny_get_object_key_length(const tiny_node* node, size_t index) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    assert(index < node->o.size);
+    return node->o.m[index].keylen;
+}
+
+tiny_node* tiny_get_object_value(const tiny_node* node, size_t index) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    assert(index < node->o.size);
+    return &node->o.m[index].value;
+}
+
+/// @brief 找到 json 中指定 key 的 object 节点下标
+/// @param node json 节点
+/// @param key 给定 key
+/// @param klen key 长度
+/// @return 找到的节点下标, 没找到的话返回 size_t - 1
+size_t tiny_find_object_index(const tiny_node* node, const char* key, size_t klen) {
+    size_t i;
+    assert(node != nullptr && node->type == TINY_OBJECT && key != nullptr);
+    for (i = 0; i < node->o.size; i++) {
+        if (node->o.m[i].keylen == klen && memcmp(node->o.m[i].key, key, klen) == 0)
+            return i;
+    }
+    return TINY_KEY_NOT_EXIST;
 }
 
-/// @brief 实现对 json 节点的深度复制
-/// @param dst 目标节点 
-/// @param src 源节点
-void tiny_copy(tiny_node* dst, tiny_node* src) {
-    assert(src != nullptr && dst != nullptr && src != dst);
-    size_t i, size;
-    switch (src->type) {
-        case TINY_STRING:
-            tiny_set_string(dst, src->s.s, src->s.len);
-            break;
-        case TINY_ARRAY:
-            tiny_free(dst);
-            size = src->a.size;
-            dst->a.size = size;
-            dst->a.e = (tiny_node*)malloc(size * sizeof(tiny_node));
-            for (i = 0; i < size; i++) {
-                tiny_copy(&dst->a.e[i], &src->a.e[i]);
+/// @brief 在 json 节点中找到对应 key 值 object 的 value
+/// @param node json 节点
+/// @param key 给定 key
+/// @param klen key 长度
+/// @return object.value
+tiny_node* tiny_find_object_value(tiny_node* node, const char* key, size_t klen) {
+    size_t index = tiny_find_object_index(node, key, klen);
+    return index != TINY_KEY_NOT_EXIST ? &node->o.m[index].value : nullptr;
+}
+
+tiny_member* tiny_pushback_object_member(tiny_node* node) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    tiny_cache_touch(node);
+    if (node->o.size == node->o.capacity) 
+        tiny_reserve_object(node, node->o.capacity == 0 ? 1 : node->o.capacity * 2);
+    tiny_init(&node->o.m[node->o.size].value);
+    return &node->o.m[node->o.size++];  // 此处顺带改变了 array 中 size 的大小
+}
+
+/// @brief 为给定 json 节点设置一个 key 为指定值的 object
+/// @param node json 节点
+/// @param key 指定 key
+/// @param klen key 长度
+/// @return 设置的 object.value
+tiny_node* tiny_set_object_key(tiny_node* node, const char* key, size_t klen) {
+    assert(node != nullptr && node->type == TINY_OBJECT);
+    tiny_node* res;
+    tiny_member* m;
+    if ((res = tiny_find_object_value(node, key, klen)) != nullptr) return res;  // 若已存在此键, 则直接返回
+    m = tiny_pushback_object_member(node);
+    tiny_member_set_key(m, key, klen);
+    return &m->value;
+}
+
+/// @brief 在 object 的第 index 个位置腾出一个成员
+/// @param node json 节点
+/// @param index 插入下标
+/// @return 插入位置的成员, key 需由调用者设置
+static tiny_member* tiny_insert_object_member(tiny_node* node, size_t index) {
+    assert(node != nullptr && node->type == TINY_OBJECT && index <= node->o.size);
+    tiny_pushback_object_member(node);
+    memmove(&node->o.m[index + 1], &node->o.m[index], (node->o.size - 1 - index) * sizeof(tiny_member));
+    tiny_init(&node->o.m[index].value);
+    return &node->o.m[index];
+}
+
+/// @brief 从 object 中取出指定下标的成员, key 和值的所有权转移给 out
+/// @param node json 节点
+/// @param index 指定下标
+/// @param out 取出的成员
+static void tiny_take_object_member(tiny_node* node, size_t index, tiny_member* out) {
+    assert(node != nullptr && node->type == TINY_OBJECT && index < node->o.size);
+    tiny_cache_touch(node);
+    memcpy(out, &node->o.m[index], sizeof(tiny_member));
+    memmove(&node->o.m[index], &node->o.m[index + 1], (node->o.size - index - 1) * sizeof(tiny_member));
+    node->o.size--;
+}
+
+/// @brief 移除指定下标的对象
+/// @param node json 节点
+/// @param index 指定下标
+void tiny_remove_object(tiny_node* node, size_t index) {
+    tiny_member m;
+    tiny_take_object_member(node, index, &m);
+    tiny_member_free_key(&m);
+    tiny_free(&m.value);
+}
+
+/// @brief 按 RFC 7386 将 patch 合并进 target, patch 中的值直接移动到 target 中
+/// @param target 目标节点
+/// @param patch merge patch, 调用结束后被置为 null
+void tiny_merge_patch(tiny_node* target, tiny_node* patch) {
+    size_t i, j, k, n, extra;
+    unsigned char* state;  // 0: 未匹配, 1: 被同名 key 覆盖, 2: 已与 target 中的成员匹配
+    tiny_key_index idx;
+    assert(target != nullptr && patch != nullptr && target != patch);
+    tiny_cache_touch(target);
+    // patch 不是 object 时直接替换 target
+    if (patch->type != TINY_OBJECT) {
+        tiny_move(target, patch);
+        return;
+    }
+    if (target->type != TINY_OBJECT)
+        tiny_set_object(target, 0);
+    if ((n = patch->o.size) == 0) {
+        tiny_free(patch);
+        return;
+    }
+
+    state = (unsigned char*)memset(tiny_malloc(n), 0, n);
+    tiny_key_index_build(&idx, patch->o.m, n, state);
+
+    // 一趟遍历 target: 递归合并同名成员, 同时压缩掉值为 null 的成员
+    for (i = j = 0; i < target->o.size; i++) {
+        tiny_member* m = &target->o.m[i];
+        k = tiny_key_index_find(&idx, patch->o.m, m->key, m->keylen);
+        if (k != TINY_KEY_NOT_EXIST && state[k] == 0) {
+            state[k] = 2;
+            if (patch->o.m[k].value.type == TINY_NULL) {
+                tiny_member_free_key(m);
+                tiny_free(&m->value);
+                continue;
             }
-            dst->type = TINY_ARRAY;
+            tiny_merge_patch(&m->value, &patch->o.m[k].value);
+        }
+        if (i != j) memcpy(&target->o.m[j], m, sizeof(tiny_member));
+        j++;
+    }
+    target->o.size = j;
+
+    // 追加 target 中不存在的成员, key 和值的所有权都转移给 target
+    for (i = extra = 0; i < n; i++)
+        if (state[i] == 0 && patch->o.m[i].value.type != TINY_NULL) extra++;
+    tiny_reserve_object(target, j + extra);
+    for (i = 0; i < n; i++) {
+        tiny_member* pm = &patch->o.m[i];
+        if (state[i] != 0 || pm->value.type == TINY_NULL) continue;
+        tiny_member* m = tiny_pushback_object_member(target);
+        m->key = pm->key;
+        m->keylen = pm->keylen;
+        m->keycap = pm->keycap;
+        m->escaped = pm->escaped;
+        pm->key = pm->escaped = nullptr;
+        tiny_merge_patch(&m->value, &pm->value);  // 嵌套 object 中的 null 同样需要去掉
+    }
+
+    tiny_key_index_free(&idx);
+    tiny_dealloc(state, n);
+    tiny_free(patch);
+}
+
+/// @brief 预解析 reference token 中的数组下标
+/// @return 数组下标; "-" 返回 TINY_POINTER_END; 不是合法下标时返回 TINY_KEY_NOT_EXIST
+static size_t tiny_pointer_parse_index(const char* s, size_t len) {
+    size_t i, index = 0;
+    if (len == 1 && *s == '-') return TINY_POINTER_END;
+    if (len == 0 || (s[0] == '0' && len > 1)) return TINY_KEY_NOT_EXIST;  // 不允许前导零
+    for (i = 0; i < len; i++) {
+        if (!ISDIGIT(s[i]) || index > (TINY_POINTER_END - 10) / 10) return TINY_KEY_NOT_EXIST;
+        index = index * 10 + (s[i] - '0');
+    }
+    return index;
+}
+
+/// @brief 释放编译好的 JSON Pointer
+void tiny_pointer_free(tiny_pointer* ptr) {
+    for (size_t i = 0; i < ptr->size; i++) tiny_dealloc(ptr->t[i].s, ptr->t[i].len + 1);
+    tiny_dealloc(ptr->t, ptr->capacity * sizeof(tiny_pointer_token));
+    ptr->t = nullptr;
+    ptr->size = ptr->capacity = 0;
+}
+
+/// @brief 编译 JSON Pointer 字符串, 切分并反转义每个 reference token, 同时预解析数组下标
+/// @param ptr 编译结果, 用 tiny_pointer_free 释放
+/// @param s pointer 字符串
+/// @param len 字符串长度
+/// @return TINY_PATCH_OK 或 TINY_PATCH_INVALID_POINTER
+int tiny_pointer_compile(tiny_pointer* ptr, const char* s, size_t len) {
+    const char* end = s + len;
+    size_t n = 0;
+    ptr->t = nullptr;
+    ptr->size = ptr->capacity = 0;
+    if (len == 0) return TINY_PATCH_OK;  // "" 表示整个文档
+    if (*s != '/') return TINY_PATCH_INVALID_POINTER;
+    for (const char* p = s; p < end; p++) if (*p == '/') n++;
+    ptr->t = (tiny_pointer_token*)tiny_malloc(n * sizeof(tiny_pointer_token));
+    ptr->capacity = n;
+    while (s < end) {
+        const char* p = ++s;  // 跳过 '/'
+        size_t escapes = 0;
+        for (; p < end && *p != '/'; p++) if (*p == '~') escapes++;
+        tiny_pointer_token* t = &ptr->t[ptr->size++];
+        t->len = p - s - escapes;  // 每个 "~0" 或 "~1" 反转义后少一个字符
+        char* d = t->s = (char*)tiny_malloc(t->len + 1);
+        for (; s < p; s++) {
+            if (*s != '~') *d++ = *s;
+            else if (s + 1 < p && (s[1] == '0' || s[1] == '1')) *d++ = *++s == '0' ? '~' : '/';
+            else {
+                tiny_pointer_free(ptr);
+                return TINY_PATCH_INVALID_POINTER;  // '~' 后只能是 '0' 或 '1'
+            }
+        }
+        *d = '\0';
+        t->index = tiny_pointer_parse_index(t->s, t->len);
+    }
+    return TINY_PATCH_OK;
+}
+
+/// @brief 判断 a 是否为 b 的真前缀
+static int tiny_pointer_is_prefix(const tiny_pointer* a, const tiny_pointer* b) {
+    if (a->size >= b->size) return 0;
+    for (size_t i = 0; i < a->size; i++) {
+        if (a->t[i].len != b->t[i].len || memcmp(a->t[i].s, b->t[i].s, a->t[i].len) != 0) return 0;
+    }
+    return 1;
+}
+
+/// @brief 沿着前 n 个 token 找到对应的节点
+/// @tparam ReadOnly 为 true 时不展开途经的紧凑数组, 其元素返回只读视图, 供只读查找使用
+/// @return 找到的节点, 路径不存在时返回 nullptr
+template <bool ReadOnly = false>
+static tiny_node* tiny_pointer_resolve(tiny_node* node, const tiny_pointer_token* t, size_t n) {
+    size_t index;
+    for (; n > 0; n--, t++) {
+        if (!ReadOnly) tiny_unpack_array(node);
+        else if (node->type == TINY_NUMBER_ARRAY) {
+            if (t->index >= node->v.size) return nullptr;
+            node = &tiny_packed_views(node)[t->index];
+            continue;
+        }
+        if (node->type == TINY_OBJECT) {
+            if ((index = tiny_find_object_index(node, t->s, t->len)) == TINY_KEY_NOT_EXIST) return nullptr;
+            node = &node->o.m[index].value;
+        }
+        else if (node->type == TINY_ARRAY && t->index < node->a.size)
+            node = &node->a.e[t->index];
+        else return nullptr;
+    }
+    return node;
+}
+
+/// @brief 按编译好的 JSON Pointer 查找节点, 不修改文档; 紧凑数组的元素与 tiny_get_array_element 一样返回只读视图
+/// @return 找到的节点, 路径不存在时返回 nullptr
+tiny_node* tiny_pointer_get(const tiny_node* node, const tiny_pointer* ptr) {
+    assert(node != nullptr && ptr != nullptr);
+    return tiny_pointer_resolve<true>(const_cast<tiny_node*>(node), ptr->t, ptr->size);
+}
+
+/// @brief 按编译好的 JSON Pointer 找到要设置的节点, 与 tiny_set_object_key 一样由调用者设置其值
+/// 最后一个 token 指向 object 中不存在的 key 时添加该成员; 为 "-" 或等于数组长度时在数组末尾添加元素
+/// @return 要设置的节点, 父节点不存在时返回 nullptr
+tiny_node* tiny_pointer_set(tiny_node* node, const tiny_pointer* ptr) {
+    const tiny_pointer_token* last;
+    tiny_node* parent;
+    assert(node != nullptr && ptr != nullptr);
+    if (ptr->size == 0) return node;
+    if ((parent = tiny_pointer_resolve(node, ptr->t, ptr->size - 1)) == nullptr) return nullptr;
+    last = &ptr->t[ptr->size - 1];
+    tiny_unpack_array(parent);
+    if (parent->type == TINY_OBJECT) return tiny_set_object_key(parent, last->s, last->len);
+    if (parent->type != TINY_ARRAY) return nullptr;
+    if (last->index < parent->a.size) return &parent->a.e[last->index];
+    if (last->index == TINY_POINTER_END || last->index == parent->a.size) return tiny_pushback_array_element(parent);
+    return nullptr;
+}
+
+/// @brief 比较两个 reference token 的字典序
+static int tiny_pointer_token_compare(const tiny_pointer_token* a, const tiny_pointer_token* b) {
+    int r = memcmp(a->s, b->s, a->len < b->len ? a->len : b->len);
+    return r != 0 ? r : (a->len > b->len) - (a->len < b->len);
+}
+
+/// @brief 批量查找多个编译好的 JSON Pointer
+/// 先按 token 序列排序, 使前缀相同的 pointer 相邻, 公共前缀只沿树走一遍
+/// @param node 根节点
+/// @param ptrs pointer 数组
+/// @param n pointer 个数
+/// @param out 按 ptrs 的顺序存放查找结果, 路径不存在的为 nullptr
+/// @return 找到的个数
+size_t tiny_pointer_get_batch(const tiny_node* node, const tiny_pointer* ptrs, size_t n, tiny_node** out) {
+    size_t i, k, depth = 0, valid = 0, found = 0, *order;
+    const tiny_pointer* prev = nullptr;
+    tiny_node** path;
+    assert(node != nullptr && (n == 0 || (ptrs != nullptr && out != nullptr)));
+    if (n == 0) return 0;
+    for (i = 0; i < n; i++) if (ptrs[i].size > depth) depth = ptrs[i].size;
+    order = (size_t*)tiny_malloc(n * sizeof(size_t));
+    path = (tiny_node**)tiny_malloc((depth + 1) * sizeof(tiny_node*));
+    for (i = 0; i < n; i++) order[i] = i;
+    std::sort(order, order + n, [ptrs](size_t a, size_t b) {
+        const tiny_pointer *x = &ptrs[a], *y = &ptrs[b];
+        for (size_t j = 0; j < x->size && j < y->size; j++) {
+            int r = tiny_pointer_token_compare(&x->t[j], &y->t[j]);
+            if (r != 0) return r < 0;
+        }
+        return x->size < y->size;
+    });
+    // path[0..valid] 是上一个 pointer 沿途成功解析的节点
+    path[0] = const_cast<tiny_node*>(node);
+    for (i = 0; i < n; i++) {
+        const tiny_pointer* ptr = &ptrs[order[i]];
+        k = 0;
+        if (prev != nullptr) {
+            while (k < prev->size && k < ptr->size && tiny_pointer_token_compare(&prev->t[k], &ptr->t[k]) == 0) k++;
+        }
+        prev = ptr;
+        if (k > valid) {
+            out[order[i]] = nullptr;  // 公共前缀中已有 token 解析失败
+            continue;
+        }
+        for (valid = k; valid < ptr->size; valid++) {
+            if ((path[valid + 1] = tiny_pointer_resolve<true>(path[valid], &ptr->t[valid], 1)) == nullptr) break;
+        }
+        out[order[i]] = valid == ptr->size ? path[valid] : nullptr;
+        if (out[order[i]] != nullptr) found++;
+    }
+    tiny_dealloc(path, (depth + 1) * sizeof(tiny_node*));
+    tiny_dealloc(order, n * sizeof(size_t));
+    return found;
+}
+
+/// @brief 撤销记录的类型
+typedef enum {
+    TINY_UNDO_RESTORE,  // 把 path 处的值换回旧值
+    TINY_UNDO_ERASE,    // 删除父节点中第 index 个成员或元素
+    TINY_UNDO_INSERT,   // 把移出的成员或元素插回父节点的第 index 个位置
+} tiny_undo_type;
+
+/// @brief 撤销记录, 压入 tiny_context 的栈中, 按相反顺序执行即可回滚
+typedef struct {
+    tiny_undo_type type;
+    int carry;                 // 为 1 时插回的值取自上一条撤销记录移出的值 (move 操作)
+    const tiny_pointer* path;  // RESTORE 使用完整路径, ERASE 和 INSERT 使用其父路径
+    size_t index;
+    tiny_member m;             // 移出的 key (仅 object) 和值
+} tiny_patch_undo;
+
+static tiny_patch_undo* tiny_patch_log(tiny_context* c, tiny_undo_type type, const tiny_pointer* path, size_t index) {
+    tiny_patch_undo* u = (tiny_patch_undo*)tiny_context_push(c, sizeof(tiny_patch_undo));
+    u->type = type;
+    u->carry = 0;
+    u->path = path;
+    u->index = index;
+    u->m.key = u->m.escaped = nullptr;
+    u->m.keylen = u->m.keycap = 0;
+    tiny_init(&u->m.value);
+    return u;
+}
+
+/// @brief 执行一条撤销记录, 从文档中移出的值放入 carry
+static void tiny_patch_undo_apply(tiny_node* root, tiny_patch_undo* u, tiny_node* carry) {
+    tiny_node *node, *v;
+    tiny_member m;
+    if (u->type == TINY_UNDO_RESTORE) {
+        node = tiny_pointer_resolve(root, u->path->t, u->path->size);
+        assert(node != nullptr);
+        tiny_move(carry, node);
+        tiny_move(node, &u->m.value);
+        return;
+    }
+    node = tiny_pointer_resolve(root, u->path->t, u->path->size - 1);
+    assert(node != nullptr);
+    if (u->type == TINY_UNDO_ERASE) {
+        if (node->type == TINY_OBJECT) {
+            tiny_take_object_member(node, u->index, &m);
+            tiny_member_free_key(&m);
+            tiny_move(carry, &m.value);
+        }
+        else {
+            tiny_move(carry, &node->a.e[u->index]);
+            tiny_erase_array_element(node, u->index, 1);
+        }
+    }
+    else {
+        v = u->carry ? carry : &u->m.value;
+        if (node->type == TINY_OBJECT) {
+            tiny_member* pm = tiny_insert_object_member(node, u->index);
+            pm->key = u->m.key;
+            pm->keylen = u->m.keylen;
+            pm->keycap = u->m.keycap;
+            pm->escaped = u->m.escaped;
+            u->m.key = u->m.escaped = nullptr;
+            tiny_move(&pm->value, v);
+        }
+        else tiny_move(tiny_insert_array_element(node, u->index), v);
+    }
+}
+
+/// @brief 把 value 添加到 path 处, value 被移动进文档
+static int tiny_patch_add(tiny_context* c, tiny_node* root, const tiny_pointer* path, tiny_node* value) {
+    const tiny_pointer_token* last;
+    tiny_node *parent, *target;
+    size_t index;
+    if (path->size == 0) {
+        target = root;  // 替换整个文档
+    }
+    else {
+        if ((parent = tiny_pointer_resolve(root, path->t, path->size - 1)) == nullptr)
+            return TINY_PATCH_PATH_NOT_FOUND;
+        last = &path->t[path->size - 1];
+        tiny_unpack_array(parent);
+        if (parent->type == TINY_ARRAY) {
+            index = last->index == TINY_POINTER_END ? parent->a.size : last->index;
+            if (index > parent->a.size) return TINY_PATCH_PATH_NOT_FOUND;
+            tiny_move(tiny_insert_array_element(parent, index), value);
+            tiny_patch_log(c, TINY_UNDO_ERASE, path, index);
+            return TINY_PATCH_OK;
+        }
+        if (parent->type != TINY_OBJECT) return TINY_PATCH_PATH_NOT_FOUND;
+        if ((index = tiny_find_object_index(parent, last->s, last->len)) == TINY_KEY_NOT_EXIST) {
+            tiny_member* m = tiny_pushback_object_member(parent);
+            tiny_member_set_key(m, last->s, last->len);
+            tiny_move(&m->value, value);
+            tiny_patch_log(c, TINY_UNDO_ERASE, path, parent->o.size - 1);
+            return TINY_PATCH_OK;
+        }
+        target = &parent->o.m[index].value;  // key 已存在时替换其值
+    }
+    tiny_move(&tiny_patch_log(c, TINY_UNDO_RESTORE, path, 0)->m.value, target);
+    tiny_move(target, value);
+    return TINY_PATCH_OK;
+}
+
+/// @brief 移除 path 处的值
+/// @param out 非空时被移除的值移动到 out 中 (move 操作), 否则保存在撤销记录中
+static int tiny_patch_remove(tiny_context* c, tiny_node* root, const tiny_pointer* path, tiny_node* out) {
+    const tiny_pointer_token* last;
+    tiny_node* parent;
+    tiny_patch_undo* u;
+    size_t index;
+    if (path->size == 0 || (parent = tiny_pointer_resolve(root, path->t, path->size - 1)) == nullptr)
+        return TINY_PATCH_PATH_NOT_FOUND;
+    last = &path->t[path->size - 1];
+    tiny_unpack_array(parent);
+    if (parent->type == TINY_OBJECT) {
+        if ((index = tiny_find_object_index(parent, last->s, last->len)) == TINY_KEY_NOT_EXIST)
+            return TINY_PATCH_PATH_NOT_FOUND;
+        u = tiny_patch_log(c, TINY_UNDO_INSERT, path, index);
+        tiny_take_object_member(parent, index, &u->m);
+    }
+    else if (parent->type == TINY_ARRAY && last->index < parent->a.size) {
+        index = last->index;
+        u = tiny_patch_log(c, TINY_UNDO_INSERT, path, index);
+        tiny_move(&u->m.value, &parent->a.e[index]);
+        tiny_erase_array_element(parent, index, 1);
+    }
+    else return TINY_PATCH_PATH_NOT_FOUND;
+    if (out) {
+        tiny_move(out, &u->m.value);
+        u->carry = 1;
+    }
+    return TINY_PATCH_OK;
+}
+
+static int tiny_patch_apply_op(tiny_context* c, tiny_node* root, const tiny_patch_op* op) {
+    tiny_node temp, *node;
+    int ret;
+    tiny_init(&temp);
+    switch (op->op) {
+        case TINY_PATCH_ADD:
+            tiny_copy(&temp, &op->value);
+            ret = tiny_patch_add(c, root, &op->path, &temp);
             break;
-        case TINY_OBJECT:
-            tiny_free(dst);
-            size = src->o.size;
-            dst->o.size = size;
-            dst->o.m = (tiny_member*)malloc(size * sizeof(tiny_member));
-            for (i = 0; i < size; i++) {
-                size_t klen = src->o.m[i].keylen;
-                memcpy(dst->o.m[i].key = (char*)malloc(klen + 1), src->o.m[i].key, klen);
-                dst->o.m[i].key[klen] = '\0';
-                tiny_copy(&dst->o.m[i].value, &src->o.m[i].value);
+        case TINY_PATCH_REMOVE:
+            return tiny_patch_remove(c, root, &op->path, nullptr);
+        case TINY_PATCH_REPLACE:
+            if ((node = tiny_pointer_resolve(root, op->path.t, op->path.size)) == nullptr)
+                return TINY_PATCH_PATH_NOT_FOUND;
+            tiny_move(&tiny_patch_log(c, TINY_UNDO_RESTORE, &op->path, 0)->m.value, node);
+            tiny_copy(node, &op->value);
+            return TINY_PATCH_OK;
+        case TINY_PATCH_MOVE:
+            if ((node = tiny_pointer_resolve(root, op->from.t, op->from.size)) == nullptr)
+                return TINY_PATCH_PATH_NOT_FOUND;
+            if (node == tiny_pointer_resolve(root, op->path.t, op->path.size))
+                return TINY_PATCH_OK;  // from 和 path 相同时什么也不用做
+            if ((ret = tiny_patch_remove(c, root, &op->from, &temp)) != TINY_PATCH_OK) return ret;
+            if ((ret = tiny_patch_add(c, root, &op->path, &temp)) != TINY_PATCH_OK) {
+                // 添加失败时, 把移出的值交还给 remove 的撤销记录
+                tiny_patch_undo* u = (tiny_patch_undo*)(c->stack + c->top) - 1;
+                tiny_move(&u->m.value, &temp);
+                u->carry = 0;
             }
-            dst->type = TINY_OBJECT;
             break;
-        default:
-            tiny_free(dst);
-            memcpy(dst, src, sizeof(tiny_node));
+        case TINY_PATCH_COPY:
+            if ((node = tiny_pointer_resolve(root, op->from.t, op->from.size)) == nullptr)
+                return TINY_PATCH_PATH_NOT_FOUND;
+            tiny_copy(&temp, node);
+            ret = tiny_patch_add(c, root, &op->path, &temp);
             break;
+        case TINY_PATCH_TEST:
+            if ((node = tiny_pointer_resolve(root, op->path.t, op->path.size)) == nullptr)
+                return TINY_PATCH_PATH_NOT_FOUND;
+            return tiny_is_equal(node, &op->value) ? TINY_PATCH_OK : TINY_PATCH_TEST_FAILED;
+        default: assert(0 && "invalid patch operation"); return TINY_PATCH_INVALID_OPERATION;
     }
+    tiny_free(&temp);
+    return ret;
 }
 
-void tiny_move(tiny_node* dst, tiny_node* src) {
-    assert(dst != nullptr && src != nullptr && src != dst);
-    tiny_free(dst);
-    memcpy(dst, src, sizeof(tiny_node));
-    tiny_init(src);
+/// @brief 对文档应用编译好的 patch, 任一操作失败时回滚全部修改
+/// @param patch 编译好的 patch
+/// @param node 文档
+/// @return 状态码
+int tiny_patch_apply(const tiny_patch* patch, tiny_node* node) {
+    tiny_context c;
+    tiny_node carry;
+    int ret = TINY_PATCH_OK;
+    assert(patch != nullptr && node != nullptr);
+    c.stack = nullptr;
+    c.size = c.top = 0;
+    c.sink = nullptr;
+    c.gather = nullptr;
+    for (size_t i = 0; i < patch->size && ret == TINY_PATCH_OK; i++)
+        ret = tiny_patch_apply_op(&c, node, &patch->ops[i]);
+    // 成功时丢弃撤销记录, 失败时按相反顺序回滚
+    tiny_init(&carry);
+    while (c.top > 0) {
+        tiny_patch_undo* u = (tiny_patch_undo*)tiny_context_pop(&c, sizeof(tiny_patch_undo));
+        if (ret != TINY_PATCH_OK) tiny_patch_undo_apply(node, u, &carry);
+        tiny_member_free_key(&u->m);
+        tiny_free(&u->m.value);
+    }
+    tiny_free(&carry);
+    tiny_dealloc(c.stack, c.size);
+    return ret;
 }
 
-void tiny_swap(tiny_node* lhs, tiny_node* rhs) {
-    assert(lhs != nullptr && rhs != nullptr);
-    if (lhs != rhs) {
-        tiny_node temp;
-        memcpy(&temp, lhs, sizeof(tiny_node));
-        memcpy(lhs,   rhs, sizeof(tiny_node));
-        memcpy(rhs, &temp, sizeof(tiny_node));
+static void tiny_patch_op_free(tiny_patch_op* op) {
+    tiny_pointer_free(&op->path);
+    tiny_pointer_free(&op->from);
+    tiny_free(&op->value);
+}
+
+/// @brief 取出 object 中指定 key 的值
+static const tiny_node* tiny_patch_member(const tiny_node* node, const char* key) {
+    size_t index = tiny_find_object_index(node, key, strlen(key));
+    return index != TINY_KEY_NOT_EXIST ? &node->o.m[index].value : nullptr;
+}
+
+static int tiny_patch_compile_op(tiny_patch_op* op, const tiny_node* e) {
+    static const char* names[] = { "add", "remove", "replace", "move", "copy", "test" };
+    const tiny_node* v;
+    int i, ret;
+    op->path.t = op->from.t = nullptr;
+    op->path.size = op->from.size = 0;
+    op->path.capacity = op->from.capacity = 0;
+    tiny_init(&op->value);
+    if (e->type != TINY_OBJECT) return TINY_PATCH_INVALID_OPERATION;
+    if ((v = tiny_patch_member(e, "op")) == nullptr || v->type != TINY_STRING) return TINY_PATCH_INVALID_OPERATION;
+    for (i = 0; i < 6 && !(strlen(names[i]) == v->s.len && memcmp(names[i], v->s.s, v->s.len) == 0); i++);
+    if (i == 6) return TINY_PATCH_INVALID_OPERATION;
+    op->op = (tiny_patch_op_type)i;
+
+    if ((v = tiny_patch_member(e, "path")) == nullptr || v->type != TINY_STRING) return TINY_PATCH_INVALID_OPERATION;
+    if ((ret = tiny_pointer_compile(&op->path, v->s.s, v->s.len)) != TINY_PATCH_OK) return ret;
+    if (op->op == TINY_PATCH_MOVE || op->op == TINY_PATCH_COPY) {
+        if ((v = tiny_patch_member(e, "from")) == nullptr || v->type != TINY_STRING) return TINY_PATCH_INVALID_OPERATION;
+        if ((ret = tiny_pointer_compile(&op->from, v->s.s, v->s.len)) != TINY_PATCH_OK) return ret;
+        // 不能把一个值移动到它自己的子节点中
+        if (op->op == TINY_PATCH_MOVE && tiny_pointer_is_prefix(&op->from, &op->path)) return TINY_PATCH_INVALID_OPERATION;
     }
+    if (op->op == TINY_PATCH_ADD || op->op == TINY_PATCH_REPLACE || op->op == TINY_PATCH_TEST) {
+        if ((v = tiny_patch_member(e, "value")) == nullptr) return TINY_PATCH_INVALID_OPERATION;
+        tiny_copy(&op->value, v);
+    }
+    return TINY_PATCH_OK;
 }
 
-void tiny_free(tiny_node* node) {
-    size_t i;
-    assert(node != nullptr);
+/// @brief 编译 JSON Patch 文档, 预先切分路径并解析数组下标, 编译结果可反复应用
+/// @param patch 编译结果
+/// @param doc 已解析的 JSON Patch 文档 (操作数组)
+/// @return 状态码
+int tiny_patch_compile(tiny_patch* patch, const tiny_node* doc) {
+    int ret;
+    assert(patch != nullptr && doc != nullptr);
+    patch->ops = nullptr;
+    patch->size = patch->capacity = 0;
+    if (doc->type != TINY_ARRAY) return TINY_PATCH_INVALID_OPERATION;
+    patch->ops = (tiny_patch_op*)tiny_malloc(doc->a.size * sizeof(tiny_patch_op));
+    patch->capacity = doc->a.size;
+    for (size_t i = 0; i < doc->a.size; i++) {
+        if ((ret = tiny_patch_compile_op(&patch->ops[i], &doc->a.e[i])) != TINY_PATCH_OK) {
+            tiny_patch_op_free(&patch->ops[i]);
+            tiny_patch_free(patch);
+            return ret;
+        }
+        patch->size++;
+    }
+    return TINY_PATCH_OK;
+}
+
+void tiny_patch_free(tiny_patch* patch) {
+    assert(patch != nullptr);
+    for (size_t i = 0; i < patch->size; i++) tiny_patch_op_free(&patch->ops[i]);
+    tiny_dealloc(patch->ops, patch->capacity * sizeof(tiny_patch_op));
+    patch->ops = nullptr;
+    patch->size = patch->capacity = 0;
+}
+
+// 数组中间不同部分的元素个数乘积超过此值时, 不再使用 LCS 而按位置逐个比较
+#ifndef TINY_DIFF_LCS_LIMIT
+#define TINY_DIFF_LCS_LIMIT (1 << 20)
+#endif
+
+/// @brief 子树的结构哈希, 按先序遍历的顺序平铺存放
+typedef struct {
+    unsigned long long hash;
+    size_t count;  // 子树中的节点个数 (包括自身), 用于跳到下一个兄弟节点
+} tiny_diff_info;
+
+static size_t tiny_diff_count(const tiny_node* node) {
+    size_t i, count = 1;
+    if (node->type == TINY_ARRAY)
+        for (i = 0; i < node->a.size; i++) count += tiny_diff_count(&node->a.e[i]);
+    else if (node->type == TINY_OBJECT)
+        for (i = 0; i < node->o.size; i++) count += tiny_diff_count(&node->o.m[i].value);
+    return count;
+}
+
+static unsigned long long tiny_diff_mix(unsigned long long h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+/// @brief 计算子树的结构哈希, 与 tiny_is_equal 一致: -0 与 0 相等, object 与成员顺序无关
+/// @return 子树中的节点个数
+static size_t tiny_diff_hash(const tiny_node* node, tiny_diff_info* info) {
+    unsigned long long h = (unsigned long long)node->type * 0x9e3779b97f4a7c15ull;
+    size_t i, count = 1;
     switch (node->type) {
+        case TINY_NUMBER: {
+            double d = tiny_number_value(node);
+            if (d != 0.0) {
+                unsigned long long bits;
+                memcpy(&bits, &d, sizeof(bits));
+                h ^= bits;
+            }
+            break;
+        }
+        case TINY_DECIMAL:
+            h ^= tiny_hash_key(node->x.s, node->x.len) ^ ((unsigned long long)(unsigned)node->x.exp << 1 | node->x.neg);
+            break;
         case TINY_STRING:
-            free(node->s.s);
+            h ^= tiny_hash_key(node->s.s, node->s.len);
             break;
         case TINY_ARRAY:
-            // 先释放每个 ele 开辟的空间
             for (i = 0; i < node->a.size; i++) {
-                tiny_free(&node->a.e[i]);
+                tiny_diff_info* child = info + count;
+                count += tiny_diff_hash(&node->a.e[i], child);
+                h = (h ^ child->hash) * 1099511628211ull;
             }
-            free(node->a.e);  // 最后释放自己开辟的空间
             break;
         case TINY_OBJECT:
             for (i = 0; i < node->o.size; i++) {
-                free(node->o.m[i].key);
-                tiny_free(&node->o.m[i].value);
+                tiny_diff_info* child = info + count;
+                count += tiny_diff_hash(&node->o.m[i].value, child);
+                h += tiny_diff_mix(tiny_hash_key(node->o.m[i].key, node->o.m[i].keylen) ^ child->hash);
+            }
+            break;
+        case TINY_NUMBER_ARRAY:
+            // 与内容相同的普通数组哈希值相同, 但整体作为一个节点, 比较时只会整体替换
+            h = (unsigned long long)TINY_ARRAY * 0x9e3779b97f4a7c15ull;
+            for (i = 0; i < node->v.size; i++) {
+                unsigned long long e = (unsigned long long)TINY_NUMBER * 0x9e3779b97f4a7c15ull, bits;
+                double d = tiny_packed_at(node, i);
+                if (d != 0.0) {
+                    memcpy(&bits, &d, sizeof(bits));
+                    e ^= bits;
+                }
+                h = (h ^ tiny_diff_mix(e)) * 1099511628211ull;
             }
-            free(node->o.m);
             break;
         default: break;
     }
-    node->type = TINY_NULL;
+    info->hash = tiny_diff_mix(h);
+    info->count = count;
+    return count;
 }
 
-tiny_type tiny_get_type(const tiny_node* node){
-    assert(node != nullptr);  // 先判断是否为空指针
-    return node->type;
-}
+typedef struct {
+    tiny_context path;  // 当前位置的 JSON Pointer
+    tiny_node* patch;   // 输出的操作数组
+} tiny_diff_context;
 
-int tiny_is_equal(const tiny_node* lhs, const tiny_node* rhs) {
-    size_t i;
-    assert(lhs != nullptr && rhs != nullptr);
-    if (lhs->type != rhs->type) return 0;
-    switch (lhs->type) {
-        case TINY_STRING:
-            return (lhs->s.len == rhs->s.len) && (memcpy(lhs->s.s, rhs->s.s, lhs->s.len) == 0);
-        case TINY_NUMBER:
-            return lhs->n == rhs->n;
-        case TINY_ARRAY:
-            if (lhs->a.size != rhs->a.size) return 0;
-            for (i = 0; i < lhs->a.size; i++) {
-                if (!tiny_is_equal(&lhs->a.e[i], &rhs->a.e[i])) return 0;
-            }
-            return 1;
-        case TINY_OBJECT:
-            if (lhs->o.size != rhs->o.size) return 0;
-            for (i = 0; i < lhs->o.size; i++) {
-                if ((lhs->o.m[i].keylen != rhs->o.m[i].keylen) || 
-                    (memcpy(lhs->o.m[i].key, rhs->o.m[i].key, lhs->o.m[i].keylen) != 0)) 
-                    return 0;
-                if (!tiny_is_equal(&lhs->o.m[i].value, &rhs->o.m[i].value)) return 0;
-            }
-            return 1;
-        default: return 1;
+/// @brief 在当前路径后追加一个 object key, 按 RFC 6901 转义 '~' 和 '/'
+/// @return 追加前的路径长度, 用于恢复
+static size_t tiny_diff_push_key(tiny_context* c, const char* key, size_t len) {
+    size_t head = c->top;
+    PUTC(c, '/');
+    for (size_t i = 0; i < len; i++) {
+        if      (key[i] == '~') PUTS(c, "~0", 2);
+        else if (key[i] == '/') PUTS(c, "~1", 2);
+        else PUTC(c, key[i]);
     }
+    return head;
 }
 
-int tiny_get_boolean(const tiny_node* node){
-    assert(node != nullptr && (node->type == TINY_FALSE || node->type == TINY_TRUE));
-    return node->type == TINY_TRUE;  // 巧妙！
+/// @brief 在当前路径后追加一个数组下标
+/// @return 追加前的路径长度, 用于恢复
+static size_t tiny_diff_push_index(tiny_context* c, size_t index) {
+    char buffer[24], *p = buffer + sizeof(buffer);
+    size_t head = c->top;
+    do { *--p = '0' + index % 10; } while (index /= 10);
+    *--p = '/';
+    PUTS(c, p, buffer + sizeof(buffer) - p);
+    return head;
 }
 
-void tiny_set_boolean(tiny_node* node, int b){
-    assert(node != nullptr);
-    tiny_free(node);
-    node->type = b ? TINY_TRUE : TINY_FALSE;  // 巧妙！
+/// @brief 向 patch 中追加一个操作, path 为当前路径
+static void tiny_diff_emit(tiny_diff_context* d, const char* op, const tiny_node* value) {
+    tiny_node* o = tiny_pushback_array_element(d->patch);
+    tiny_set_object(o, value ? 3 : 2);
+    tiny_set_string(tiny_set_object_key(o, "op", 2), op, strlen(op));
+    tiny_set_string(tiny_set_object_key(o, "path", 4), d->path.stack, d->path.top);
+    if (value) tiny_copy(tiny_set_object_key(o, "value", 5), value);
 }
 
-double tiny_get_number(const tiny_node* node){
-    assert(node != nullptr && node->type == TINY_NUMBER);
-    return node->n;
+static void tiny_diff_value(tiny_diff_context* d, const tiny_node* a, const tiny_diff_info* ai, 
+    const tiny_node* b, const tiny_diff_info* bi);
+
+/// @brief 收集每个子节点的哈希信息, 便于随机访问
+static const tiny_diff_info** tiny_diff_children(const tiny_diff_info* info, size_t n) {
+    const tiny_diff_info** children = (const tiny_diff_info**)tiny_malloc(n * sizeof(tiny_diff_info*));
+    for (size_t i = 0, offset = 1; i < n; offset += info[offset].count, i++)
+        children[i] = info + offset;
+    return children;
 }
 
-void tiny_set_number(tiny_node* node, double n){
-    assert(node != nullptr);
-    tiny_free(node);
-    node->n = n;
-    node->type = TINY_NUMBER;
+static void tiny_diff_object(tiny_diff_context* d, const tiny_node* a, const tiny_diff_info* ai,
+    const tiny_node* b, const tiny_diff_info* bi) {
+    size_t i, j, head, m = b->o.size;
+    const tiny_diff_info *child = ai + 1, **bc = tiny_diff_children(bi, m);
+    unsigned char* state = (unsigned char*)tiny_malloc(m);  // 0: 未匹配, 1: 被同名 key 覆盖, 2: 已匹配
+    tiny_key_index idx;
+    if (m > 0) memset(state, 0, m);
+    // 用 b 的 key 建立哈希索引, 代替逐个位置比较
+    tiny_key_index_build(&idx, b->o.m, m, state);
+    for (i = 0; i < a->o.size; child += child->count, i++) {
+        const tiny_member* am = &a->o.m[i];
+        head = tiny_diff_push_key(&d->path, am->key, am->keylen);
+        if ((j = tiny_key_index_find(&idx, b->o.m, am->key, am->keylen)) == TINY_KEY_NOT_EXIST)
+            tiny_diff_emit(d, "remove", nullptr);
+        else {
+            state[j] = 2;
+            tiny_diff_value(d, &am->value, child, &b->o.m[j].value, bc[j]);
+        }
+        d->path.top = head;
+    }
+    for (j = 0; j < m; j++) {
+        if (state[j] != 0) continue;
+        head = tiny_diff_push_key(&d->path, b->o.m[j].key, b->o.m[j].keylen);
+        tiny_diff_emit(d, "add", &b->o.m[j].value);
+        d->path.top = head;
+    }
+    tiny_key_index_free(&idx);
+    tiny_dealloc(state, m);
+    tiny_dealloc(bc, m * sizeof(tiny_diff_info*));
+}
+
+/// @brief 处理两个匹配元素之间的一段差异: 先两两递归比较, 再删除或添加多出的元素
+/// @param pos 当前数组中的位置, 随操作向后移动
+static void tiny_diff_array_run(tiny_diff_context* d, const tiny_node* a, const tiny_diff_info** ac, size_t ia, size_t ib,
+    const tiny_node* b, const tiny_diff_info** bc, size_t ja, size_t jb, size_t* pos) {
+    size_t t, head, k = std::min(ib - ia, jb - ja);
+    for (t = 0; t < k; t++) {
+        head = tiny_diff_push_index(&d->path, (*pos)++);
+        tiny_diff_value(d, &a->a.e[ia + t], ac[ia + t], &b->a.e[ja + t], bc[ja + t]);
+        d->path.top = head;
+    }
+    for (t = ia + k; t < ib; t++) {
+        head = tiny_diff_push_index(&d->path, *pos);
+        tiny_diff_emit(d, "remove", nullptr);
+        d->path.top = head;
+    }
+    for (t = ja + k; t < jb; t++) {
+        head = tiny_diff_push_index(&d->path, (*pos)++);
+        tiny_diff_emit(d, "add", &b->a.e[t]);
+        d->path.top = head;
+    }
+}
+
+static void tiny_diff_array(tiny_diff_context* d, const tiny_node* a, const tiny_diff_info* ai,
+    const tiny_node* b, const tiny_diff_info* bi) {
+    size_t i, j, ia, ja, n = a->a.size, m = b->a.size, pre = 0, suf = 0, pos = 0;
+    const tiny_diff_info **ac = tiny_diff_children(ai, n), **bc = tiny_diff_children(bi, m);
+    // 跳过相同的前缀和后缀
+    while (pre < n && pre < m && ac[pre]->hash == bc[pre]->hash) pre++;
+    while (suf < n - pre && suf < m - pre && ac[n - 1 - suf]->hash == bc[m - 1 - suf]->hash) suf++;
+    tiny_diff_array_run(d, a, ac, 0, pre, b, bc, 0, pre, &pos);  // 哈希碰撞时仍能得到正确结果
+    size_t n2 = n - pre - suf, m2 = m - pre - suf;
+    if (n2 > 0 && m2 > 0 && n2 + 1 <= TINY_DIFF_LCS_LIMIT / (m2 + 1)) {
+        // L[i][j] 为 a[pre + i..] 与 b[pre + j..] 的最长公共子序列长度
+        size_t w = m2 + 1;
+        unsigned* L = (unsigned*)tiny_malloc((n2 + 1) * w * sizeof(unsigned));
+        for (j = 0; j <= m2; j++) L[n2 * w + j] = 0;
+        for (i = n2; i-- > 0;) {
+            L[i * w + m2] = 0;
+            for (j = m2; j-- > 0;) {
+                if (ac[pre + i]->hash == bc[pre + j]->hash) L[i * w + j] = L[(i + 1) * w + j + 1] + 1;
+                else L[i * w + j] = std::max(L[(i + 1) * w + j], L[i * w + j + 1]);
+            }
+        }
+        for (i = j = ia = ja = 0; i < n2 && j < m2;) {
+            if (ac[pre + i]->hash == bc[pre + j]->hash) {
+                tiny_diff_array_run(d, a, ac, pre + ia, pre + i, b, bc, pre + ja, pre + j, &pos);
+                tiny_diff_array_run(d, a, ac, pre + i, pre + i + 1, b, bc, pre + j, pre + j + 1, &pos);
+                ia = ++i;
+                ja = ++j;
+            }
+            else if (L[(i + 1) * w + j] >= L[i * w + j + 1]) i++;
+            else j++;
+        }
+        tiny_diff_array_run(d, a, ac, pre + ia, pre + n2, b, bc, pre + ja, pre + m2, &pos);
+        tiny_dealloc(L, (n2 + 1) * w * sizeof(unsigned));
+    }
+    else tiny_diff_array_run(d, a, ac, pre, pre + n2, b, bc, pre, pre + m2, &pos);  // 元素过多时按位置比较
+    tiny_diff_array_run(d, a, ac, n - suf, n, b, bc, m - suf, m, &pos);
+    tiny_dealloc(ac, n * sizeof(tiny_diff_info*));
+    tiny_dealloc(bc, m * sizeof(tiny_diff_info*));
 }
 
-const char* tiny_get_string(const tiny_node* node){
-    assert(node != nullptr && node->type == TINY_STRING);
-    return node->s.s;
+static void tiny_diff_value(tiny_diff_context* d, const tiny_node* a, const tiny_diff_info* ai, 
+    const tiny_node* b, const tiny_diff_info* bi) {
+    // 结构哈希相同的子树 (再经 tiny_is_equal 确认) 直接剪枝
+    if (ai->hash == bi->hash && tiny_is_equal(a, b)) return;
+    if (a->type != b->type || (a->type != TINY_ARRAY && a->type != TINY_OBJECT))
+        tiny_diff_emit(d, "replace", b);
+    else if (a->type == TINY_OBJECT)
+        tiny_diff_object(d, a, ai, b, bi);
+    else
+        tiny_diff_array(d, a, ai, b, bi);
 }
 
-size_t tiny_get_string_length(const tiny_node* node){
-    assert(node != nullptr && node->type == TINY_STRING);
-    return node->s.len;
+/// @brief 比较两个文档, 生成把 a 变为 b 的 JSON Patch
+/// @param a 原文档
+/// @param b 目标文档
+/// @param patch 输出的 JSON Patch (操作数组)
+void tiny_diff(const tiny_node* a, const tiny_node* b, tiny_node* patch) {
+    tiny_diff_context d;
+    tiny_diff_info *ai, *bi;
+    size_t an, bn;
+    assert(a != nullptr && b != nullptr && patch != nullptr);
+    ai = (tiny_diff_info*)tiny_malloc((an = tiny_diff_count(a)) * sizeof(tiny_diff_info));
+    bi = (tiny_diff_info*)tiny_malloc((bn = tiny_diff_count(b)) * sizeof(tiny_diff_info));
+    tiny_diff_hash(a, ai);
+    tiny_diff_hash(b, bi);
+    d.path.stack = nullptr;
+    d.path.size = d.path.top = 0;
+    d.path.sink = nullptr;
+    d.path.gather = nullptr;
+    d.patch = patch;
+    tiny_set_array(patch, 0);
+    tiny_diff_value(&d, a, ai, b, bi);
+    tiny_dealloc(d.path.stack, d.path.size);
+    tiny_dealloc(ai, an * sizeof(tiny_diff_info));
+    tiny_dealloc(bi, bn * sizeof(tiny_diff_info));
 }
 
-/// @brief 设置 json 节点中的值为指定字符串
-/// @param node json 节点
-/// @param s 字符串指针
-/// @param len 字符串长度
-void tiny_set_string(tiny_node* node, const char* s, size_t len){
-    // (s != nullptr || len == 0) 的意思是当且仅当 s 指针不为空但 len 不为零时返回 false
-    assert(node != nullptr && (s != nullptr || len == 0));
-    tiny_free(node);
-    node->s.s = (char*)malloc(len + 1);  // 由于要放 '\0' 字符
-    memcpy(node->s.s, s, len);  // 进行字节级别的拷贝
-    node->s.s[len] = '\0';
-    node->s.len = len;
-    node->type = TINY_STRING;
-}
+/// @brief JSONPath 查询中一步的类型
+typedef enum {
+    TINY_PATH_NAME,      // .name 或 ['name']
+    TINY_PATH_WILDCARD,  // .* 或 [*]
+    TINY_PATH_INDEX,     // [n], 负数从末尾数起
+    TINY_PATH_SLICE,     // [start:end:step]
+    TINY_PATH_FILTER,    // [?(expr)]
+} tiny_path_step_type;
 
-/// @brief 将节点类型设置为数组，并提供初始容量
-/// @param node json 节点
-/// @param capacity 数组容量
-void tiny_set_array(tiny_node* node, size_t capacity) {
-    assert(node != nullptr);
-    tiny_free(node);
-    node->type = TINY_ARRAY;
-    node->a.size = 0;
-    node->a.capacity = capacity;
-    node->a.e = capacity > 0 ? (tiny_node*)malloc(capacity * sizeof(tiny_node)) : nullptr;
-}
+// 切片中省略的 start 或 end
+#define TINY_PATH_SLICE_DEFAULT INT64_MIN
 
-/// @brief 获取数组元素个数
-/// @param node 数组（json节点）
-/// @return 数组元素个数
-size_t tiny_get_array_size(const tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    return node->a.size;
+struct tiny_path_step {
+    tiny_path_step_type type;
+    int descendant;              // 由 ".." 引入, 对当前节点及其所有后代应用这一步
+    char* key; size_t klen;      // NAME
+    int64_t start, end, step;    // INDEX 只使用 start
+    size_t expr;                 // FILTER 表达式的根节点在 exprs 中的下标
+};
+
+/// @brief 过滤表达式节点的类型
+typedef enum {
+    TINY_PATH_OR, TINY_PATH_AND, TINY_PATH_NOT,
+    TINY_PATH_EQ, TINY_PATH_NE, TINY_PATH_LT, TINY_PATH_LE, TINY_PATH_GT, TINY_PATH_GE,
+    TINY_PATH_EXISTS,   // 单独出现的路径, 存在即为真
+    TINY_PATH_CURRENT,  // @ 开头的单值路径
+    TINY_PATH_ROOT,     // $ 开头的单值路径
+    TINY_PATH_LITERAL,  // 数字、字符串、true、false 或 null
+} tiny_path_expr_type;
+
+struct tiny_path_expr {
+    tiny_path_expr_type type;
+    size_t lhs, rhs;     // 逻辑运算和比较的操作数下标, NOT 和 EXISTS 只使用 lhs
+    tiny_node value;     // LITERAL
+    tiny_pointer path;   // CURRENT 和 ROOT, 数组下标 token 的 s 为 nullptr
+};
+
+/// @brief 编译 JSONPath 时的状态
+typedef struct {
+    const char* p;
+    const char* end;
+    tiny_path* path;
+    tiny_context buf;  // 把字面量改写为以 '\0' 结尾的 JSON 文本后交给 tiny_parse
+} tiny_path_compiler;
+
+/// @brief 数组满时按 2 倍扩容
+/// @return 扩容后的数组
+static void* tiny_path_grow(void* p, size_t* capacity, size_t size, size_t elem) {
+    size_t n;
+    if (size < *capacity) return p;
+    n = *capacity == 0 ? 4 : *capacity * 2;
+    p = tiny_realloc(p, *capacity * elem, n * elem);
+    *capacity = n;
+    return p;
 }
 
-size_t tiny_get_array_capacity(const tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    return node->a.capacity;
+static void tiny_path_skip(tiny_path_compiler* pc) {
+    while (pc->p < pc->end && (*pc->p == ' ' || *pc->p == '\t' || *pc->p == '\n' || *pc->p == '\r')) pc->p++;
 }
 
-/// @brief 增大数组容量
-/// @param node json 节点
-/// @param capacity 数组容量
-void tiny_reserve_array(tiny_node* node, size_t capacity) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    if (node->a.capacity < capacity) {
-        node->a.capacity = capacity;
-        node->a.e = (tiny_node*)realloc(node->a.e, capacity * sizeof(tiny_node));
+/// @brief 当前字符是否为 ch, 是的话跳过
+static int tiny_path_accept(tiny_path_compiler* pc, char ch) {
+    if (pc->p < pc->end && *pc->p == ch) {
+        pc->p++;
+        return 1;
     }
+    return 0;
 }
 
-/// @brief 缩小数组容量至当前元素个数大小
-/// @param node json 节点
-void tiny_shrink_array(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    if (node->a.capacity > node->a.size) {
-        node->a.capacity = node->a.size;
-        node->a.e = (tiny_node*)realloc(node->a.e, node->a.capacity * sizeof(tiny_node));
+/// @brief 点号后面的成员名: 字母、数字、下划线和非 ASCII 字符, 不能以数字开头
+static int tiny_path_name(tiny_path_compiler* pc, char** s, size_t* len) {
+    const char* begin = pc->p;
+    while (pc->p < pc->end) {
+        unsigned char ch = (unsigned char)*pc->p;
+        if (ch >= 0x80 || ch == '_' || ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'z') || (pc->p > begin && ISDIGIT(ch))) pc->p++;
+        else break;
     }
+    if (pc->p == begin) return TINY_PATH_INVALID_EXPRESSION;
+    *len = pc->p - begin;
+    *s = (char*)tiny_malloc(*len + 1);
+    memcpy(*s, begin, *len);
+    (*s)[*len] = '\0';
+    return TINY_PATH_OK;
 }
 
-/// @brief 清空数组
-/// @param node json 节点
-void tiny_clear_array(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    tiny_erase_array_element(node, 0, node->a.size);
+/// @brief 解析字面量; 单引号字符串先改写为双引号的 JSON 字符串
+static int tiny_path_literal(tiny_path_compiler* pc, tiny_node* out) {
+    tiny_context* c = &pc->buf;
+    const char* p = pc->p;
+    c->top = 0;
+    tiny_init(out);
+    if (p < pc->end && (*p == '\'' || *p == '"')) {
+        char quote = *p++;
+        PUTC(c, '"');
+        for (; p < pc->end && *p != quote; p++) {
+            if (*p == '\\' && p + 1 < pc->end) {
+                if (p[1] != quote || quote == '"') PUTC(c, '\\');
+                PUTC(c, *++p);
+            }
+            else if (*p == '"') PUTS(c, "\\\"", 2);
+            else PUTC(c, *p);
+        }
+        if (p++ == pc->end) return TINY_PATH_INVALID_EXPRESSION;
+        PUTC(c, '"');
+    }
+    else {
+        for (; p < pc->end && (ISDIGIT(*p) || *p == '-' || *p == '+' || *p == '.' || ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'z')); p++)
+            PUTC(c, *p);
+    }
+    PUTC(c, '\0');
+    if (p == pc->p || tiny_parse(out, c->stack) != TINY_PARSE_OK) return TINY_PATH_INVALID_EXPRESSION;
+    pc->p = p;
+    return TINY_PATH_OK;
 }
 
-/// @brief 获取数组元素
-/// @param node 数组（json节点）
-/// @param index 下标
-/// @return 对应下表数组元素
-tiny_node* tiny_get_array_element(const tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    assert(index < node->a.size);
-    return &node->a.e[index];
+/// @brief 解析可选的整数, 没有数字时返回 0
+static int tiny_path_int(tiny_path_compiler* pc, int64_t* out) {
+    const char* p = pc->p;
+    uint64_t u = 0;
+    int neg = p < pc->end && *p == '-';
+    if (neg) p++;
+    if (p == pc->end || !ISDIGIT(*p)) return 0;
+    for (; p < pc->end && ISDIGIT(*p); p++) {
+        if (u > ((uint64_t)INT64_MAX - (*p - '0')) / 10) return 0;
+        u = u * 10 + (*p - '0');
+    }
+    *out = neg ? -(int64_t)u : (int64_t)u;
+    pc->p = p;
+    return 1;
 }
 
-tiny_node* tiny_pushback_array_element(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY);
-    if (node->a.size == node->a.capacity) 
-        tiny_reserve_array(node, node->a.capacity == 0 ? 1 : node->a.capacity * 2);
-    tiny_init(&node->a.e[node->a.size]);
-    return &node->a.e[node->a.size++];  // 此处顺带改变了 array 中 size 的大小
+/// @brief 过滤表达式中 @ 或 $ 之后的单值路径, 只允许成员名和非负下标
+static int tiny_path_singular(tiny_path_compiler* pc, tiny_pointer* ptr) {
+    tiny_pointer_token t;
+    tiny_node key;
+    int64_t index;
+    for (;;) {
+        t.s = nullptr;
+        t.len = 0;
+        t.index = TINY_KEY_NOT_EXIST;
+        if (tiny_path_accept(pc, '.')) {
+            if (tiny_path_name(pc, &t.s, &t.len) != TINY_PATH_OK) return TINY_PATH_INVALID_EXPRESSION;
+        }
+        else if (tiny_path_accept(pc, '[')) {
+            tiny_path_skip(pc);
+            if (tiny_path_int(pc, &index)) {
+                if (index < 0) return TINY_PATH_INVALID_EXPRESSION;
+                t.index = (size_t)index;
+            }
+            else {
+                if (tiny_path_literal(pc, &key) != TINY_PATH_OK || key.type != TINY_STRING) {
+                    tiny_free(&key);
+                    return TINY_PATH_INVALID_EXPRESSION;
+                }
+                t.s = key.s.s;  // 接管字符串
+                t.len = key.s.len;
+            }
+            tiny_path_skip(pc);
+            if (!tiny_path_accept(pc, ']')) {
+                tiny_dealloc(t.s, t.len + 1);
+                return TINY_PATH_INVALID_EXPRESSION;
+            }
+        }
+        else return TINY_PATH_OK;
+        ptr->t = (tiny_pointer_token*)tiny_path_grow(ptr->t, &ptr->capacity, ptr->size, sizeof(tiny_pointer_token));
+        ptr->t[ptr->size++] = t;
+    }
 }
 
-void tiny_popback_array_element(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_ARRAY && node->a.size > 0);
-    tiny_free(&node->a.e[--node->a.size]);  // 此处顺带改变了 array 中 size 的大小
+/// @brief 在 exprs 末尾添加一个表达式节点
+/// @return 新节点的下标
+static size_t tiny_path_expr_new(tiny_path* path, tiny_path_expr_type type, size_t lhs, size_t rhs) {
+    tiny_path_expr* e;
+    path->exprs = (tiny_path_expr*)tiny_path_grow(path->exprs, &path->expr_capacity, path->expr_size, sizeof(tiny_path_expr));
+    e = &path->exprs[path->expr_size];
+    e->type = type;
+    e->lhs = lhs;
+    e->rhs = rhs;
+    tiny_init(&e->value);
+    e->path.t = nullptr;
+    e->path.size = e->path.capacity = 0;
+    return path->expr_size++;
 }
 
-/// @brief 在数组的第 index 个腾出位置
-/// @param node json 节点
-/// @param index 插入下标
-/// @return 插入位置的节点指针
-tiny_node* tiny_insert_array_element(tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_ARRAY && index <= node->a.size);
-    size_t i, size;
-    tiny_node e;  // 注意初始化两个指针在各自前面都要加 * 
-    tiny_init(&e);
-    tiny_move(tiny_pushback_array_element(node), &e);
-    size = node->a.size;
-    for (i = 0; i < node->a.size - index - 1; i++) {
-        tiny_swap(&node->a.e[size - 1 - i], &node->a.e[size - 2 - i]);
+static int tiny_path_or(tiny_path_compiler* pc, size_t* out);  // forward declare
+
+/// @brief 比较运算的操作数: 单值路径或字面量
+static int tiny_path_operand(tiny_path_compiler* pc, size_t* out) {
+    tiny_path* path = pc->path;
+    tiny_pointer ptr = { nullptr, 0, 0 };
+    tiny_node value;
+    int ret;
+    if (pc->p < pc->end && (*pc->p == '@' || *pc->p == '$')) {
+        tiny_path_expr_type type = *pc->p++ == '@' ? TINY_PATH_CURRENT : TINY_PATH_ROOT;
+        if ((ret = tiny_path_singular(pc, &ptr)) != TINY_PATH_OK) {
+            tiny_pointer_free(&ptr);
+            return ret;
+        }
+        *out = tiny_path_expr_new(path, type, 0, 0);
+        path->exprs[*out].path = ptr;
+        return TINY_PATH_OK;
     }
-    return &node->a.e[index];
+    if ((ret = tiny_path_literal(pc, &value)) != TINY_PATH_OK) {
+        tiny_free(&value);
+        return ret;
+    }
+    *out = tiny_path_expr_new(path, TINY_PATH_LITERAL, 0, 0);
+    path->exprs[*out].value = value;
+    return TINY_PATH_OK;
 }
 
-void tiny_erase_array_element(tiny_node* node, size_t index, size_t count) {
-    assert(node != nullptr && node->type == TINY_ARRAY && index <= node->a.size);
-    size_t i, num = std::max((size_t)0, node->a.size - index - count);
-    for (i = 0; i < num; i++) {
-        tiny_swap(&node->a.e[index + i], &node->a.e[index + count + i]);
+/// @brief 取反、括号、比较或单独的路径 (存在性测试)
+static int tiny_path_unary(tiny_path_compiler* pc, size_t* out) {
+    static const struct { const char* op; tiny_path_expr_type type; } ops[] = {
+        { "==", TINY_PATH_EQ }, { "!=", TINY_PATH_NE }, { "<=", TINY_PATH_LE },
+        { ">=", TINY_PATH_GE }, { "<", TINY_PATH_LT }, { ">", TINY_PATH_GT },
+    };
+    size_t lhs, rhs, i, n;
+    int ret;
+    tiny_path_skip(pc);
+    if (tiny_path_accept(pc, '!')) {
+        if ((ret = tiny_path_unary(pc, &lhs)) != TINY_PATH_OK) return ret;
+        *out = tiny_path_expr_new(pc->path, TINY_PATH_NOT, lhs, 0);
+        return TINY_PATH_OK;
     }
-    for (i = index + num; i < node->a.size; i++) {
-        tiny_free(&node->a.e[i]);
+    if (tiny_path_accept(pc, '(')) {
+        if ((ret = tiny_path_or(pc, out)) != TINY_PATH_OK) return ret;
+        tiny_path_skip(pc);
+        return tiny_path_accept(pc, ')') ? TINY_PATH_OK : TINY_PATH_INVALID_EXPRESSION;
     }
-    node->a.size = index + num;
+    if ((ret = tiny_path_operand(pc, &lhs)) != TINY_PATH_OK) return ret;
+    tiny_path_skip(pc);
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        n = strlen(ops[i].op);
+        if ((size_t)(pc->end - pc->p) >= n && memcmp(pc->p, ops[i].op, n) == 0) {
+            pc->p += n;
+            tiny_path_skip(pc);
+            if ((ret = tiny_path_operand(pc, &rhs)) != TINY_PATH_OK) return ret;
+            *out = tiny_path_expr_new(pc->path, ops[i].type, lhs, rhs);
+            return TINY_PATH_OK;
+        }
+    }
+    if (pc->path->exprs[lhs].type == TINY_PATH_LITERAL) return TINY_PATH_INVALID_EXPRESSION;
+    *out = tiny_path_expr_new(pc->path, TINY_PATH_EXISTS, lhs, 0);
+    return TINY_PATH_OK;
 }
 
-/// @brief 将节点类型设置为对象, 并提供初始容量
-/// @param node json 节点
-/// @param capacity 初始容量
-void tiny_set_object(tiny_node* node, size_t capacity) {
-    assert(node != nullptr);
-    tiny_free(node);
-    node->type = TINY_OBJECT;
-    node->o.size = 0;
-    node->o.capacity = capacity;
-    node->o.m = capacity > 0 ? (tiny_member*)malloc(capacity * sizeof(tiny_member)) : NULL;
+static int tiny_path_and(tiny_path_compiler* pc, size_t* out) {
+    size_t rhs;
+    int ret;
+    if ((ret = tiny_path_unary(pc, out)) != TINY_PATH_OK) return ret;
+    for (;;) {
+        tiny_path_skip(pc);
+        if (pc->end - pc->p < 2 || memcmp(pc->p, "&&", 2) != 0) return TINY_PATH_OK;
+        pc->p += 2;
+        if ((ret = tiny_path_unary(pc, &rhs)) != TINY_PATH_OK) return ret;
+        *out = tiny_path_expr_new(pc->path, TINY_PATH_AND, *out, rhs);
+    }
 }
 
-size_t tiny_get_object_size(const tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    return node->o.size;
+/// @brief 过滤表达式, 优先级从低到高为 ||、&&、!、比较
+static int tiny_path_or(tiny_path_compiler* pc, size_t* out) {
+    size_t rhs;
+    int ret;
+    if ((ret = tiny_path_and(pc, out)) != TINY_PATH_OK) return ret;
+    for (;;) {
+        tiny_path_skip(pc);
+        if (pc->end - pc->p < 2 || memcmp(pc->p, "||", 2) != 0) return TINY_PATH_OK;
+        pc->p += 2;
+        if ((ret = tiny_path_and(pc, &rhs)) != TINY_PATH_OK) return ret;
+        *out = tiny_path_expr_new(pc->path, TINY_PATH_OR, *out, rhs);
+    }
 }
 
-size_t tiny_get_object_capacity(const tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    return node->o.capacity;
+/// @brief 方括号中的选择器: *、'name'、下标、切片或 ?过滤表达式
+static int tiny_path_bracket(tiny_path_compiler* pc, tiny_path_step* step) {
+    tiny_node key;
+    int ret;
+    tiny_path_skip(pc);
+    if (tiny_path_accept(pc, '*')) step->type = TINY_PATH_WILDCARD;
+    else if (tiny_path_accept(pc, '?')) {
+        step->type = TINY_PATH_FILTER;
+        if ((ret = tiny_path_or(pc, &step->expr)) != TINY_PATH_OK) return ret;
+    }
+    else if (pc->p < pc->end && (*pc->p == '\'' || *pc->p == '"')) {
+        if (tiny_path_literal(pc, &key) != TINY_PATH_OK) {
+            tiny_free(&key);
+            return TINY_PATH_INVALID_EXPRESSION;
+        }
+        step->type = TINY_PATH_NAME;
+        step->key = key.s.s;  // 接管字符串
+        step->klen = key.s.len;
+    }
+    else {
+        int has_start = tiny_path_int(pc, &step->start);
+        tiny_path_skip(pc);
+        if (tiny_path_accept(pc, ':')) {
+            step->type = TINY_PATH_SLICE;
+            if (!has_start) step->start = TINY_PATH_SLICE_DEFAULT;
+            tiny_path_skip(pc);
+            if (!tiny_path_int(pc, &step->end)) step->end = TINY_PATH_SLICE_DEFAULT;
+            tiny_path_skip(pc);
+            if (tiny_path_accept(pc, ':')) {
+                tiny_path_skip(pc);
+                if (!tiny_path_int(pc, &step->step)) step->step = 1;
+            }
+        }
+        else if (has_start) step->type = TINY_PATH_INDEX;
+        else return TINY_PATH_INVALID_EXPRESSION;
+    }
+    tiny_path_skip(pc);
+    return tiny_path_accept(pc, ']') ? TINY_PATH_OK : TINY_PATH_INVALID_EXPRESSION;
 }
 
-void tiny_reserve_object(tiny_node* node, size_t capacity) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    if (node->o.capacity < capacity) {
-        node->o.capacity = capacity;
-        node->o.m = (tiny_member*)realloc(node->o.m, capacity * sizeof(tiny_member));
+/// @brief 编译 JSONPath 查询, 支持成员名、通配符、递归下降 (..)、下标、切片和过滤表达式
+/// 过滤表达式中的路径只能是单值路径 (成员名和非负下标), 不支持并集 ([a,b]) 和函数
+/// @param path 编译结果, 用 tiny_path_free 释放
+/// @param expr 查询表达式, 以 $ 开头
+/// @param len 表达式长度
+/// @return TINY_PATH_OK 或 TINY_PATH_INVALID_EXPRESSION
+int tiny_path_compile(tiny_path* path, const char* expr, size_t len) {
+    tiny_path_compiler pc;
+    tiny_path_step* step;
+    int ret = TINY_PATH_OK;
+    assert(path != nullptr && (expr != nullptr || len == 0));
+    path->steps = nullptr;
+    path->size = path->capacity = 0;
+    path->exprs = nullptr;
+    path->expr_size = path->expr_capacity = 0;
+    pc.p = expr;
+    pc.end = expr + len;
+    pc.path = path;
+    pc.buf.stack = nullptr;
+    pc.buf.size = pc.buf.top = 0;
+    pc.buf.sink = nullptr;
+    pc.buf.gather = nullptr;
+    tiny_path_skip(&pc);
+    if (!tiny_path_accept(&pc, '$')) ret = TINY_PATH_INVALID_EXPRESSION;
+    while (ret == TINY_PATH_OK && pc.p < pc.end) {
+        path->steps = (tiny_path_step*)tiny_path_grow(path->steps, &path->capacity, path->size, sizeof(tiny_path_step));
+        step = &path->steps[path->size++];
+        step->descendant = 0;
+        step->key = nullptr;
+        step->klen = 0;
+        step->step = 1;
+        if (tiny_path_accept(&pc, '.')) {
+            if (tiny_path_accept(&pc, '.')) step->descendant = 1;
+            if (tiny_path_accept(&pc, '*')) step->type = TINY_PATH_WILDCARD;
+            else if (step->descendant && tiny_path_accept(&pc, '[')) ret = tiny_path_bracket(&pc, step);
+            else {
+                step->type = TINY_PATH_NAME;
+                ret = tiny_path_name(&pc, &step->key, &step->klen);
+            }
+        }
+        else if (tiny_path_accept(&pc, '[')) ret = tiny_path_bracket(&pc, step);
+        else if (tiny_path_skip(&pc), pc.p < pc.end) ret = TINY_PATH_INVALID_EXPRESSION;
+        else path->size--;  // 结尾的空白
     }
+    tiny_dealloc(pc.buf.stack, pc.buf.size);
+    if (ret != TINY_PATH_OK) tiny_path_free(path);
+    return ret;
 }
 
-void tiny_shrink_object(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    if (node->o.capacity > node->o.size) {
-        node->o.capacity = node->o.size;
-        node->o.m = (tiny_member*)realloc(node->o.m, node->o.capacity * sizeof(tiny_member));
+void tiny_path_free(tiny_path* path) {
+    size_t i;
+    assert(path != nullptr);
+    for (i = 0; i < path->size; i++) tiny_dealloc(path->steps[i].key, path->steps[i].klen + 1);
+    for (i = 0; i < path->expr_size; i++) {
+        tiny_free(&path->exprs[i].value);
+        tiny_pointer_free(&path->exprs[i].path);
     }
+    tiny_dealloc(path->steps, path->capacity * sizeof(tiny_path_step));
+    tiny_dealloc(path->exprs, path->expr_capacity * sizeof(tiny_path_expr));
+    path->steps = nullptr;
+    path->exprs = nullptr;
+    path->size = path->capacity = path->expr_size = path->expr_capacity = 0;
 }
 
-void tiny_clear_object(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    size_t i;
-    tiny_member *curm;
-    for (i = 0; i < node->o.size; i++) {
-        curm = &node->o.m[i];
-        free(curm->key);
-        tiny_free(&curm->value);
+void tiny_path_result_free(tiny_path_result* result) {
+    assert(result != nullptr);
+    tiny_dealloc(result->nodes, result->capacity * sizeof(tiny_node*));
+    result->nodes = nullptr;
+    result->size = result->capacity = 0;
+}
+
+/// @brief 过滤表达式中单值路径的求值, 不存在时返回 nullptr
+static const tiny_node* tiny_path_resolve(const tiny_node* node, const tiny_pointer* ptr) {
+    size_t i, index;
+    for (i = 0; i < ptr->size; i++) {
+        const tiny_pointer_token* t = &ptr->t[i];
+        if (t->s != nullptr) {
+            if (node->type != TINY_OBJECT || (index = tiny_find_object_index(node, t->s, t->len)) == TINY_KEY_NOT_EXIST) return nullptr;
+            node = &node->o.m[index].value;
+        }
+        else if (node->type == TINY_ARRAY && t->index < node->a.size) node = &node->a.e[t->index];
+        else if (node->type == TINY_NUMBER_ARRAY && t->index < node->v.size) node = &tiny_packed_views(node)[t->index];
+        else return nullptr;
     }
-    node->o.size = 0;
+    return node;
 }
 
-const char* tiny_get_object_key(const tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    assert(index < node->o.size);
-    return node->o.m[index].key;
+static const tiny_node* tiny_path_value(const tiny_path* path, size_t i, const tiny_node* cur, const tiny_node* root) {
+    const tiny_path_expr* e = &path->exprs[i];
+    if (e->type == TINY_PATH_LITERAL) return &e->value;
+    return tiny_path_resolve(e->type == TINY_PATH_CURRENT ? cur : root, &e->path);
 }
 
-size_t tiny_get_object_key_length(const tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    assert(index < node->o.size);
-    return node->o.m[index].keylen;
+/// @brief 比较两个值; 不存在的值只与不存在的值相等, 大小比较只用于两个数字或两个字符串
+static int tiny_path_compare(tiny_path_expr_type op, const tiny_node* a, const tiny_node* b) {
+    int eq, lt = 0;
+    if (a == nullptr || b == nullptr) eq = a == b;
+    else {
+        eq = tiny_is_equal(a, b);
+        if ((a->type == TINY_NUMBER || a->type == TINY_DECIMAL) && (b->type == TINY_NUMBER || b->type == TINY_DECIMAL))
+            lt = tiny_number_value(a) < tiny_number_value(b);
+        else if (a->type == TINY_STRING && b->type == TINY_STRING) {
+            int r = memcmp(a->s.s, b->s.s, a->s.len < b->s.len ? a->s.len : b->s.len);
+            lt = r < 0 || (r == 0 && a->s.len < b->s.len);
+        }
+        else if (op != TINY_PATH_EQ && op != TINY_PATH_NE)
+            return (op == TINY_PATH_LE || op == TINY_PATH_GE) && eq;
+    }
+    switch (op) {
+        case TINY_PATH_EQ: return eq;
+        case TINY_PATH_NE: return !eq;
+        case TINY_PATH_LT: return lt;
+        case TINY_PATH_LE: return lt || eq;
+        case TINY_PATH_GT: return !lt && !eq && a != nullptr && b != nullptr;
+        default: return !lt && (eq || (a != nullptr && b != nullptr));
+    }
 }
 
-tiny_node* tiny_get_object_value(const tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    assert(index < node->o.size);
-    return &node->o.m[index].value;
+/// @brief 对候选节点 cur 求过滤表达式 i 的值
+static int tiny_path_test(const tiny_path* path, size_t i, const tiny_node* cur, const tiny_node* root) {
+    const tiny_path_expr* e = &path->exprs[i];
+    switch (e->type) {
+        case TINY_PATH_OR: return tiny_path_test(path, e->lhs, cur, root) || tiny_path_test(path, e->rhs, cur, root);
+        case TINY_PATH_AND: return tiny_path_test(path, e->lhs, cur, root) && tiny_path_test(path, e->rhs, cur, root);
+        case TINY_PATH_NOT: return !tiny_path_test(path, e->lhs, cur, root);
+        case TINY_PATH_EXISTS: return tiny_path_value(path, e->lhs, cur, root) != nullptr;
+        default:
+            return tiny_path_compare(e->type, tiny_path_value(path, e->lhs, cur, root), tiny_path_value(path, e->rhs, cur, root));
+    }
 }
 
-/// @brief 找到 json 中指定 key 的 object 节点下标
-/// @param node json 节点
-/// @param key 给定 key
-/// @param klen key 长度
-/// @return 找到的节点下标, 没找到的话返回 size_t - 1
-size_t tiny_find_object_index(const tiny_node* node, const char* key, size_t klen) {
-    size_t i;
-    assert(node != nullptr && node->type == TINY_OBJECT && key != nullptr);
-    for (i = 0; i < node->o.size; i++) {
-        if (node->o.m[i].keylen == klen && memcmp(node->o.m[i].key, key, klen) == 0)
-            return i;
+/// @brief 容器的子节点个数, 标量为 0
+static size_t tiny_path_child_count(const tiny_node* node) {
+    switch (node->type) {
+        case TINY_ARRAY:        return node->a.size;
+        case TINY_OBJECT:       return node->o.size;
+        case TINY_NUMBER_ARRAY: return node->v.size;
+        default:                return 0;
     }
-    return TINY_KEY_NOT_EXIST;
 }
 
-/// @brief 在 json 节点中找到对应 key 值 object 的 value
-/// @param node json 节点
-/// @param key 给定 key
-/// @param klen key 长度
-/// @return object.value
-tiny_node* tiny_find_object_value(tiny_node* node, const char* key, size_t klen) {
-    size_t index = tiny_find_object_index(node, key, klen);
-    return index != TINY_KEY_NOT_EXIST ? &node->o.m[index].value : nullptr;
+/// @brief 第 i 个子节点, 紧凑数组返回只读的元素视图
+static tiny_node* tiny_path_child(tiny_node* node, size_t i) {
+    switch (node->type) {
+        case TINY_ARRAY:  return &node->a.e[i];
+        case TINY_OBJECT: return &node->o.m[i].value;
+        default:          return &tiny_packed_views(node)[i];
+    }
 }
 
-tiny_member* tiny_pushback_object_member(tiny_node* node) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    if (node->o.size == node->o.capacity) 
-        tiny_reserve_object(node, node->o.capacity == 0 ? 1 : node->o.capacity * 2);
-    tiny_init(&node->o.m[node->o.size].value);
-    return &node->o.m[node->o.size++];  // 此处顺带改变了 array 中 size 的大小
+static void tiny_path_apply(const tiny_path* path, size_t k, tiny_node* node, const tiny_node* root, tiny_path_result* result);
+
+/// @brief 从第 k 步开始匹配 node, 走完所有步骤的节点加入结果
+static void tiny_path_select(const tiny_path* path, size_t k, tiny_node* node, const tiny_node* root, tiny_path_result* result) {
+    if (k < path->size) {
+        tiny_path_apply(path, k, node, root, result);
+        return;
+    }
+    result->nodes = (tiny_node**)tiny_path_grow(result->nodes, &result->capacity, result->size, sizeof(tiny_node*));
+    result->nodes[result->size++] = node;
 }
 
-/// @brief 为给定 json 节点设置一个 key 为指定值的 object
-/// @param node json 节点
-/// @param key 指定 key
-/// @param klen key 长度
-/// @return 设置的 object.value
-tiny_node* tiny_set_object_key(tiny_node* node, const char* key, size_t klen) {
-    assert(node != nullptr && node->type == TINY_OBJECT);
-    tiny_node* res;
-    tiny_member* m;
-    if ((res = tiny_find_object_value(node, key, klen)) != nullptr) return res;  // 若已存在此键, 则直接返回
-    m = tiny_pushback_object_member(node);
-    memcpy(m->key = (char*)malloc(klen + 1), key, klen);  // 注意 key 一定要先分配空间
-    m->key[klen] = '\0';  // 加上结束符
-    m->keylen = klen;  // keylen 也要赋值！
-    return &m->value;
+/// @brief 对 node 应用第 k 步, 递归下降时再对每个子节点应用同一步
+static void tiny_path_apply(const tiny_path* path, size_t k, tiny_node* node, const tiny_node* root, tiny_path_result* result) {
+    const tiny_path_step* s = &path->steps[k];
+    size_t i, n;
+    int64_t size, lower, upper, j;
+    int array = node->type == TINY_ARRAY || node->type == TINY_NUMBER_ARRAY;
+    n = tiny_path_child_count(node);
+    switch (s->type) {
+        case TINY_PATH_NAME:
+            if (node->type == TINY_OBJECT && (i = tiny_find_object_index(node, s->key, s->klen)) != TINY_KEY_NOT_EXIST)
+                tiny_path_select(path, k + 1, &node->o.m[i].value, root, result);
+            break;
+        case TINY_PATH_WILDCARD:
+            for (i = 0; i < n; i++) tiny_path_select(path, k + 1, tiny_path_child(node, i), root, result);
+            break;
+        case TINY_PATH_INDEX:
+            if (!array) break;
+            j = s->start < 0 ? s->start + (int64_t)n : s->start;
+            if (j >= 0 && j < (int64_t)n) tiny_path_select(path, k + 1, tiny_path_child(node, j), root, result);
+            break;
+        case TINY_PATH_SLICE:
+            // 按 RFC 9535 的规则把 start 和 end 规范化到 [-1, size] 范围内
+            if (!array || s->step == 0) break;
+            size = (int64_t)n;
+            if (s->step > 0) {
+                lower = s->start == TINY_PATH_SLICE_DEFAULT ? 0 : s->start < 0 ? s->start + size : s->start;
+                upper = s->end == TINY_PATH_SLICE_DEFAULT ? size : s->end < 0 ? s->end + size : s->end;
+                lower = lower < 0 ? 0 : lower > size ? size : lower;
+                upper = upper < 0 ? 0 : upper > size ? size : upper;
+                for (j = lower; j < upper; j = s->step < upper - j ? j + s->step : upper) tiny_path_select(path, k + 1, tiny_path_child(node, j), root, result);
+            }
+            else {
+                upper = s->start == TINY_PATH_SLICE_DEFAULT ? size - 1 : s->start < 0 ? s->start + size : s->start;
+                lower = s->end == TINY_PATH_SLICE_DEFAULT ? -1 : s->end < 0 ? s->end + size : s->end;
+                upper = upper < -1 ? -1 : upper > size - 1 ? size - 1 : upper;
+                lower = lower < -1 ? -1 : lower > size - 1 ? size - 1 : lower;
+                for (j = upper; j > lower; j = -s->step < j - lower ? j + s->step : lower) tiny_path_select(path, k + 1, tiny_path_child(node, j), root, result);
+            }
+            break;
+        case TINY_PATH_FILTER:
+            for (i = 0; i < n; i++) {
+                tiny_node* child = tiny_path_child(node, i);
+                if (tiny_path_test(path, s->expr, child, root)) tiny_path_select(path, k + 1, child, root, result);
+            }
+            break;
+    }
+    if (s->descendant) {
+        for (i = 0; i < n; i++) tiny_path_apply(path, k, tiny_path_child(node, i), root, result);
+    }
 }
 
-/// @brief 移除指定下标的对象
-/// @param node json 节点
-/// @param index 指定下标
-void tiny_remove_object(tiny_node* node, size_t index) {
-    assert(node != nullptr && node->type == TINY_OBJECT && index < node->o.size);
-    size_t i, klen;
-    for (i = index; i < node->o.size - 1; i++){
-        klen = node->o.m[i + 1].keylen;
-        memcpy(node->o.m[i].key = (char*)malloc(klen + 1), node->o.m[i + 1].key, klen);
-        node->o.m[i].key[klen] = '\0';
-        node->o.m[i].keylen = klen;
-        tiny_swap(&node->o.m[i].value, &node->o.m[i + 1].value);
-    }
-    free(node->o.m[i].key);
-    tiny_free(&node->o.m[i].value);
-    node->o.size--;
-}
\ No newline at end of file
+/// @brief 在文档上执行编译好的查询, 不修改文档; 紧凑数组的元素与 tiny_get_array_element 一样返回只读视图
+/// 除结果数组和首次访问的紧凑数组的元素视图外不分配内存
+/// @param path 编译好的查询
+/// @param node 文档根节点
+/// @param result 查询结果, 原有内容被清空, 按文档顺序存放匹配的节点
+/// @return 匹配的节点个数
+size_t tiny_path_eval(const tiny_path* path, const tiny_node* node, tiny_path_result* result) {
+    assert(path != nullptr && node != nullptr && result != nullptr);
+    result->size = 0;
+    tiny_path_select(path, 0, const_cast<tiny_node*>(node), node, result);
+    return result->size;
+}
+
+/// @brief 编译并执行一次查询, 反复执行同一查询时应使用 tiny_path_compile 和 tiny_path_eval
+/// @return TINY_PATH_OK 或 TINY_PATH_INVALID_EXPRESSION
+int tiny_path_query(const tiny_node* node, const char* expr, size_t len, tiny_path_result* result) {
+    tiny_path path;
+    int ret;
+    if ((ret = tiny_path_compile(&path, expr, len)) != TINY_PATH_OK) return ret;
+    tiny_path_eval(&path, node, result);
+    tiny_path_free(&path);
+    return TINY_PATH_OK;
+}
@@ -2,14 +2,27 @@
 #define TINYJSON_H__
 
 #include<stddef.h>  /* size_t */
+#include<stdint.h>  /* int64_t */
+#if defined(__cplusplus) && __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define TINY_HAS_PMR 1
+#endif
+#endif
 // size_t 类型表示C中任何对象所能达到的最大长度，它是无符号整数。
 // 在声明诸如字符数或者数组索引这样的长度变量时用size_t 是好的做法。
 
 // 定义 json 中的 7 种数据类型（bool 中的 true 和 false 分开）
+// TINY_NUMBER_ARRAY 是全为数字的数组的紧凑表示, 在 JSON 中就是普通数组
+// TINY_DECIMAL 是按十进制精确保存的数字, 在 JSON 中就是普通数字
 typedef enum { TINY_NULL, TINY_FALSE, TINY_TRUE, TINY_NUMBER, TINY_STRING, 
-    TINY_ARRAY, TINY_OBJECT } tiny_type;
+    TINY_ARRAY, TINY_OBJECT, TINY_NUMBER_ARRAY, TINY_DECIMAL } tiny_type;
+
+/// @brief 紧凑数字数组的元素类型
+typedef enum { TINY_PACKED_NONE, TINY_PACKED_DOUBLE, TINY_PACKED_FLOAT, TINY_PACKED_INT64 } tiny_packed_type;
 
 #define TINY_KEY_NOT_EXIST ((size_t) - 1)
+#define TINY_POINTER_END ((size_t) - 2)  /* JSON Pointer 中的 "-", 即数组最后一个元素之后 */
 
 // 定义 json 中的节点结构 tiny_node，节点中包含 tiny_type 类型的值
 // 教程中名称是 _value，但我总觉得变扭，改用 node
@@ -23,8 +36,11 @@ struct tiny_node {
         struct { tiny_member* m; size_t size, capacity; }o;
         /* 数组中元素的数据类型也为一个json节点，可继续存放数、数字、字符串 */
         struct { tiny_node* e; size_t size, capacity; }a;  /* array:  elements, element count */
-        struct { char* s; size_t len; }s;         /* string: null-terminated string, string length */
+        struct { char* s; size_t len, capacity; }s;  /* string: null-terminated string, string length, 缓冲区字节数; capacity 为 0 时 s 引用输入, 不以 '\0' 结尾 */
+        struct { void* p; size_t size; tiny_packed_type type; }v;  /* number array: elements, element count, element type */
         double n;                                 /* number */
+        struct { double n; char* s; size_t len; }d;  /* number: 值 (即 n), 延迟转换时保留的原文及其长度, 否则 s 为 nullptr */
+        struct { char* s; size_t len; int exp; int neg; }x;  /* decimal: 有效数字 (无前导和末尾的 0), 位数, 十进制指数, 是否为负 */
     };
     tiny_type type;
 };
@@ -32,10 +48,19 @@ struct tiny_node {
 /// @brief 存放 json 对象类型的数据结构, 由 key : value 组成
 struct tiny_member
 {
-    char* key; size_t keylen; /* member key string, key string length */
+    char* key; size_t keylen, keycap; /* member key string, key string length, key 缓冲区字节数 */
+    char* escaped;             /* key 需要转义时缓存的序列化形式 (含引号), 不需要转义时为 nullptr */
     tiny_node value;           /* member value */
 };
 
+/// @brief 十进制数, 值为 (negative ? -1 : 1) * digits * 10^exponent
+/// tiny_get_decimal 给出的 digits 不含前导和末尾的 '0' 且不以 '\0' 结尾, 值为 0 时 len 为 0
+typedef struct {
+    const char* digits; size_t len;  /* 有效数字 '0'~'9' 及其个数 */
+    int exponent;
+    int negative;
+} tiny_decimal;
+
 /// @brief 枚举类型，代表解析状态码
 enum {
     // 赋值了第一个变量为 0，后面的值会依次递增
@@ -53,20 +78,186 @@ enum {
     TINY_PARSE_MISS_KEY,  // 缺少 key
     TINY_PARSE_MISS_COLON,  // 缺少 : 
     TINY_PARSE_MISS_COMMA_OR_CURLY_BRACKET,  // 缺少 , or }
+    TINY_PARSE_INVALID_UTF8,  // 字符串中有不合法的 UTF-8 序列, 只在 TINY_PARSE_STRICT_UTF8 时检查
+};
+
+/// @brief JSON Pointer (RFC 6901) 中的一个 reference token
+typedef struct {
+    char* s; size_t len;  /* 已反转义的 token, token 长度 */
+    size_t index;         /* 预解析的数组下标, 不是合法下标时为 TINY_KEY_NOT_EXIST */
+} tiny_pointer_token;
+
+/// @brief 预先切分好的 JSON Pointer
+typedef struct { tiny_pointer_token* t; size_t size, capacity; } tiny_pointer;
+
+typedef struct tiny_projection_node tiny_projection_node;  // 前缀树的节点, 定义仅在 tinyjson.cpp 中
+
+/// @brief 解析时要保留的字段, 由一组 JSON Pointer 合并成的前缀树, 下标 0 为根节点
+typedef struct { tiny_projection_node* nodes; size_t size, capacity; } tiny_projection;
+
+/// @brief JSON Patch (RFC 6902) 的操作类型
+typedef enum { TINY_PATCH_ADD, TINY_PATCH_REMOVE, TINY_PATCH_REPLACE, 
+    TINY_PATCH_MOVE, TINY_PATCH_COPY, TINY_PATCH_TEST } tiny_patch_op_type;
+
+/// @brief 编译后的单个 patch 操作
+typedef struct {
+    tiny_patch_op_type op;
+    tiny_pointer path, from;  /* from 只用于 move 和 copy */
+    tiny_node value;          /* value 只用于 add、replace 和 test */
+} tiny_patch_op;
+
+/// @brief 编译后的 JSON Patch, 可反复应用于多个文档
+typedef struct { tiny_patch_op* ops; size_t size, capacity; } tiny_patch;
+
+/// @brief JSON Patch 的编译和应用状态码, tiny_pointer_compile 和 tiny_projection_compile 也返回其中的 OK 与 INVALID_POINTER
+enum {
+    TINY_PATCH_OK = 0,  // 成功
+    TINY_PATCH_INVALID_OPERATION,  // patch 文档格式错误
+    TINY_PATCH_INVALID_POINTER,  // 非法的 JSON Pointer
+    TINY_PATCH_PATH_NOT_FOUND,  // 路径在文档中不存在
+    TINY_PATCH_TEST_FAILED,  // test 操作比较失败
+};
+
+typedef struct tiny_path_step tiny_path_step;  // 查询中的一步, 定义仅在 tinyjson.cpp 中
+typedef struct tiny_path_expr tiny_path_expr;  // 过滤表达式的节点, 定义仅在 tinyjson.cpp 中
+
+/// @brief 编译后的 JSONPath 查询, 可反复用于多个文档
+typedef struct {
+    tiny_path_step* steps; size_t size, capacity;
+    tiny_path_expr* exprs; size_t expr_size, expr_capacity;  /* 所有过滤表达式的节点, 按下标互相引用 */
+} tiny_path;
+
+/// @brief JSONPath 的查询结果, 保存指向文档中节点的指针而不是副本
+/// 初始化为全 0, 可在多次查询之间复用, 用 tiny_path_result_free 释放
+typedef struct { tiny_node** nodes; size_t size, capacity; } tiny_path_result;
+
+/// @brief JSONPath 的编译状态码
+enum {
+    TINY_PATH_OK = 0,  // 成功
+    TINY_PATH_INVALID_EXPRESSION,  // 查询表达式格式错误或使用了不支持的语法
+};
+
+/// @brief 可替换的内存分配器, 释放和调整大小时会传入原来分配的大小
+/// 分配器不会收到大小为 0 的请求, 也不会收到空指针
+typedef struct {
+    void* (*malloc_fn)(size_t size, void* user);
+    void* (*realloc_fn)(void* p, size_t old_size, size_t new_size, void* user);
+    void  (*free_fn)(void* p, size_t size, void* user);
+    void* user;  /* 原样传给上面三个函数 */
+} tiny_allocator;
+
+/// @brief 解析选项中的标志
+enum {
+    TINY_PARSE_STRICT_UTF8 = 1 << 0,  // 检查字符串是否为合法的 UTF-8, 并拒绝 \u 转义出的单独低代理项
+    TINY_PARSE_TRUSTED     = 1 << 1,  // 输入可信 (如自己生成的文档), 跳过语法检查, 只保证不越过输入结尾; 忽略 TINY_PARSE_STRICT_UTF8
+    TINY_PARSE_LAZY_NUMBER = 1 << 2,  // 数字保留原文, 首次 tiny_get_number 时才转换; 未修改的数字按原文输出, 超出 double 范围也不报错
+    TINY_PARSE_DECIMAL     = 1 << 3,  // 数字解析为 TINY_DECIMAL, 精确保留所有有效数字, 不调用 strtod; 优先于 TINY_PARSE_LAZY_NUMBER
+    TINY_PARSE_BORROW_STRINGS = 1 << 4,  // 不含转义的字符串值直接引用输入而不复制, 调用者保证输入在文档释放之前有效; key 仍会复制
 };
 
+/// @brief 解析选项
+typedef struct {
+    const tiny_allocator* allocator;  /* 本次解析使用的分配器, nullptr 表示当前线程的分配器 */
+    tiny_packed_type packed;          /* 全为数字的非空数组解析为 TINY_NUMBER_ARRAY 时的元素类型, 默认不打包 */
+    unsigned flags;                   /* TINY_PARSE_STRICT_UTF8 等标志的组合 */
+} tiny_parse_options;
+
+/// @brief 流式输出的接收器, write 返回 0 表示成功, 返回非 0 时中止输出
+typedef struct {
+    int (*write)(const char* data, size_t len, void* user);
+    void* user;  /* 原样传给 write */
+} tiny_sink;
+
+/// @brief 调用方持有的输出缓冲区, 可在多次 stringify 之间复用; 初始化为全 0, 用 tiny_buffer_free 释放
+typedef struct { char* data; size_t size, capacity; } tiny_buffer;
+
+/// @brief 解析和生成时使用的缓冲栈, 仅供库内部使用; 放在头文件中是为了 tiny_writer 可以定义在调用方的栈上
+typedef struct {
+    const char* json;
+    const tiny_parse_options* options;  // 解析选项, 只在解析时有效
+    const char* end;  // 输入的结尾, 只在解析时有效; 已知时跳过字符串可以按字批量扫描, 未知时为 nullptr
+    tiny_node* reuse;  // tiny_parse_reuse 时与正在解析的值位置相同的旧节点, 其缓冲区可被接管; 只在解析时有效
+    // 栈的相关结构
+    char* stack;
+    size_t size, top;
+    // 流式输出: 不为 nullptr 时, 栈满后先把已有内容交给 sink 而不是扩容
+    const tiny_sink* sink;
+    struct tiny_gather* gather;  // 分散写出时收集的 iovec 列表, 见 tiny_stringify_fd
+    int status;  // sink 返回的第一个错误
+} tiny_context;
+
+/// @brief 不构造 tiny_node 直接生成 JSON 的生成器, 字段仅供库内部使用
+/// 调试版本中会用 assert 检查 start/end 是否配对、对象中 key 与值是否交替出现
+typedef struct {
+    tiny_context c;          /* 输出缓冲区 */
+    tiny_buffer* buffer;     /* 输出到 tiny_buffer 时的目标, 输出到 sink 时为 nullptr */
+    unsigned char* scopes;   /* 每层容器的状态 */
+    size_t depth, capacity;
+    int roots;               /* 已写出的顶层值个数 */
+} tiny_writer;
+
 // 提供 json 节点的初始化宏
 #define tiny_init(node) do { (node)->type = TINY_NULL; } while(0)
 
 int tiny_parse(tiny_node* node, const char* json);
+int tiny_parse_ex(tiny_node* node, const char* json, const tiny_parse_options* options);
+int tiny_validate(const char* json, size_t len, size_t* err_offset);
+int tiny_validate_ex(const char* json, size_t len, size_t* err_offset, const tiny_parse_options* options);
+int tiny_parse_projected(tiny_node* node, const char* json, size_t len, const tiny_projection* proj);
+int tiny_parse_projected_ex(tiny_node* node, const char* json, size_t len, const tiny_projection* proj, const tiny_parse_options* options);
+int tiny_parse_reuse(tiny_node* node, const char* json, size_t len);
+// 路径是 JSON Pointer, 返回 TINY_PATCH_OK 或 TINY_PATCH_INVALID_POINTER
+int tiny_projection_compile(tiny_projection* proj, const char* const* paths, size_t n);
+void tiny_projection_free(tiny_projection* proj);
+// 返回的缓冲区恰好为 *length + 1 个字节, 由当前线程的分配器分配
 char* tiny_stringify(const tiny_node* node, size_t* length);
+size_t tiny_stringify_length(const tiny_node* node);
+char* tiny_stringify_parallel(const tiny_node* node, size_t* length, unsigned threads);
+int tiny_stringify_to(const tiny_node* node, const tiny_sink* sink);
+void tiny_stringify_into(const tiny_node* node, tiny_buffer* buffer);
+void tiny_buffer_free(tiny_buffer* buffer);
+#ifndef _WIN32
+int tiny_stringify_fd(const tiny_node* node, int fd);
+#endif
+
+// 增量 stringify: 缓存各容器上一次的输出, 只重新生成被修改过的容器
+typedef struct tiny_stringify_cache tiny_stringify_cache;
+tiny_stringify_cache* tiny_stringify_cache_create();
+void tiny_stringify_cache_free(tiny_stringify_cache* cache);
+const char* tiny_stringify_cached(tiny_stringify_cache* cache, const tiny_node* node, size_t* length);
+
+void tiny_writer_init(tiny_writer* w, tiny_buffer* buffer);
+void tiny_writer_init_sink(tiny_writer* w, const tiny_sink* sink);
+int tiny_writer_finish(tiny_writer* w);
+void tiny_writer_start_object(tiny_writer* w);
+void tiny_writer_end_object(tiny_writer* w);
+void tiny_writer_start_array(tiny_writer* w);
+void tiny_writer_end_array(tiny_writer* w);
+void tiny_writer_key(tiny_writer* w, const char* key, size_t klen);
+void tiny_writer_null(tiny_writer* w);
+void tiny_writer_boolean(tiny_writer* w, int b);
+void tiny_writer_int(tiny_writer* w, long long i);
+void tiny_writer_double(tiny_writer* w, double d);
+void tiny_writer_string(tiny_writer* w, const char* s, size_t len);
+void tiny_writer_value(tiny_writer* w, const tiny_node* node);
 
 void tiny_copy(tiny_node* node, const tiny_node* src);
 void tiny_move(tiny_node* dst, tiny_node* src);
-void tiny_swap(tiny_node& lhs, tiny_node* rhs);
+void tiny_swap(tiny_node* lhs, tiny_node* rhs);
 
 void tiny_free(tiny_node* node);
 
+// 所有内存都通过当前线程的分配器分配, 一个文档必须在同一个分配器下修改和释放
+const tiny_allocator* tiny_get_allocator();
+const tiny_allocator* tiny_set_allocator(const tiny_allocator* allocator);
+#if TINY_HAS_PMR
+tiny_allocator tiny_make_allocator(std::pmr::memory_resource* resource);
+#endif
+
+// 可选的内存池: 元素、成员、key 和字符串缓冲区按 size class 缓存在各线程中, 释放后可被下一次解析复用
+extern const tiny_allocator tiny_pool_allocator;
+void tiny_pool_trim();
+
 tiny_type tiny_get_type(const tiny_node* node);
 int tiny_is_equal(const tiny_node* lhs, const tiny_node* rhs);
 
@@ -75,14 +266,29 @@ int tiny_is_equal(const tiny_node* lhs, const tiny_node* rhs);
 int tiny_get_boolean(const tiny_node* node);
 void tiny_set_boolean(tiny_node* node, int b);
 
+/// 对 TINY_PARSE_LAZY_NUMBER 解析出的数字, 首次调用时转换并写入节点缓存, 因此不能在多个线程中同时首次读取同一个节点;
+/// tiny_is_equal、tiny_diff 和 tiny_path_eval 等只读函数在本地转换, 不写入节点
 double tiny_get_number(const tiny_node* node);
 void tiny_set_number(tiny_node* node, double n);
 
+// tiny_get_number 也接受 TINY_DECIMAL, 转换为最接近的 double
+void tiny_get_decimal(const tiny_node* node, tiny_decimal* d);
+int tiny_set_decimal(tiny_node* node, const tiny_decimal* d);
+int tiny_get_decimal_scaled(const tiny_node* node, int scale, int64_t* out);
+
+/// 不接受引用输入的字符串 (TINY_PARSE_BORROW_STRINGS, tiny_set_string_view): 只需要内容时用 tiny_get_string_view,
+/// 需要结束符时先用 tiny_own_string 复制为自有字符串; 两者都不修改节点, 可以在多个线程中同时调用
 const char* tiny_get_string(const tiny_node* node);
+const char* tiny_own_string(tiny_node* node);
 size_t tiny_get_string_length(const tiny_node* node);
 void tiny_set_string(tiny_node* node, const char* s, size_t len);
+const char* tiny_get_string_view(const tiny_node* node, size_t* len);
+void tiny_set_string_view(tiny_node* node, const char* s, size_t len);
 
 void tiny_set_array(tiny_node* node, size_t capacity);
+// 下面的数组函数也接受 TINY_NUMBER_ARRAY, 会修改数组的函数先把它原地展开为 TINY_ARRAY
+// tiny_get_array_element 不展开, 返回的是只读的元素视图, 可以在多个线程中同时读取; 视图直到数组被修改或释放前都有效
+// 要修改紧凑数组的元素, 先用会修改数组的函数 (如 tiny_reserve_array) 把它展开
 size_t tiny_get_array_size(const tiny_node* node);
 size_t tiny_get_array_capacity(const tiny_node* node);
 void tiny_reserve_array(tiny_node* node, size_t capacity);
@@ -94,6 +300,14 @@ void tiny_popback_array_element(tiny_node* node);
 tiny_node* tiny_insert_array_element(tiny_node* node, size_t index);
 void tiny_erase_array_element(tiny_node* node, size_t index, size_t count);
 
+tiny_packed_type tiny_get_number_array_type(const tiny_node* node);
+const double* tiny_get_number_array(const tiny_node* node, size_t* len);
+const float* tiny_get_float_array(const tiny_node* node, size_t* len);
+const int64_t* tiny_get_int64_array(const tiny_node* node, size_t* len);
+void tiny_set_number_array(tiny_node* node, const double* n, size_t len);
+void tiny_set_float_array(tiny_node* node, const float* n, size_t len);
+void tiny_set_int64_array(tiny_node* node, const int64_t* n, size_t len);
+
 void tiny_set_object(tiny_node* node, size_t capacity);
 size_t tiny_get_object_size(const tiny_node* node);
 size_t tiny_get_object_capacity(const tiny_node* node);
@@ -108,4 +322,43 @@ tiny_node* tiny_find_object_value(tiny_node* node, const char* key, size_t klen)
 tiny_node* tiny_set_object_key(tiny_node* node, const char* key, size_t klen);
 void tiny_remove_object(tiny_node* node, size_t index);
 
+void tiny_merge_patch(tiny_node* target, tiny_node* patch);
+
+int tiny_pointer_compile(tiny_pointer* ptr, const char* s, size_t len);
+// 只读查找 (tiny_pointer_get, tiny_pointer_get_batch, tiny_path_eval) 不展开紧凑数组, 其元素与 tiny_get_array_element 一样返回只读视图
+tiny_node* tiny_pointer_get(const tiny_node* node, const tiny_pointer* ptr);
+tiny_node* tiny_pointer_set(tiny_node* node, const tiny_pointer* ptr);
+size_t tiny_pointer_get_batch(const tiny_node* node, const tiny_pointer* ptrs, size_t n, tiny_node** out);
+void tiny_pointer_free(tiny_pointer* ptr);
+
+int tiny_patch_compile(tiny_patch* patch, const tiny_node* doc);
+int tiny_patch_apply(const tiny_patch* patch, tiny_node* node);
+void tiny_patch_free(tiny_patch* patch);
+
+void tiny_diff(const tiny_node* a, const tiny_node* b, tiny_node* patch);
+
+int tiny_path_compile(tiny_path* path, const char* expr, size_t len);
+size_t tiny_path_eval(const tiny_path* path, const tiny_node* node, tiny_path_result* result);
+int tiny_path_query(const tiny_node* node, const char* expr, size_t len, tiny_path_result* result);
+void tiny_path_free(tiny_path* path);
+void tiny_path_result_free(tiny_path_result* result);
+
+#ifdef __cplusplus
+/// @brief 在作用域内切换当前线程的分配器, 用于按文档使用不同的分配器
+class tiny_allocator_scope {
+public:
+    explicit tiny_allocator_scope(const tiny_allocator* allocator) : old_(tiny_set_allocator(allocator)) {}
+#if TINY_HAS_PMR
+    explicit tiny_allocator_scope(std::pmr::memory_resource* resource) 
+        : pmr_(tiny_make_allocator(resource)), old_(tiny_set_allocator(&pmr_)) {}
+#endif
+    ~tiny_allocator_scope() { tiny_set_allocator(old_); }
+    tiny_allocator_scope(const tiny_allocator_scope&) = delete;
+    tiny_allocator_scope& operator=(const tiny_allocator_scope&) = delete;
+private:
+    tiny_allocator pmr_ = {};
+    const tiny_allocator* old_;
+};
+#endif
+
 #endif